@@ -0,0 +1,145 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <arch/lib_helpers.h>
+#include <sha256_backend.h>
+
+/*
+ * SHA-256 using the ARMv8 Cryptography Extensions. Register use:
+ *
+ * v0-v15	round constants, four per register
+ * v16-v19	message schedule, four words each
+ * v20		state ABCD
+ * v21		state EFGH
+ * v22		copy of ABCD for sha256h2
+ * v23, v24	state at the start of the block
+ * v25		message words plus round constants
+ */
+
+static const uint32_t sha256_k[64] __attribute__((aligned(16))) = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/* Rounds 4n to 4n + 3 on the message words in register w. */
+#define QUAD(w, n)						\
+	"add v25.4s, v" w ".4s, v" n ".4s\n\t"			\
+	"mov v22.16b, v20.16b\n\t"				\
+	"sha256h q20, q21, v25.4s\n\t"				\
+	"sha256h2 q21, q22, v25.4s\n\t"
+
+/* Turn the words in w0 into the ones four quads ahead. */
+#define SCHED(w0, w1, w2, w3)					\
+	"sha256su0 v" w0 ".4s, v" w1 ".4s\n\t"			\
+	"sha256su1 v" w0 ".4s, v" w2 ".4s, v" w3 ".4s\n\t"
+
+static void ce_transform(uint32_t state[8], const uint8_t *data,
+			 size_t num_blocks)
+{
+	const uint32_t *k = sha256_k;
+
+	if (!num_blocks)
+		return;
+
+	asm volatile (
+		".arch_extension crypto\n\t"
+		"ld1 {v0.4s-v3.4s}, [%[k]], #64\n\t"
+		"ld1 {v4.4s-v7.4s}, [%[k]], #64\n\t"
+		"ld1 {v8.4s-v11.4s}, [%[k]], #64\n\t"
+		"ld1 {v12.4s-v15.4s}, [%[k]]\n\t"
+		"ld1 {v20.4s-v21.4s}, [%[state]]\n\t"
+
+		"1:\n\t"
+		"ld1 {v16.16b-v19.16b}, [%[data]], #64\n\t"
+		"rev32 v16.16b, v16.16b\n\t"
+		"rev32 v17.16b, v17.16b\n\t"
+		"rev32 v18.16b, v18.16b\n\t"
+		"rev32 v19.16b, v19.16b\n\t"
+		"mov v23.16b, v20.16b\n\t"
+		"mov v24.16b, v21.16b\n\t"
+
+		QUAD("16", "0")	SCHED("16", "17", "18", "19")
+		QUAD("17", "1")	SCHED("17", "18", "19", "16")
+		QUAD("18", "2")	SCHED("18", "19", "16", "17")
+		QUAD("19", "3")	SCHED("19", "16", "17", "18")
+		QUAD("16", "4")	SCHED("16", "17", "18", "19")
+		QUAD("17", "5")	SCHED("17", "18", "19", "16")
+		QUAD("18", "6")	SCHED("18", "19", "16", "17")
+		QUAD("19", "7")	SCHED("19", "16", "17", "18")
+		QUAD("16", "8")	SCHED("16", "17", "18", "19")
+		QUAD("17", "9")	SCHED("17", "18", "19", "16")
+		QUAD("18", "10")	SCHED("18", "19", "16", "17")
+		QUAD("19", "11")	SCHED("19", "16", "17", "18")
+		QUAD("16", "12")
+		QUAD("17", "13")
+		QUAD("18", "14")
+		QUAD("19", "15")
+
+		"add v20.4s, v20.4s, v23.4s\n\t"
+		"add v21.4s, v21.4s, v24.4s\n\t"
+		"subs %[blocks], %[blocks], #1\n\t"
+		"b.ne 1b\n\t"
+
+		"st1 {v20.4s-v21.4s}, [%[state]]\n\t"
+		: [data] "+r" (data), [blocks] "+r" (num_blocks), [k] "+r" (k)
+		: [state] "r" (state)
+		: "v0", "v1", "v2", "v3", "v4", "v5", "v6", "v7", "v8", "v9",
+		  "v10", "v11", "v12", "v13", "v14", "v15", "v16", "v17",
+		  "v18", "v19", "v20", "v21", "v22", "v23", "v24", "v25",
+		  "cc", "memory");
+}
+
+/* The transform needs the FP/SIMD registers, which may still be trapped. */
+static int simd_enabled(void)
+{
+	switch (get_current_el()) {
+	case EL3:
+		return !(raw_read_cptr_el3() & CPTR_EL3_TFP_ENABLE);
+	case EL2:
+		/* CPTR_EL2.TFP is in the same place as CPTR_EL3.TFP. */
+		return !(raw_read_cptr_el2() & CPTR_EL3_TFP_ENABLE);
+	default:
+		return (raw_read_cpacr_el1() & CPACR_TRAP_FP_DISABLE) ==
+			CPACR_TRAP_FP_DISABLE;
+	}
+}
+
+static int ce_probe(void)
+{
+	uint64_t isar0;
+
+	/* ID_AA64ISAR0_EL1.SHA2 */
+	asm ("mrs %0, id_aa64isar0_el1" : "=r" (isar0));
+
+	return ((isar0 >> 12) & 0xf) != 0 && simd_enabled();
+}
+
+const struct sha256_backend sha256_armv8_ce_backend = {
+	.name = "ARMv8 Crypto Extensions",
+	.probe = ce_probe,
+	.transform = ce_transform,
+};
@@ -14,6 +14,7 @@
  */
 
 #include <console/console.h>
+#include <console/uart.h>
 #include <string.h>
 #include <arch/acpi.h>
 #include <cbmem.h>
@@ -259,5 +260,6 @@ void acpi_resume(void *wake_vec)
 	mainboard_suspend_resume();
 
 	post_code(POST_OS_RESUME);
+	uart_buffered_drain();
 	acpi_jump_to_wakeup(wake_vec);
 }
@@ -382,11 +382,18 @@ static void put_packet(char *buffer)
 #endif /* CONFIG_GDB_STUB */
 
 #include <arch/registers.h>
+#include <arch/sampling_profiler.h>
 
 void x86_exception(struct eregs *info);
 
 void x86_exception(struct eregs *info)
 {
+#if IS_ENABLED(CONFIG_SAMPLING_PROFILER)
+	if (info->vector == SAMPLING_PROFILER_VECTOR) {
+		sampling_profiler_interrupt(info);
+		return;
+	}
+#endif
 #if CONFIG_GDB_STUB
 	int signo;
 	memcpy(gdb_stub_registers, info, 8*sizeof(uint32_t));
@@ -0,0 +1,30 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef ARCH_X86_SAMPLING_PROFILER_H
+#define ARCH_X86_SAMPLING_PROFILER_H
+
+/*
+ * IDT vector of the local APIC timer while the sampling profiler runs.
+ * It sits above the 0x20-0x2f range setup_i8259() hands to the i8259.
+ */
+#define SAMPLING_PROFILER_VECTOR	0x30
+
+#ifndef __ASSEMBLER__
+#include <arch/registers.h>
+
+/* Called from x86_exception() for SAMPLING_PROFILER_VECTOR. */
+void sampling_profiler_interrupt(struct eregs *info);
+#endif
+
+#endif /* ARCH_X86_SAMPLING_PROFILER_H */
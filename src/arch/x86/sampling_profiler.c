@@ -0,0 +1,210 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <arch/acpi.h>
+#include <arch/sampling_profiler.h>
+#include <bootstate.h>
+#include <cbmem.h>
+#include <commonlib/sampling_profile_serialized.h>
+#include <console/console.h>
+#include <cpu/x86/lapic.h>
+#include <delay.h>
+#include <string.h>
+#include <symbols.h>
+#include <thread.h>
+
+/*
+ * Statistical profiler for ramstage. The local APIC timer of the BSP
+ * interrupts it CONFIG_SAMPLING_PROFILER_HZ times a second and every
+ * interrupt counts the interrupted call stack in a hash table in CBMEM.
+ * The stacks are found by following the frame pointers, which is why
+ * ramstage is built with -fno-omit-frame-pointer along with this.
+ * `cbmem -F` turns the table into folded stacks for flamegraph.pl.
+ */
+
+#define SAMPLING_PROFILE_SLOTS	2048
+
+static struct sampling_profile *profile;
+
+static uint32_t stack_hash(const uint32_t *pc, uint32_t depth)
+{
+	uint32_t hash = 2166136261u;
+	uint32_t i;
+
+	for (i = 0; i < depth; i++)
+		hash = (hash ^ pc[i]) * 16777619u;
+
+	return hash;
+}
+
+/* Find the end of the stack esp is on, 0 if it isn't a known one. */
+static uintptr_t stack_end(uintptr_t esp)
+{
+	uintptr_t base = (uintptr_t)_stack;
+	uintptr_t end = (uintptr_t)_estack;
+
+	if (esp < base || esp >= end) {
+		if (!IS_ENABLED(CONFIG_COOP_MULTITASKING))
+			return 0;
+		base = (uintptr_t)arch_get_thread_stackbase();
+		end = base + CONFIG_NUM_THREADS * CONFIG_STACK_SIZE;
+		if (esp < base || esp >= end)
+			return 0;
+	}
+
+	/* All stacks are CONFIG_STACK_SIZE aligned and sized. */
+	return ALIGN_DOWN(esp, CONFIG_STACK_SIZE) + CONFIG_STACK_SIZE;
+}
+
+static uint32_t walk_stack(const struct eregs *info, uint32_t *pc)
+{
+	uintptr_t lo = info->esp;
+	uintptr_t hi = stack_end(lo);
+	uintptr_t fp = info->ebp;
+	uint32_t depth = 0;
+
+	pc[depth++] = info->eip;
+
+	/*
+	 * Each frame starts with the caller's frame pointer followed by the
+	 * return address. A sample taken in a prologue or epilogue misses
+	 * the immediate caller, which evens out over many samples.
+	 */
+	while (depth < SAMPLING_PROFILE_MAX_DEPTH && hi && !(fp & 3) &&
+	       fp >= lo && fp + 2 * sizeof(uint32_t) <= hi) {
+		const uint32_t *frame = (const uint32_t *)fp;
+
+		if (!frame[1])
+			break;
+		pc[depth++] = frame[1];
+
+		/* Frames only ever move towards the top of the stack. */
+		if (frame[0] <= fp)
+			break;
+		lo = fp;
+		fp = frame[0];
+	}
+
+	return depth;
+}
+
+void sampling_profiler_interrupt(struct eregs *info)
+{
+	struct sampling_profile *p = profile;
+	uint32_t pc[SAMPLING_PROFILE_MAX_DEPTH];
+	uint32_t depth, slot, i;
+
+	if (p != NULL) {
+		depth = walk_stack(info, pc);
+		slot = stack_hash(pc, depth) % SAMPLING_PROFILE_SLOTS;
+
+		p->num_samples++;
+
+		for (i = 0; i < SAMPLING_PROFILE_SLOTS; i++) {
+			struct sampling_profile_stack *s = &p->stacks[slot];
+
+			if (!s->count) {
+				s->depth = depth;
+				memcpy(s->pc, pc, depth * sizeof(pc[0]));
+			}
+
+			if (s->depth == depth &&
+			    !memcmp(s->pc, pc, depth * sizeof(pc[0]))) {
+				s->count++;
+				break;
+			}
+
+			slot = (slot + 1) % SAMPLING_PROFILE_SLOTS;
+		}
+
+		if (i == SAMPLING_PROFILE_SLOTS)
+			p->lost_samples++;
+	}
+
+	lapic_write(LAPIC_EOI, 0);
+}
+
+static void sampling_profiler_start(void *unused)
+{
+	struct sampling_profile *p;
+	uint32_t start, ticks;
+	size_t size;
+
+	/* Resume doesn't run the interesting parts of ramstage. */
+	if (acpi_is_wakeup_s3())
+		return;
+
+	size = sizeof(*p) + SAMPLING_PROFILE_SLOTS * sizeof(p->stacks[0]);
+	p = cbmem_add(CBMEM_ID_SAMPLING_PROFILE, size);
+	if (p == NULL) {
+		printk(BIOS_ERR, "ERROR: No sampling profile allocated\n");
+		return;
+	}
+
+	memset(p, 0, size);
+	p->rate_hz = CONFIG_SAMPLING_PROFILER_HZ;
+	p->num_slots = SAMPLING_PROFILE_SLOTS;
+	p->load_base = (uintptr_t)_program;
+
+	/* The CPU init code hasn't set up the local APIC yet. */
+	enable_lapic();
+	lapic_write(LAPIC_SPIV, lapic_read(LAPIC_SPIV) | LAPIC_SPIV_ENABLE);
+
+	/* Measure the timer against udelay(), its rate is board specific. */
+	lapic_write(LAPIC_LVTT, LAPIC_LVT_MASKED);
+	lapic_write(LAPIC_TDCR, LAPIC_TDR_DIV_1);
+	lapic_write(LAPIC_TMICT, 0xffffffff);
+	start = lapic_read(LAPIC_TMCCT);
+	udelay(1000);
+	ticks = (uint64_t)(start - lapic_read(LAPIC_TMCCT)) * 1000 /
+		CONFIG_SAMPLING_PROFILER_HZ;
+
+	if (!ticks) {
+		printk(BIOS_ERR, "ERROR: APIC timer too slow for profiling\n");
+		lapic_write(LAPIC_TMICT, 0);
+		return;
+	}
+
+	printk(BIOS_DEBUG, "Sampling profiler: %d Hz, every %u APIC ticks\n",
+	       CONFIG_SAMPLING_PROFILER_HZ, ticks);
+
+	profile = p;
+	lapic_write(LAPIC_LVTT, LAPIC_LVT_TIMER_PERIODIC |
+		    SAMPLING_PROFILER_VECTOR);
+	lapic_write(LAPIC_TMICT, ticks);
+	asm volatile ("sti" ::: "memory");
+}
+
+static void sampling_profiler_stop(void *unused)
+{
+	if (profile == NULL)
+		return;
+
+	lapic_write(LAPIC_LVTT, LAPIC_LVT_MASKED);
+	lapic_write(LAPIC_TMICT, 0);
+
+	/*
+	 * Take a sample that may still be pending before the payload gets
+	 * the CPU back with interrupts disabled, the way it expects it.
+	 */
+	asm volatile ("sti; nop; cli" ::: "memory");
+
+	printk(BIOS_DEBUG, "Sampling profiler: %u samples, %u lost\n",
+	       profile->num_samples, profile->lost_samples);
+	profile = NULL;
+}
+
+BOOT_STATE_INIT_ENTRY(BS_PRE_DEVICE, BS_ON_ENTRY, sampling_profiler_start,
+		      NULL);
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, sampling_profiler_stop,
+		      NULL);
@@ -0,0 +1,180 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <arch/cpu.h>
+#include <cpu/x86/cr.h>
+#include <sha256_backend.h>
+
+/*
+ * SHA-256 using the Intel SHA extensions, following the flow of Intel's
+ * reference implementation. Only xmm0-xmm7 are used so that this builds
+ * for 32-bit stages as well:
+ *
+ * xmm0		message words plus round constants, implicit sha256rnds2 operand
+ * xmm1		state ABEF
+ * xmm2		state CDGH
+ * xmm3-xmm6	message schedule, four words each
+ * xmm7		scratch
+ */
+
+static const uint32_t sha256_k[64] __attribute__((aligned(16))) = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/* Byte swap within each 32-bit word. */
+static const uint8_t bswap_mask[16] __attribute__((aligned(16))) = {
+	3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+};
+
+/* Rounds 4n to 4n + 3 on message words loaded from the data block. */
+#define QUAD_LOAD(n, w)						\
+	"movdqu " #n "*16(%[data]), %%xmm0\n\t"			\
+	"pshufb %[mask], %%xmm0\n\t"				\
+	"movdqa %%xmm0, %%" w "\n\t"				\
+	"paddd " #n "*16(%[k]), %%xmm0\n\t"			\
+	"sha256rnds2 %%xmm1, %%xmm2\n\t"
+
+/* Rounds 4n to 4n + 3 on message words from the schedule. */
+#define QUAD(n, w)						\
+	"movdqa %%" w ", %%xmm0\n\t"				\
+	"paddd " #n "*16(%[k]), %%xmm0\n\t"			\
+	"sha256rnds2 %%xmm1, %%xmm2\n\t"
+
+#define QUAD_END						\
+	"pshufd $0x0e, %%xmm0, %%xmm0\n\t"			\
+	"sha256rnds2 %%xmm2, %%xmm1\n\t"
+
+/* Finish the words of the next quad, which msg1 started three quads ago. */
+#define MSG2(cur, prev, next)					\
+	"movdqa %%" cur ", %%xmm7\n\t"				\
+	"palignr $4, %%" prev ", %%xmm7\n\t"			\
+	"paddd %%xmm7, %%" next "\n\t"				\
+	"sha256msg2 %%" cur ", %%" next "\n\t"
+
+/* Start on the words of the quad after the next three. */
+#define MSG1(cur, prev)						\
+	"sha256msg1 %%" cur ", %%" prev "\n\t"
+
+/* The stages are built without SSE, which has to be allowed here to name
+ * the xmm registers. This only runs once shani_probe() has succeeded. */
+__attribute__((target("sse4.1,sha")))
+static void shani_transform_block(uint32_t state[8], const uint8_t *data)
+{
+	uint32_t save[8];
+
+	asm volatile (
+		/* Turn ABCD and EFGH into ABEF and CDGH. */
+		"movdqu 0(%[state]), %%xmm1\n\t"
+		"movdqu 16(%[state]), %%xmm2\n\t"
+		"pshufd $0xb1, %%xmm1, %%xmm1\n\t"
+		"pshufd $0x1b, %%xmm2, %%xmm2\n\t"
+		"movdqa %%xmm1, %%xmm7\n\t"
+		"palignr $8, %%xmm2, %%xmm1\n\t"
+		"pblendw $0xf0, %%xmm7, %%xmm2\n\t"
+		"movdqu %%xmm1, 0(%[save])\n\t"
+		"movdqu %%xmm2, 16(%[save])\n\t"
+
+		QUAD_LOAD(0, "xmm3")	QUAD_END
+		QUAD_LOAD(1, "xmm4")	QUAD_END	MSG1("xmm4", "xmm3")
+		QUAD_LOAD(2, "xmm5")	QUAD_END	MSG1("xmm5", "xmm4")
+		QUAD_LOAD(3, "xmm6")	MSG2("xmm6", "xmm5", "xmm3")
+		QUAD_END	MSG1("xmm6", "xmm5")
+		QUAD(4, "xmm3")		MSG2("xmm3", "xmm6", "xmm4")
+		QUAD_END	MSG1("xmm3", "xmm6")
+		QUAD(5, "xmm4")		MSG2("xmm4", "xmm3", "xmm5")
+		QUAD_END	MSG1("xmm4", "xmm3")
+		QUAD(6, "xmm5")		MSG2("xmm5", "xmm4", "xmm6")
+		QUAD_END	MSG1("xmm5", "xmm4")
+		QUAD(7, "xmm6")		MSG2("xmm6", "xmm5", "xmm3")
+		QUAD_END	MSG1("xmm6", "xmm5")
+		QUAD(8, "xmm3")		MSG2("xmm3", "xmm6", "xmm4")
+		QUAD_END	MSG1("xmm3", "xmm6")
+		QUAD(9, "xmm4")		MSG2("xmm4", "xmm3", "xmm5")
+		QUAD_END	MSG1("xmm4", "xmm3")
+		QUAD(10, "xmm5")	MSG2("xmm5", "xmm4", "xmm6")
+		QUAD_END	MSG1("xmm5", "xmm4")
+		QUAD(11, "xmm6")	MSG2("xmm6", "xmm5", "xmm3")
+		QUAD_END	MSG1("xmm6", "xmm5")
+		QUAD(12, "xmm3")	MSG2("xmm3", "xmm6", "xmm4")
+		QUAD_END	MSG1("xmm3", "xmm6")
+		QUAD(13, "xmm4")	MSG2("xmm4", "xmm3", "xmm5")
+		QUAD_END
+		QUAD(14, "xmm5")	MSG2("xmm5", "xmm4", "xmm6")
+		QUAD_END
+		QUAD(15, "xmm6")	QUAD_END
+
+		"movdqu 0(%[save]), %%xmm7\n\t"
+		"paddd %%xmm7, %%xmm1\n\t"
+		"movdqu 16(%[save]), %%xmm7\n\t"
+		"paddd %%xmm7, %%xmm2\n\t"
+
+		/* Back to ABCD and EFGH. */
+		"pshufd $0x1b, %%xmm1, %%xmm1\n\t"
+		"pshufd $0xb1, %%xmm2, %%xmm2\n\t"
+		"movdqa %%xmm1, %%xmm7\n\t"
+		"pblendw $0xf0, %%xmm2, %%xmm1\n\t"
+		"palignr $8, %%xmm7, %%xmm2\n\t"
+		"movdqu %%xmm1, 0(%[state])\n\t"
+		"movdqu %%xmm2, 16(%[state])\n\t"
+		:
+		: [save] "r" (save), [state] "r" (state), [data] "r" (data),
+		  [k] "r" (sha256_k), [mask] "m" (bswap_mask)
+		: "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6",
+		  "xmm7", "memory");
+}
+
+static void shani_transform(uint32_t state[8], const uint8_t *data,
+			    size_t num_blocks)
+{
+	while (num_blocks--) {
+		shani_transform_block(state, data);
+		data += SHA256_BLOCK_SIZE;
+	}
+}
+
+static int shani_probe(void)
+{
+	/* SSE has to be enabled for any of the xmm instructions. */
+	if (!(read_cr4() & CR4_OSFXSR))
+		return 0;
+
+	if (cpuid_eax(0) < 7)
+		return 0;
+
+	/* SSSE3 and SSE4.1 for pshufb, palignr and pblendw */
+	if ((cpuid_ecx(1) & ((1 << 9) | (1 << 19))) != ((1 << 9) | (1 << 19)))
+		return 0;
+
+	return !!(cpuid_ext(7, 0).ebx & (1 << 29));
+}
+
+const struct sha256_backend sha256_x86_shani_backend = {
+	.name = "x86 SHA extensions",
+	.probe = shani_probe,
+	.transform = shani_transform,
+};
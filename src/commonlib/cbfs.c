@@ -61,6 +61,36 @@ static int cbfs_end(const struct region_device *cbfs, size_t offset)
 	return 0;
 }
 
+/* Fill in fh for the file header found at offset within cbfs. Returns 0 on
+ * success, > 0 when there's no valid file header at offset and < 0 on error. */
+static int cbfs_file_at(const struct region_device *cbfs, size_t offset,
+			struct cbfsf *fh)
+{
+	struct cbfs_file file;
+	const size_t fsz = sizeof(file);
+
+	/* Can't read file. Nothing else to do but bail out. */
+	if (rdev_readat(cbfs, &file, offset, fsz) != fsz)
+		return -1;
+
+	if (memcmp(file.magic, CBFS_FILE_MAGIC, sizeof(file.magic)))
+		return 1;
+
+	file.len = read_be32(&file.len);
+	file.offset = read_be32(&file.offset);
+
+	DEBUG("File @ offset %zx size %x\n", offset, file.len);
+
+	/* Keep track of both the metadata and the data for the file. */
+	if (rdev_chain(&fh->metadata, cbfs, offset, file.offset))
+		return -1;
+
+	if (rdev_chain(&fh->data, cbfs, offset + file.offset, file.len))
+		return -1;
+
+	return 0;
+}
+
 int cbfs_for_each_file(const struct region_device *cbfs,
 			const struct cbfsf *prev, struct cbfsf *fh)
 {
@@ -70,8 +100,7 @@ int cbfs_for_each_file(const struct region_device *cbfs,
 
 	/* Try to scan the entire cbfs region looking for file name. */
 	while (1) {
-		struct cbfs_file file;
-		const size_t fsz = sizeof(file);
+		int ret;
 
 		 DEBUG("Checking offset %zx\n", offset);
 
@@ -79,28 +108,17 @@ int cbfs_for_each_file(const struct region_device *cbfs,
 		if (cbfs_end(cbfs, offset))
 			return 1;
 
-		/* Can't read file. Nothing else to do but bail out. */
-		if (rdev_readat(cbfs, &file, offset, fsz) != fsz)
+		ret = cbfs_file_at(cbfs, offset, fh);
+
+		if (ret < 0)
 			break;
 
-		if (memcmp(file.magic, CBFS_FILE_MAGIC, sizeof(file.magic))) {
+		if (ret > 0) {
 			offset++;
 			offset = ALIGN_UP(offset, CBFS_ALIGNMENT);
 			continue;
 		}
 
-		file.len = read_be32(&file.len);
-		file.offset = read_be32(&file.offset);
-
-		DEBUG("File @ offset %zx size %x\n", offset, file.len);
-
-		/* Keep track of both the metadata and the data for the file. */
-		if (rdev_chain(&fh->metadata, cbfs, offset, file.offset))
-			break;
-
-		if (rdev_chain(&fh->data, cbfs, offset + file.offset, file.len))
-			break;
-
 		/* Success. */
 		return 0;
 	}
@@ -169,6 +187,46 @@ static int cbfsf_file_type(struct cbfsf *fh, uint32_t *ftype)
 	return 0;
 }
 
+/* Check if fh matches name and optional type. Returns 1 on match, 0 on
+ * mismatch and < 0 on error. */
+static int cbfsf_match(const struct region_device *cbfs, struct cbfsf *fh,
+			const char *name, uint32_t *type)
+{
+	char *fname;
+	int name_match;
+	const size_t fsz = sizeof(struct cbfs_file);
+
+	fname = rdev_mmap(&fh->metadata, fsz,
+			region_device_sz(&fh->metadata) - fsz);
+
+	if (fname == NULL)
+		return -1;
+
+	name_match = !strcmp(fname, name);
+	rdev_munmap(&fh->metadata, fname);
+
+	if (!name_match) {
+		DEBUG(" Unmatched '%s' at %zx\n", fname,
+			rdev_relative_offset(cbfs, &fh->metadata));
+		return 0;
+	}
+
+	if (type != NULL) {
+		uint32_t ftype;
+
+		if (cbfsf_file_type(fh, &ftype))
+			return -1;
+
+		if (*type != ftype) {
+			DEBUG(" Unmatched type %x at %zx\n", ftype,
+				rdev_relative_offset(cbfs, &fh->metadata));
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
 int cbfs_locate(struct cbfsf *fh, const struct region_device *cbfs,
 		const char *name, uint32_t *type)
 {
@@ -180,9 +238,6 @@ int cbfs_locate(struct cbfsf *fh, const struct region_device *cbfs,
 
 	while (1) {
 		int ret;
-		char *fname;
-		int name_match;
-		const size_t fsz = sizeof(struct cbfs_file);
 
 		ret = cbfs_for_each_file(cbfs, prev, fh);
 		prev = fh;
@@ -191,34 +246,13 @@ int cbfs_locate(struct cbfsf *fh, const struct region_device *cbfs,
 		if (ret < 0 || ret > 0)
 			break;
 
-		fname = rdev_mmap(&fh->metadata, fsz,
-				region_device_sz(&fh->metadata) - fsz);
+		ret = cbfsf_match(cbfs, fh, name, type);
 
-		if (fname == NULL)
+		if (ret < 0)
 			break;
 
-		name_match = !strcmp(fname, name);
-		rdev_munmap(&fh->metadata, fname);
-
-		if (!name_match) {
-			DEBUG(" Unmatched '%s' at %zx\n", fname,
-				rdev_relative_offset(cbfs, &fh->metadata));
+		if (ret == 0)
 			continue;
-		}
-
-		if (type != NULL) {
-			uint32_t ftype;
-
-			if (cbfsf_file_type(fh, &ftype))
-				break;
-
-			if (*type != ftype) {
-				DEBUG(" Unmatched type %x at %zx\n", ftype,
-					rdev_relative_offset(cbfs,
-							&fh->metadata));
-				continue;
-			}
-		}
 
 		LOG("Found @ offset %zx size %zx\n",
 			rdev_relative_offset(cbfs, &fh->metadata),
@@ -232,13 +266,366 @@ int cbfs_locate(struct cbfsf *fh, const struct region_device *cbfs,
 	return -1;
 }
 
-static int cbfs_extend_hash_buffer(struct vb2_digest_context *ctx,
+/* 32-bit FNV-1a hash over the file name. */
+static uint32_t cbfs_name_hash(const char *name)
+{
+	uint32_t hash = 0x811c9dc5;
+
+	while (*name != '\0') {
+		hash ^= (uint8_t)*name++;
+		hash *= 0x01000193;
+	}
+
+	return hash;
+}
+
+static uint32_t cbfs_index_checksum_range(uint32_t sum, const void *buf,
+						size_t size)
+{
+	const uint8_t *p = buf;
+	size_t i;
+
+	for (i = 0; i < size; i++)
+		sum = (sum << 1 | sum >> 31) + p[i];
+
+	return sum;
+}
+
+/* Checksum over the used parts of the index. The checksum field itself and
+ * the free space between the entries and the names are left out. */
+static uint32_t cbfs_index_checksum(const struct cbfs_index *index)
+{
+	uint32_t sum;
+
+	sum = cbfs_index_checksum_range(0, index,
+				offsetof(struct cbfs_index, checksum));
+	sum = cbfs_index_checksum_range(sum, index->entries,
+				index->num_entries * sizeof(index->entries[0]));
+	sum = cbfs_index_checksum_range(sum,
+				(const char *)index + index->names_offset,
+				index->size - index->names_offset);
+
+	return sum;
+}
+
+static const char *cbfs_index_name(const struct cbfs_index *index,
+					const struct cbfs_index_entry *e)
+{
+	return (const char *)index + e->name_offset;
+}
+
+/* Return the first entry whose name hash is not less than hash. */
+static size_t cbfs_index_lower_bound(const struct cbfs_index *index,
+					uint32_t hash)
+{
+	size_t lo = 0;
+	size_t hi = index->num_entries;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (index->entries[mid].name_hash < hash)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/* Fill in the cached attributes of e from the fully mapped metadata. */
+static void cbfs_index_parse_attrs(struct cbfs_index_entry *e,
+					void *metadata, size_t metadata_size)
+{
+	size_t offs = 0;
+
+	e->compression = CBFS_COMPRESS_NONE;
+	e->decompressed_size = e->len;
+
+	while ((offs = cbfs_for_each_attr(metadata, metadata_size, offs))) {
+		struct cbfs_file_attr_compression *attr = metadata + offs;
+		uint32_t tag = read_be32(&attr->tag);
+
+		if (tag == CBFS_FILE_ATTR_TAG_COMPRESSION) {
+			e->compression = read_be32(&attr->compression);
+			e->decompressed_size =
+				read_be32(&attr->decompressed_size);
+		}
+	}
+}
+
+static int cbfs_index_insert(struct cbfs_index *index,
+				const struct cbfs_index_entry *e,
+				const char *name)
+{
+	const size_t name_sz = strlen(name) + 1;
+	size_t used;
+	size_t pos;
+	size_t i;
+
+	used = sizeof(*index) + (index->num_entries + 1) * sizeof(*e);
+	if (used + name_sz > index->names_offset)
+		return -1;
+
+	index->names_offset -= name_sz;
+	memcpy((char *)index + index->names_offset, name, name_sz);
+
+	/* Insert after all entries with an equal hash so that files sharing a
+	 * hash keep their CBFS order. */
+	pos = cbfs_index_lower_bound(index, e->name_hash);
+	while (pos < index->num_entries &&
+	       index->entries[pos].name_hash == e->name_hash)
+		pos++;
+
+	for (i = index->num_entries; i > pos; i--)
+		index->entries[i] = index->entries[i - 1];
+
+	index->entries[pos] = *e;
+	index->entries[pos].name_offset = index->names_offset;
+	index->num_entries++;
+
+	return 0;
+}
+
+int cbfs_index_valid(const struct cbfs_index *index,
+			const struct region_device *cbfs, int verify)
+{
+	size_t entries_end;
+	size_t i;
+
+	if (index->magic != CBFS_INDEX_MAGIC)
+		return 0;
+
+	if (index->cbfs_offset != region_device_offset(cbfs) ||
+	    index->cbfs_size != region_device_sz(cbfs))
+		return 0;
+
+	if (!verify)
+		return 1;
+
+	/* The index may have been handed over from a previous stage through
+	 * memory which isn't trusted. Check its layout before using it. */
+	entries_end = sizeof(*index) +
+			index->num_entries * sizeof(index->entries[0]);
+
+	if (entries_end > index->names_offset ||
+	    index->names_offset > index->size)
+		return 0;
+
+	for (i = 0; i < index->num_entries; i++) {
+		const struct cbfs_index_entry *e = &index->entries[i];
+
+		if (e->name_offset < index->names_offset ||
+		    e->name_offset >= index->size)
+			return 0;
+	}
+
+	if (((const char *)index)[index->size - 1] != '\0' &&
+	    index->num_entries != 0)
+		return 0;
+
+	if (cbfs_index_checksum(index) != index->checksum)
+		return 0;
+
+	return 1;
+}
+
+int cbfs_index_build(struct cbfs_index *index, size_t index_size,
+			const struct region_device *cbfs)
+{
+	struct cbfsf f;
+	struct cbfsf *prev;
+	const size_t fsz = sizeof(struct cbfs_file);
+
+	if (index_size < sizeof(*index))
+		return -1;
+
+	index->magic = 0;
+	index->cbfs_offset = region_device_offset(cbfs);
+	index->cbfs_size = region_device_sz(cbfs);
+	index->num_entries = 0;
+	index->size = index_size;
+	index->names_offset = index_size;
+	index->flags = 0;
+
+	prev = NULL;
+
+	while (1) {
+		int ret;
+		char *metadata;
+		size_t metadata_size;
+		struct cbfs_index_entry e;
+
+		ret = cbfs_for_each_file(cbfs, prev, &f);
+		prev = &f;
+
+		if (ret < 0)
+			return -1;
+
+		/* End of CBFS. Every named file is now in the index. */
+		if (ret > 0) {
+			index->flags |= CBFS_INDEX_COMPLETE;
+			break;
+		}
+
+		metadata_size = region_device_sz(&f.metadata);
+		metadata = rdev_mmap_full(&f.metadata);
+
+		if (metadata == NULL)
+			return -1;
+
+		/* Empty and deleted files carry no name to look up. Files
+		 * with a name that isn't terminated are left to cbfs_locate(). */
+		if (metadata_size <= fsz || metadata[fsz] == '\0' ||
+		    memchr(&metadata[fsz], '\0', metadata_size - fsz) == NULL) {
+			rdev_munmap(&f.metadata, metadata);
+			continue;
+		}
+
+		e.name_hash = cbfs_name_hash(&metadata[fsz]);
+		e.offset = rdev_relative_offset(cbfs, &f.metadata);
+		e.metadata_size = metadata_size;
+		e.len = region_device_sz(&f.data);
+		e.type = read_be32(&((struct cbfs_file *)metadata)->type);
+		cbfs_index_parse_attrs(&e, metadata, metadata_size);
+
+		ret = cbfs_index_insert(index, &e, &metadata[fsz]);
+
+		rdev_munmap(&f.metadata, metadata);
+
+		/* Out of space. Keep what was indexed so far. */
+		if (ret < 0) {
+			LOG("Index full after %u files\n", index->num_entries);
+			break;
+		}
+	}
+
+	index->magic = CBFS_INDEX_MAGIC;
+	index->checksum = cbfs_index_checksum(index);
+
+	DEBUG("Indexed %u files\n", index->num_entries);
+
+	return 0;
+}
+
+const struct cbfs_index_entry *cbfs_index_find(const struct cbfs_index *index,
+					const char *name, uint32_t *type)
+{
+	uint32_t hash;
+	size_t i;
+
+	hash = cbfs_name_hash(name);
+
+	for (i = cbfs_index_lower_bound(index, hash);
+	     i < index->num_entries && index->entries[i].name_hash == hash;
+	     i++) {
+		const struct cbfs_index_entry *e = &index->entries[i];
+
+		if (strcmp(cbfs_index_name(index, e), name))
+			continue;
+
+		if (type != NULL && *type != e->type) {
+			DEBUG(" Unmatched type %x at %x\n", e->type,
+				e->offset);
+			continue;
+		}
+
+		return e;
+	}
+
+	return NULL;
+}
+
+/* Re-read the file header behind e from the boot media and check that it
+ * still matches the cached metadata. Returns 0 on match, < 0 otherwise. */
+static int cbfs_index_verify_entry(const struct cbfs_index *index,
+				const struct cbfs_index_entry *e,
+				const struct region_device *cbfs,
+				struct cbfsf *fh)
+{
+	struct cbfsf f;
+	uint32_t type = e->type;
+
+	if (cbfs_file_at(cbfs, e->offset, &f))
+		return -1;
+
+	if (region_device_sz(&f.metadata) != e->metadata_size ||
+	    region_device_sz(&f.data) != e->len ||
+	    region_device_offset(&f.data) != region_device_offset(&fh->data))
+		return -1;
+
+	if (cbfsf_match(cbfs, &f, cbfs_index_name(index, e), &type) != 1)
+		return -1;
+
+	return 0;
+}
+
+int cbfs_index_locate(const struct cbfs_index *index, struct cbfsf *fh,
+			const struct region_device *cbfs, const char *name,
+			uint32_t *type, int verify)
+{
+	const struct cbfs_index_entry *e;
+
+	if (!cbfs_index_valid(index, cbfs, verify))
+		return 1;
+
+	LOG("Locating '%s' in index\n", name);
+
+	e = cbfs_index_find(index, name, type);
+
+	if (e == NULL) {
+		/* A partial index can't tell if the file exists. */
+		if (!(index->flags & CBFS_INDEX_COMPLETE))
+			return 1;
+
+		LOG("'%s' not found.\n", name);
+		return -1;
+	}
+
+	if (rdev_chain(&fh->metadata, cbfs, e->offset, e->metadata_size))
+		return 1;
+
+	if (rdev_chain(&fh->data, cbfs, e->offset + e->metadata_size, e->len))
+		return 1;
+
+	if (verify && cbfs_index_verify_entry(index, e, cbfs, fh)) {
+		ERROR("Index entry for '%s' doesn't match media\n", name);
+		return 1;
+	}
+
+	LOG("Found @ offset %x size %x\n", e->offset, e->len);
+
+	return 0;
+}
+
+/*
+ * The contents are hashed with the platform's hardware digest when it takes
+ * the algorithm, otherwise with vboot's. A hardware digest needs to know
+ * the amount of data up front, so for it the CBFS is first walked with
+ * size_only set to add that up before it is walked again to hash it.
+ */
+struct cbfs_hash_ctx {
+	struct vb2_digest_context vb2;
+	int hwcrypto;
+	int size_only;
+	size_t size;
+};
+
+static int cbfs_extend_hash_buffer(struct cbfs_hash_ctx *ctx,
 					void *buf, size_t sz)
 {
-	return vb2_digest_extend(ctx, buf, sz);
+	if (ctx->size_only) {
+		ctx->size += sz;
+		return VB2_SUCCESS;
+	}
+
+	if (ctx->hwcrypto)
+		return vb2ex_hwcrypto_digest_extend(buf, sz);
+
+	return vb2_digest_extend(&ctx->vb2, buf, sz);
 }
 
-static int cbfs_extend_hash(struct vb2_digest_context *ctx,
+static int cbfs_extend_hash(struct cbfs_hash_ctx *ctx,
 				const struct region_device *rdev)
 {
 	uint8_t buffer[1024];
@@ -248,6 +635,11 @@ static int cbfs_extend_hash(struct vb2_digest_context *ctx,
 	sz_left = region_device_sz(rdev);
 	offset = 0;
 
+	if (ctx->size_only) {
+		ctx->size += sz_left;
+		return VB2_SUCCESS;
+	}
+
 	while (sz_left) {
 		int rv;
 		size_t block_sz = MIN(sz_left, sizeof(buffer));
@@ -268,7 +660,7 @@ static int cbfs_extend_hash(struct vb2_digest_context *ctx,
 }
 
 /* Include offsets of child regions within the parent into the hash. */
-static int cbfs_extend_hash_with_offset(struct vb2_digest_context *ctx,
+static int cbfs_extend_hash_with_offset(struct cbfs_hash_ctx *ctx,
 					const struct region_device *p,
 					const struct region_device *c)
 {
@@ -293,7 +685,7 @@ static int cbfs_extend_hash_with_offset(struct vb2_digest_context *ctx,
 
 /* Hash in the potential CBFS header sitting at the beginning of the CBFS
  * region as well as relative offset at the end. */
-static int cbfs_extend_hash_master_header(struct vb2_digest_context *ctx,
+static int cbfs_extend_hash_master_header(struct cbfs_hash_ctx *ctx,
 					const struct region_device *cbfs)
 {
 	struct region_device rdev;
@@ -315,22 +707,15 @@ static int cbfs_extend_hash_master_header(struct vb2_digest_context *ctx,
 	return cbfs_extend_hash_with_offset(ctx, cbfs, &rdev);
 }
 
-int cbfs_vb2_hash_contents(const struct region_device *cbfs,
-				enum vb2_hash_algorithm hash_alg, void *digest,
-				size_t digest_sz)
+static int cbfs_extend_hash_contents(struct cbfs_hash_ctx *ctx,
+					const struct region_device *cbfs)
 {
-	struct vb2_digest_context ctx;
 	int rv;
 	struct cbfsf f;
 	struct cbfsf *prev;
 	struct cbfsf *fh;
 
-	rv = vb2_digest_init(&ctx, hash_alg);
-
-	if (rv)
-		return rv;
-
-	rv = cbfs_extend_hash_master_header(&ctx, cbfs);
+	rv = cbfs_extend_hash_master_header(ctx, cbfs);
 	if (rv)
 		return rv;
 
@@ -350,7 +735,7 @@ int cbfs_vb2_hash_contents(const struct region_device *cbfs,
 		if (rv > 0)
 			break;
 
-		rv = cbfs_extend_hash_with_offset(&ctx, cbfs, &fh->metadata);
+		rv = cbfs_extend_hash_with_offset(ctx, cbfs, &fh->metadata);
 
 		if (rv)
 			return rv;
@@ -362,11 +747,45 @@ int cbfs_vb2_hash_contents(const struct region_device *cbfs,
 		if (ftype == CBFS_TYPE_DELETED || ftype == CBFS_TYPE_DELETED2)
 			continue;
 
-		rv = cbfs_extend_hash_with_offset(&ctx, cbfs, &fh->data);
+		rv = cbfs_extend_hash_with_offset(ctx, cbfs, &fh->data);
 
 		if (rv)
 			return rv;
 	}
 
-	return vb2_digest_finalize(&ctx, digest, digest_sz);
+	return VB2_SUCCESS;
+}
+
+int cbfs_vb2_hash_contents(const struct region_device *cbfs,
+				enum vb2_hash_algorithm hash_alg, void *digest,
+				size_t digest_sz)
+{
+	struct cbfs_hash_ctx ctx = { .hwcrypto = 0 };
+	int rv;
+
+	if (cbfs_hwcrypto_supported(hash_alg)) {
+		ctx.size_only = 1;
+		rv = cbfs_extend_hash_contents(&ctx, cbfs);
+		if (rv)
+			return rv;
+
+		ctx.size_only = 0;
+		ctx.hwcrypto = vb2ex_hwcrypto_digest_init(hash_alg,
+						ctx.size) == VB2_SUCCESS;
+	}
+
+	if (!ctx.hwcrypto) {
+		rv = vb2_digest_init(&ctx.vb2, hash_alg);
+		if (rv)
+			return rv;
+	}
+
+	rv = cbfs_extend_hash_contents(&ctx, cbfs);
+	if (rv)
+		return rv;
+
+	if (ctx.hwcrypto)
+		return vb2ex_hwcrypto_digest_finalize(digest, digest_sz);
+
+	return vb2_digest_finalize(&ctx.vb2, digest, digest_sz);
 }
@@ -70,6 +70,83 @@ size_t cbfs_for_each_attr(void *metadata, size_t metadata_size,
  */
 int cbfsf_decompression_info(struct cbfsf *fh, uint32_t *algo, size_t *size);
 
+/*
+ * An index over the named files of a CBFS sorted by a hash of the file name.
+ * Besides the location of each file it caches the metadata needed to load
+ * it, so that a file can be located and its compression determined without
+ * touching the boot media. Entries grow upwards from the header while the
+ * file names grow downwards from the end of the index storage. The index
+ * records the region it was built for so that a stale index is never used
+ * for another CBFS.
+ */
+#define CBFS_INDEX_MAGIC	0x58444e49	/* 'INDX' */
+#define CBFS_INDEX_COMPLETE	(1 << 0)
+
+struct cbfs_index_entry {
+	uint32_t name_hash;
+	/* Offset of the file name relative to the start of the index. */
+	uint32_t name_offset;
+	/* Offset of the file header relative to the start of the CBFS. */
+	uint32_t offset;
+	/* Size of header, name and attributes. The data follows directly. */
+	uint32_t metadata_size;
+	uint32_t len;
+	uint32_t type;
+	uint32_t compression;
+	uint32_t decompressed_size;
+};
+
+struct cbfs_index {
+	uint32_t magic;
+	uint32_t cbfs_offset;
+	uint32_t cbfs_size;
+	uint32_t num_entries;
+	/* Size of the whole index storage. */
+	uint32_t size;
+	/* Start of the file name pool relative to the start of the index. */
+	uint32_t names_offset;
+	uint32_t flags;
+	/* Needs to stay the last field of the header. */
+	uint32_t checksum;
+	struct cbfs_index_entry entries[0];
+};
+
+/*
+ * Return 1 if the index was built for the provided cbfs, 0 otherwise. With
+ * verify set the layout and checksum of the index are validated as well.
+ */
+int cbfs_index_valid(const struct cbfs_index *index,
+			const struct region_device *cbfs, int verify);
+
+/*
+ * Build an index over cbfs in the index_size bytes large index storage. Files
+ * that don't fit are left out and the index isn't marked complete. Returns 0
+ * on success, < 0 on error.
+ */
+int cbfs_index_build(struct cbfs_index *index, size_t index_size,
+			const struct region_device *cbfs);
+
+/* Return the index entry for name and optional type. NULL if not indexed. */
+const struct cbfs_index_entry *cbfs_index_find(const struct cbfs_index *index,
+					const char *name, uint32_t *type);
+
+/*
+ * Locate file by name and optional type using the index. No boot media
+ * access is done unless verify is set, in which case the file header is
+ * read back and compared against the index. Returns 0 on success, < 0 if
+ * the file doesn't exist, and > 0 if the index can't answer the query and
+ * the caller needs to fall back to cbfs_locate().
+ */
+int cbfs_index_locate(const struct cbfs_index *index, struct cbfsf *fh,
+			const struct region_device *cbfs, const char *name,
+			uint32_t *type, int verify);
+
+/*
+ * Return non-zero if the platform's vb2ex_hwcrypto_digest_*() take hash_alg.
+ * cbfs_vb2_hash_contents() only sizes the CBFS for the hardware digest then.
+ */
+int cbfs_hwcrypto_supported(enum vb2_hash_algorithm hash_alg);
+
 /*
  * Perform the vb2 hash over the CBFS region skipping empty file contents.
  * Caller is responsible for providing the hash algorithm as well as storage
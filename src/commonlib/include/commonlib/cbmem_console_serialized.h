@@ -0,0 +1,31 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __CBMEM_CONSOLE_SERIALIZED_H__
+#define __CBMEM_CONSOLE_SERIALIZED_H__
+
+/*
+ * The CBMEM console is laid out as
+ *  u32  size
+ *  u32  cursor
+ *  u8   body[size]
+ *
+ * In the default mode the cursor keeps counting once the body is full and the
+ * data is dropped, so cursor - size bytes have been lost. In ring buffer mode
+ * the cursor stays below size and CBMEM_CONSOLE_OVERFLOW is set in it once the
+ * body has wrapped around. The oldest data then starts at the cursor.
+ */
+#define CBMEM_CONSOLE_CURSOR_MASK	((1 << 28) - 1)
+#define CBMEM_CONSOLE_OVERFLOW		(1U << 31)
+
+#endif /* __CBMEM_CONSOLE_SERIALIZED_H__ */
@@ -24,8 +24,11 @@
 #define CBMEM_ID_AGESA_RUNTIME	0x41474553
 #define CBMEM_ID_AMDMCT_MEMINFO 0x494D454E
 #define CBMEM_ID_CAR_GLOBALS	0xcac4e6a3
+#define CBMEM_ID_CBFS_INDEX	0x43424958
 #define CBMEM_ID_CBTABLE	0x43425442
 #define CBMEM_ID_CONSOLE	0x434f4e53
+#define CBMEM_ID_CONSOLE_PROFILE 0x434f5046
+#define CBMEM_ID_DEVICE_TIMING	0x44455654
 #define CBMEM_ID_COVERAGE	0x47434f56
 #define CBMEM_ID_EHCI_DEBUG	0xe4c1deb9
 #define CBMEM_ID_ELOG		0x454c4f47
@@ -56,10 +59,12 @@
 #define CBMEM_ID_ROMSTAGE_INFO	0x47545352
 #define CBMEM_ID_ROMSTAGE_RAM_STACK 0x90357ac4
 #define CBMEM_ID_ROOT		0xff4007ff
+#define CBMEM_ID_SAMPLING_PROFILE 0x534d504c
 #define CBMEM_ID_SMBIOS         0x534d4254
 #define CBMEM_ID_SMM_SAVE_SPACE	0x07e9acee
 #define CBMEM_ID_STAGEx_META	0x57a9e000
 #define CBMEM_ID_STAGEx_CACHE	0x57a9e100
+#define CBMEM_ID_STAGEx_WARM	0x57a9e200
 #define CBMEM_ID_TCPA_LOG	0x54435041
 #define CBMEM_ID_TIMESTAMP	0x54494d45
 #define CBMEM_ID_VBOOT_HANDOFF	0x780074f0
@@ -78,8 +83,11 @@
 	{ CBMEM_ID_AFTER_CAR,		"AFTER CAR  " }, \
 	{ CBMEM_ID_AMDMCT_MEMINFO,	"AMDMEM INFO" }, \
 	{ CBMEM_ID_CAR_GLOBALS,		"CAR GLOBALS" }, \
+	{ CBMEM_ID_CBFS_INDEX,		"CBFS INDEX " }, \
 	{ CBMEM_ID_CBTABLE,		"COREBOOT   " }, \
 	{ CBMEM_ID_CONSOLE,		"CONSOLE    " }, \
+	{ CBMEM_ID_CONSOLE_PROFILE,	"CONSOLE PRF" }, \
+	{ CBMEM_ID_DEVICE_TIMING,	"DEV TIMING " }, \
 	{ CBMEM_ID_COVERAGE,		"COVERAGE   " }, \
 	{ CBMEM_ID_EHCI_DEBUG,		"USBDEBUG   " }, \
 	{ CBMEM_ID_ELOG,		"ELOG       " }, \
@@ -108,6 +116,7 @@
 	{ CBMEM_ID_ROMSTAGE_INFO,	"ROMSTAGE   " }, \
 	{ CBMEM_ID_ROMSTAGE_RAM_STACK,	"ROMSTG STCK" }, \
 	{ CBMEM_ID_ROOT,		"CBMEM ROOT " }, \
+	{ CBMEM_ID_SAMPLING_PROFILE,	"SAMPLES    " }, \
 	{ CBMEM_ID_SMBIOS,		"SMBIOS     " }, \
 	{ CBMEM_ID_SMM_SAVE_SPACE,	"SMM BACKUP " }, \
 	{ CBMEM_ID_TCPA_LOG,		"TCPA LOG   " }, \
@@ -31,4 +31,28 @@ size_t ulz4fn(const void *src, size_t srcn, void *dst, size_t dstn);
 /* Same as ulz4fn() but does not perform any bounds checks. */
 size_t ulz4f(const void *src, void *dst);
 
+/*
+ * Building blocks of ulz4fn() for callers that want to decompress an LZ4F
+ * image block by block, e.g. while the rest of it is still being loaded.
+ */
+
+/* Largest possible LZ4F frame header. */
+#define LZ4F_MAX_HEADER_SIZE	15
+/* Size of an LZ4F block header and of an optional block checksum. */
+#define LZ4F_BLOCK_HEADER_SIZE	4
+#define LZ4F_BLOCK_CHECKSUM_SIZE 4
+
+/* Validates the frame header at src. Returns the size of the header, or 0 on
+ * error. Sets has_block_checksum if blocks are followed by a checksum. */
+size_t ulz4f_header(const void *src, size_t srcn, int *has_block_checksum);
+
+/* Decodes the block header at src. Returns the size of the block data that
+ * follows, 0 for the end mark. Sets not_compressed for raw blocks. */
+size_t ulz4f_block_header(const void *src, int *not_compressed);
+
+/* Decompresses srcn bytes of block data from src to dst, writing no more than
+ * dstn bytes. Returns the amount of decompressed bytes, or < 0 on error. */
+int ulz4f_block(const void *src, size_t srcn, int not_compressed,
+		void *dst, size_t dstn);
+
 #endif	/* _COMMONLIB_COMPRESSION_H_ */
@@ -0,0 +1,62 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __CONSOLE_BINLOG_SERIALIZED_H__
+#define __CONSOLE_BINLOG_SERIALIZED_H__
+
+#include <stdint.h>
+
+/*
+ * With CONSOLE_CBMEM_BINARY printk() doesn't format its messages. It stores a
+ * record in the CBMEM console instead, between the plain text written by
+ * everything else. A record starts with a NUL byte, which never shows up in
+ * console text, followed by the rest of struct console_binlog_record and
+ * args_size bytes of arguments. The format string is found at fmt_offset
+ * from the _program symbol of the stage that printed it.
+ *
+ * The arguments are stored in the order vtxprintf() consumes them, all
+ * little endian:
+ *  - '*' field width or precision: 4 bytes
+ *  - %c: 1 byte
+ *  - %s: the characters that get printed, followed by a NUL byte
+ *  - %p: 1 byte holding sizeof(void *), then the pointer in 8 bytes
+ *  - integers with the l, ll or z qualifier: 8 bytes, as vtxprintf() reads
+ *    them into its unsigned long long
+ *  - other integers: 4 bytes
+ */
+
+#define CONSOLE_BINLOG_MARKER		0x00
+#define CONSOLE_BINLOG_MAX_ARGS		255
+
+enum console_binlog_stage {
+	CONSOLE_BINLOG_BOOTBLOCK = 1,
+	CONSOLE_BINLOG_VERSTAGE,
+	CONSOLE_BINLOG_ROMSTAGE,
+	CONSOLE_BINLOG_POSTCAR,
+	CONSOLE_BINLOG_RAMSTAGE,
+	CONSOLE_BINLOG_NUM_STAGES
+};
+
+/* File names of the stage ELFs, indexed by enum console_binlog_stage. */
+#define CONSOLE_BINLOG_STAGE_NAMES					\
+	NULL, "bootblock", "verstage", "romstage", "postcar", "ramstage"
+
+struct console_binlog_record {
+	uint8_t marker;
+	/* Stage in the upper, log level in the lower 4 bits. */
+	uint8_t stage_level;
+	uint16_t args_size;
+	uint32_t fmt_offset;
+} __attribute__((packed));
+
+#endif /* __CONSOLE_BINLOG_SERIALIZED_H__ */
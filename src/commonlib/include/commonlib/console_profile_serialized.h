@@ -0,0 +1,67 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __CONSOLE_PROFILE_SERIALIZED_H__
+#define __CONSOLE_PROFILE_SERIALIZED_H__
+
+#include <stdint.h>
+
+/* Log levels BIOS_EMERG (0) through BIOS_SPEW (8). */
+#define CONSOLE_PROFILE_NUM_LEVELS	9
+
+enum console_profile_driver {
+	CONSOLE_PROFILE_CBMEM,
+	CONSOLE_PROFILE_SPKMODEM,
+	CONSOLE_PROFILE_QEMU_DEBUGCON,
+	CONSOLE_PROFILE_UART,
+	CONSOLE_PROFILE_NE2K,
+	CONSOLE_PROFILE_USB,
+	CONSOLE_PROFILE_SPI,
+	CONSOLE_PROFILE_NUM_DRIVERS
+};
+
+#define CONSOLE_PROFILE_DRIVER_NAMES		\
+	[CONSOLE_PROFILE_CBMEM] = "cbmem",	\
+	[CONSOLE_PROFILE_SPKMODEM] = "spkmodem", \
+	[CONSOLE_PROFILE_QEMU_DEBUGCON] = "qemu_debugcon", \
+	[CONSOLE_PROFILE_UART] = "uart",	\
+	[CONSOLE_PROFILE_NE2K] = "ne2k",	\
+	[CONSOLE_PROFILE_USB] = "usb",		\
+	[CONSOLE_PROFILE_SPI] = "spi",
+
+/* Number of back-to-back timestamp reads timestamp_cost is measured over. */
+#define CONSOLE_PROFILE_COST_SAMPLES	1024
+
+/*
+ * Time is counted in timestamp ticks. The time spent in the drivers is also
+ * part of the time spent on the log level of the message being printed.
+ */
+struct console_profile_counter {
+	uint64_t	ticks;
+	uint32_t	calls;
+	uint32_t	bytes;
+} __attribute__((packed));
+
+struct console_profile {
+	uint16_t	tick_freq_mhz;
+	uint8_t		num_levels;
+	uint8_t		num_drivers;
+	/* Ticks taken by CONSOLE_PROFILE_COST_SAMPLES timestamp reads. */
+	uint32_t	timestamp_cost;
+	/* Timestamps read for profiling, which is included in the times. */
+	uint64_t	timestamps;
+	struct console_profile_counter levels[CONSOLE_PROFILE_NUM_LEVELS];
+	struct console_profile_counter drivers[CONSOLE_PROFILE_NUM_DRIVERS];
+} __attribute__((packed));
+
+#endif
@@ -0,0 +1,59 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __DEVICE_TIMING_SERIALIZED_H__
+#define __DEVICE_TIMING_SERIALIZED_H__
+
+#include <stdint.h>
+
+/* The device_operations callbacks that get timed. */
+enum device_timing_op {
+	DEVICE_TIMING_SCAN_BUS,
+	DEVICE_TIMING_READ_RESOURCES,
+	DEVICE_TIMING_SET_RESOURCES,
+	DEVICE_TIMING_ENABLE_RESOURCES,
+	DEVICE_TIMING_INIT,
+	DEVICE_TIMING_FINAL,
+	DEVICE_TIMING_NUM_OPS
+};
+
+#define DEVICE_TIMING_OP_NAMES					\
+	[DEVICE_TIMING_SCAN_BUS] = "scan_bus",			\
+	[DEVICE_TIMING_READ_RESOURCES] = "read_resources",	\
+	[DEVICE_TIMING_SET_RESOURCES] = "set_resources",	\
+	[DEVICE_TIMING_ENABLE_RESOURCES] = "enable_resources",	\
+	[DEVICE_TIMING_INIT] = "init",				\
+	[DEVICE_TIMING_FINAL] = "final",
+
+/* Long enough for any dev_path(), which gets cut off otherwise. */
+#define DEVICE_TIMING_PATH_SIZE	40
+
+/*
+ * Time is counted in timestamp ticks. A callback that calls into the
+ * callbacks of other devices, e.g. scan_bus() of a bridge, is only charged
+ * for the time not spent in those.
+ */
+struct device_timing_entry {
+	char		path[DEVICE_TIMING_PATH_SIZE];
+	uint64_t	ticks[DEVICE_TIMING_NUM_OPS];
+} __attribute__((packed));
+
+struct device_timing_table {
+	uint16_t	tick_freq_mhz;
+	uint8_t		num_ops;
+	uint8_t		reserved;
+	uint32_t	num_entries;
+	struct device_timing_entry entries[0];
+} __attribute__((packed));
+
+#endif
@@ -63,6 +63,31 @@ ssize_t rdev_writeat(const struct region_device *rd, const void *b,
 ssize_t rdev_eraseat(const struct region_device *rd, size_t offset,
 			size_t size);
 
+/*
+ * Asynchronous reads. rdev_readat_async() starts reading size bytes at
+ * offset into the buffer passed and may return before the data has arrived.
+ * rdev_read_wait() then waits for the read to finish and returns what
+ * rdev_readat() would have. The buffer must not be touched in between, and
+ * a struct rdev_async_read tracks only one read at a time. Devices without
+ * support for it complete the read within rdev_readat_async().
+ *
+ * rdev_readat_async() returns < 0 if the read couldn't be started at all.
+ */
+struct rdev_async_read {
+	/* Device the read was started on. */
+	const struct region_device *rdev;
+	/* Result of a read that has already completed. */
+	ssize_t result;
+	/* For the driver's own use. */
+	void *priv;
+};
+
+int rdev_readat_async(const struct region_device *rd,
+			struct rdev_async_read *req, void *b, size_t offset,
+			size_t size);
+
+ssize_t rdev_read_wait(struct rdev_async_read *req);
+
 /****************************************
  *  Implementation of a region device   *
  ****************************************/
@@ -84,6 +109,16 @@ struct region_device_ops {
 	ssize_t (*writeat)(const struct region_device *, const void *, size_t,
 		size_t);
 	ssize_t (*eraseat)(const struct region_device *, size_t, size_t);
+	/*
+	 * Optional, see rdev_readat_async(). A device implementing the read
+	 * itself provides both. A device passing reads on to another one only
+	 * provides readat_async, as rdev_read_wait() goes straight to the
+	 * device the read ended up on.
+	 */
+	int (*readat_async)(const struct region_device *,
+			struct rdev_async_read *, void *, size_t, size_t);
+	ssize_t (*read_wait)(const struct region_device *,
+			struct rdev_async_read *);
 };
 
 struct region {
@@ -0,0 +1,47 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __SAMPLING_PROFILE_SERIALIZED_H__
+#define __SAMPLING_PROFILE_SERIALIZED_H__
+
+#include <stdint.h>
+
+/* Frames kept per sample, the innermost ones win. */
+#define SAMPLING_PROFILE_MAX_DEPTH	16
+
+/*
+ * One distinct call stack and the number of samples that hit it. pc[0] is
+ * the interrupted instruction, pc[1..depth-1] are return addresses.
+ */
+struct sampling_profile_stack {
+	uint32_t	count;
+	uint32_t	depth;
+	uint32_t	pc[SAMPLING_PROFILE_MAX_DEPTH];
+} __attribute__((packed));
+
+/*
+ * Unused slots of the stack table have a count of 0. Samples that found
+ * the table full are only counted in lost_samples. The PCs are runtime
+ * addresses. load_base is where ramstage's _program was at runtime, which
+ * differs from the ELF when ramstage is relocated into CBMEM.
+ */
+struct sampling_profile {
+	uint32_t	rate_hz;
+	uint32_t	num_samples;
+	uint32_t	lost_samples;
+	uint32_t	num_slots;
+	uint32_t	load_base;
+	struct sampling_profile_stack stacks[0];
+} __attribute__((packed));
+
+#endif
@@ -31,6 +31,23 @@ struct timestamp_table {
 	struct timestamp_entry entries[0]; /* Variable number of entries */
 } __attribute__((packed));
 
+/*
+ * Spans are recorded as a begin and an end entry. Their entry_id holds the
+ * span ID in the lower 16 bits, together with the CPU and thread that
+ * recorded them. Spans on the same CPU and thread nest. Plain timestamps
+ * never set any of the upper bits.
+ */
+#define TS_SPAN_BEGIN		(1U << 31)
+#define TS_SPAN_END		(1U << 30)
+#define TS_SPAN_CPU_SHIFT	22
+#define TS_SPAN_CPU_MASK	0xff
+#define TS_SPAN_THREAD_SHIFT	16
+#define TS_SPAN_THREAD_MASK	0x3f
+#define TS_SPAN_ID_MASK		0xffff
+
+/* Number of CPU indices TS_CLEAR_DRAM_CPU_DONE has an ID for. */
+#define TS_CLEAR_DRAM_NUM_CPUS	256
+
 enum timestamp_id {
 	TS_START_ROMSTAGE = 1,
 	TS_BEFORE_INITRAM = 2,
@@ -56,11 +73,22 @@ enum timestamp_id {
 	TS_DEVICE_DONE = 70,
 	TS_CBMEM_POST = 75,
 	TS_WRITE_TABLES = 80,
+	TS_START_CLEAR_DRAM = 81,
+	TS_END_CLEAR_DRAM = 83,
 	TS_FINALIZE_CHIPS = 85,
 	TS_LOAD_PAYLOAD = 90,
 	TS_ACPI_WAKE_JUMP = 98,
 	TS_SELFBOOT_JUMP = 99,
 
+	/* Spans, one per boot state in boot_state_t order. */
+	TS_SPAN_BOOT_STATE = 100,
+	TS_SPAN_BS_BLOCKED = 115,
+	TS_SPAN_DEV_INIT_THREAD = 116,
+	TS_SPAN_DEV_INIT_WAIT = 117,
+
+	/* 200-455: CPU with the index ID - 200 done clearing DRAM */
+	TS_CLEAR_DRAM_CPU_DONE = 200,
+
 	/* 500+ reserved for vendorcode extensions (500-600: google/chromeos) */
 	TS_START_COPYVER = 501,
 	TS_END_COPYVER = 502,
@@ -142,11 +170,30 @@ static const struct timestamp_id_to_name {
 	{ TS_DEVICE_DONE,	"device setup done" },
 	{ TS_CBMEM_POST,	"cbmem post" },
 	{ TS_WRITE_TABLES,	"write tables" },
+	{ TS_START_CLEAR_DRAM,	"start of DRAM clearing" },
+	{ TS_END_CLEAR_DRAM,	"end of DRAM clearing" },
 	{ TS_FINALIZE_CHIPS,	"finalize chips" },
 	{ TS_LOAD_PAYLOAD,	"load payload" },
 	{ TS_ACPI_WAKE_JUMP,	"ACPI wake jump" },
 	{ TS_SELFBOOT_JUMP,	"selfboot jump" },
 
+	{ TS_SPAN_BOOT_STATE + 0,	"BS_PRE_DEVICE" },
+	{ TS_SPAN_BOOT_STATE + 1,	"BS_DEV_INIT_CHIPS" },
+	{ TS_SPAN_BOOT_STATE + 2,	"BS_DEV_ENUMERATE" },
+	{ TS_SPAN_BOOT_STATE + 3,	"BS_DEV_RESOURCES" },
+	{ TS_SPAN_BOOT_STATE + 4,	"BS_DEV_ENABLE" },
+	{ TS_SPAN_BOOT_STATE + 5,	"BS_DEV_INIT" },
+	{ TS_SPAN_BOOT_STATE + 6,	"BS_POST_DEVICE" },
+	{ TS_SPAN_BOOT_STATE + 7,	"BS_OS_RESUME_CHECK" },
+	{ TS_SPAN_BOOT_STATE + 8,	"BS_OS_RESUME" },
+	{ TS_SPAN_BOOT_STATE + 9,	"BS_WRITE_TABLES" },
+	{ TS_SPAN_BOOT_STATE + 10,	"BS_PAYLOAD_LOAD" },
+	{ TS_SPAN_BOOT_STATE + 11,	"BS_PAYLOAD_BOOT" },
+	{ TS_SPAN_BS_BLOCKED,	"boot state blocked" },
+	{ TS_SPAN_DEV_INIT_THREAD, "device init thread" },
+	{ TS_SPAN_DEV_INIT_WAIT, "waiting for device init" },
+	{ TS_CLEAR_DRAM_CPU_DONE, "BSP done clearing DRAM" },
+
 	{ TS_START_COPYVER,	"starting to load verstage" },
 	{ TS_END_COPYVER,	"finished loading verstage" },
 	{ TS_START_TPMINIT,	"starting to initialize TPM" },
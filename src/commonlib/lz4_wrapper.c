@@ -129,65 +129,91 @@ struct lz4_block_header {
 	/* + uint32_t block_checksum iff has_block_checksum is set */
 } __attribute__((packed));
 
+size_t ulz4f_header(const void *src, size_t srcn, int *has_block_checksum)
+{
+	const struct lz4_frame_header *h = src;
+	size_t size;
+
+	if (srcn < sizeof(*h) + sizeof(uint64_t) + sizeof(uint8_t))
+		return 0;	/* input overrun */
+
+	/* We assume there's always only a single, standard frame. */
+	if (read_le32(&h->magic) != LZ4F_MAGICNUMBER || h->version != 1)
+		return 0;	/* unknown format */
+	if (h->reserved0 || h->reserved1 || h->reserved2)
+		return 0;	/* reserved must be zero */
+	if (!h->independent_blocks)
+		return 0;	/* we don't support block dependency */
+	*has_block_checksum = h->has_block_checksum;
+
+	size = sizeof(*h);
+	if (h->has_content_size)
+		size += sizeof(uint64_t);
+	size += sizeof(uint8_t);
+
+	return size;
+}
+
+size_t ulz4f_block_header(const void *src, int *not_compressed)
+{
+	struct lz4_block_header b = { { .raw = read_le32(src) } };
+
+	*not_compressed = b.not_compressed;
+	return b.size;
+}
+
+int ulz4f_block(const void *src, size_t srcn, int not_compressed,
+		void *dst, size_t dstn)
+{
+	if (not_compressed) {
+		if (srcn > dstn)
+			return -1;	/* output overrun */
+		memcpy(dst, src, srcn);
+		return srcn;
+	}
+
+	/* constant folding essential, do not touch params! */
+	return LZ4_decompress_generic(src, dst, srcn, dstn, endOnInputSize,
+				      full, 0, noDict, dst, NULL, 0);
+}
+
 size_t ulz4fn(const void *src, size_t srcn, void *dst, size_t dstn)
 {
 	const void *in = src;
 	void *out = dst;
 	size_t out_size = 0;
+	size_t header_size;
 	int has_block_checksum;
 
-	{ /* With in-place decompression the header may become invalid later. */
-		const struct lz4_frame_header *h = in;
-
-		if (srcn < sizeof(*h) + sizeof(uint64_t) + sizeof(uint8_t))
-			return 0;	/* input overrun */
-
-		/* We assume there's always only a single, standard frame. */
-		if (read_le32(&h->magic) != LZ4F_MAGICNUMBER || h->version != 1)
-			return 0;	/* unknown format */
-		if (h->reserved0 || h->reserved1 || h->reserved2)
-			return 0;	/* reserved must be zero */
-		if (!h->independent_blocks)
-			return 0;	/* we don't support block dependency */
-		has_block_checksum = h->has_block_checksum;
-
-		in += sizeof(*h);
-		if (h->has_content_size)
-			in += sizeof(uint64_t);
-		in += sizeof(uint8_t);
-	}
+	/* With in-place decompression the header may become invalid later. */
+	header_size = ulz4f_header(in, srcn, &has_block_checksum);
+	if (!header_size)
+		return 0;
+	in += header_size;
 
 	while (1) {
-		struct lz4_block_header b = { { .raw = read_le32(in) } };
+		int not_compressed;
+		size_t size = ulz4f_block_header(in, &not_compressed);
+		int ret;
+
 		in += sizeof(struct lz4_block_header);
 
-		if ((size_t)(in - src) + b.size > srcn)
+		if ((size_t)(in - src) + size > srcn)
 			break;			/* input overrun */
 
-		if (!b.size) {
+		if (!size) {
 			out_size = out - dst;
 			break;			/* decompression successful */
 		}
 
-		if (b.not_compressed) {
-			size_t size = MIN((uintptr_t)b.size, (uintptr_t)dst + dstn - (uintptr_t)out);
-			memcpy(out, in, size);
-			if (size < b.size)
-				break;		/* output overrun */
-			else
-				out += size;
-		} else {
-			/* constant folding essential, do not touch params! */
-			int ret = LZ4_decompress_generic(in, out, b.size,
-					dst + dstn - out, endOnInputSize,
-					full, 0, noDict, out, NULL, 0);
-			if (ret < 0)
-				break;		/* decompression error */
-			else
-				out += ret;
-		}
+		ret = ulz4f_block(in, size, not_compressed, out,
+				  dst + dstn - out);
+		if (ret < 0)
+			break;			/* decompression error */
+		else
+			out += ret;
 
-		in += b.size;
+		in += size;
 		if (has_block_checksum)
 			in += sizeof(uint32_t);
 	}
@@ -109,6 +109,43 @@ ssize_t rdev_readat(const struct region_device *rd, void *b, size_t offset,
 	return rdev->ops->readat(rdev, b, req.offset, req.size);
 }
 
+int rdev_readat_async(const struct region_device *rd,
+			struct rdev_async_read *req, void *b, size_t offset,
+			size_t size)
+{
+	const struct region_device *rdev;
+	struct region r = {
+		.offset = offset,
+		.size = size,
+	};
+
+	if (!normalize_and_ok(&rd->region, &r))
+		return -1;
+
+	rdev = rdev_root(rd);
+
+	/* A device passing the read on to another one sets req->rdev to
+	 * that one when starting it there. */
+	req->rdev = rdev;
+
+	if (rdev->ops->readat_async != NULL)
+		return rdev->ops->readat_async(rdev, req, b, r.offset, r.size);
+
+	req->result = rdev->ops->readat(rdev, b, r.offset, r.size);
+
+	return 0;
+}
+
+ssize_t rdev_read_wait(struct rdev_async_read *req)
+{
+	const struct region_device *rdev = req->rdev;
+
+	if (rdev->ops->read_wait != NULL)
+		return rdev->ops->read_wait(rdev, req);
+
+	return req->result;
+}
+
 ssize_t rdev_writeat(const struct region_device *rd, const void *b,
 			size_t offset, size_t size)
 {
@@ -386,6 +423,26 @@ static ssize_t xlate_readat(const struct region_device *rd, void *b,
 	return rdev_readat(xldev->access_dev, b, offset, size);
 }
 
+static int xlate_readat_async(const struct region_device *rd,
+				struct rdev_async_read *async, void *b,
+				size_t offset, size_t size)
+{
+	struct region req = {
+		.offset = offset,
+		.size = size,
+	};
+	const struct xlate_region_device *xldev;
+
+	xldev = container_of(rd, __typeof__(*xldev), rdev);
+
+	if (!is_subregion(&xldev->sub_region, &req))
+		return -1;
+
+	offset -= region_offset(&xldev->sub_region);
+
+	return rdev_readat_async(xldev->access_dev, async, b, offset, size);
+}
+
 static ssize_t xlate_writeat(const struct region_device *rd, const void *b,
 				size_t offset, size_t size)
 {
@@ -428,12 +485,14 @@ const struct region_device_ops xlate_rdev_ro_ops = {
 	.mmap = xlate_mmap,
 	.munmap = xlate_munmap,
 	.readat = xlate_readat,
+	.readat_async = xlate_readat_async,
 };
 
 const struct region_device_ops xlate_rdev_rw_ops = {
 	.mmap = xlate_mmap,
 	.munmap = xlate_munmap,
 	.readat = xlate_readat,
+	.readat_async = xlate_readat_async,
 	.writeat = xlate_writeat,
 	.eraseat = xlate_eraseat,
 };
@@ -468,6 +527,17 @@ static ssize_t incoherent_readat(const struct region_device *rd, void *b,
 	return rdev_readat(irdev->read, b, offset, size);
 }
 
+static int incoherent_readat_async(const struct region_device *rd,
+				struct rdev_async_read *async, void *b,
+				size_t offset, size_t size)
+{
+	const struct incoherent_rdev *irdev;
+
+	irdev = container_of(rd, const struct incoherent_rdev, rdev);
+
+	return rdev_readat_async(irdev->read, async, b, offset, size);
+}
+
 static ssize_t incoherent_writeat(const struct region_device *rd, const void *b,
 			size_t offset, size_t size)
 {
@@ -492,6 +562,7 @@ static const struct region_device_ops incoherent_rdev_ops = {
 	.mmap = incoherent_mmap,
 	.munmap = incoherent_munmap,
 	.readat = incoherent_readat,
+	.readat_async = incoherent_readat_async,
 	.writeat = incoherent_writeat,
 	.eraseat = incoherent_eraseat,
 };
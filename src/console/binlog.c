@@ -0,0 +1,205 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <commonlib/console_binlog_serialized.h>
+#include <console/binlog.h>
+#include <console/cbmem_console.h>
+#include <string.h>
+#include <symbols.h>
+
+#if __CONSOLE_BINLOG_ENABLE__
+
+/*
+ * Walk the format string the same way vtxprintf() does and store the raw
+ * arguments instead of printing them. util/cbmem does the formatting.
+ */
+
+#define is_digit(c)	((c) >= '0' && (c) <= '9')
+
+#if ENV_BOOTBLOCK
+#define BINLOG_STAGE	CONSOLE_BINLOG_BOOTBLOCK
+#elif ENV_VERSTAGE
+#define BINLOG_STAGE	CONSOLE_BINLOG_VERSTAGE
+#elif ENV_ROMSTAGE
+#define BINLOG_STAGE	CONSOLE_BINLOG_ROMSTAGE
+#elif ENV_POSTCAR
+#define BINLOG_STAGE	CONSOLE_BINLOG_POSTCAR
+#else
+#define BINLOG_STAGE	CONSOLE_BINLOG_RAMSTAGE
+#endif
+
+struct binlog_buffer {
+	struct console_binlog_record rec;
+	u8 args[CONSOLE_BINLOG_MAX_ARGS];
+	size_t size;
+};
+
+static int put(struct binlog_buffer *b, const void *data, size_t size)
+{
+	if (size > sizeof(b->args) - b->size)
+		return -1;
+
+	memcpy(&b->args[b->size], data, size);
+	b->size += size;
+	return 0;
+}
+
+static int put32(struct binlog_buffer *b, u32 val)
+{
+	return put(b, &val, sizeof(val));
+}
+
+static int put64(struct binlog_buffer *b, u64 val)
+{
+	return put(b, &val, sizeof(val));
+}
+
+static int put_string(struct binlog_buffer *b, const char *s, int precision)
+{
+	size_t len;
+
+	if (!s)
+		s = "<NULL>";
+
+	len = strnlen(s, (size_t)precision);
+
+	if (put(b, s, len))
+		return -1;
+
+	return put(b, "", 1);
+}
+
+static int encode_args(struct binlog_buffer *b, const char *fmt, va_list args)
+{
+	int precision;
+	int qualifier;
+	int ret = 0;
+
+	for (; *fmt && !ret; ++fmt) {
+		if (*fmt != '%')
+			continue;
+
+		/* flags */
+		do {
+			++fmt;
+		} while (*fmt == '-' || *fmt == '+' || *fmt == ' ' ||
+			 *fmt == '#' || *fmt == '0');
+
+		/* field width */
+		if (is_digit(*fmt)) {
+			while (is_digit(*fmt))
+				++fmt;
+		} else if (*fmt == '*') {
+			++fmt;
+			ret |= put32(b, va_arg(args, int));
+		}
+
+		/* precision */
+		precision = -1;
+		if (*fmt == '.') {
+			++fmt;
+			if (is_digit(*fmt)) {
+				precision = 0;
+				while (is_digit(*fmt))
+					precision = precision * 10 + *fmt++ - '0';
+			} else if (*fmt == '*') {
+				++fmt;
+				precision = va_arg(args, int);
+				ret |= put32(b, precision);
+			}
+			if (precision < 0)
+				precision = 0;
+		}
+
+		/* qualifier */
+		qualifier = -1;
+		if (*fmt == 'h' || *fmt == 'l' || *fmt == 'L' || *fmt == 'z') {
+			qualifier = *fmt;
+			++fmt;
+			if (*fmt == 'l') {
+				qualifier = 'L';
+				++fmt;
+			}
+			if (*fmt == 'h') {
+				qualifier = 'H';
+				++fmt;
+			}
+		}
+
+		switch (*fmt) {
+		case 'c': {
+			u8 c = va_arg(args, int);
+			ret |= put(b, &c, sizeof(c));
+			break;
+		}
+		case 's':
+			ret |= put_string(b, va_arg(args, char *), precision);
+			break;
+		case 'p': {
+			u8 ptr_size = sizeof(void *);
+			ret |= put(b, &ptr_size, sizeof(ptr_size));
+			ret |= put64(b, (unsigned long)va_arg(args, void *));
+			break;
+		}
+		case 'n':
+			/* Needs the formatted length, can't be deferred. */
+			return -1;
+		case 'o':
+		case 'X':
+		case 'x':
+		case 'd':
+		case 'i':
+		case 'u':
+			if (qualifier == 'L')
+				ret |= put64(b, va_arg(args, unsigned long long));
+			else if (qualifier == 'l')
+				ret |= put64(b, va_arg(args, unsigned long));
+			else if (qualifier == 'z')
+				ret |= put64(b, va_arg(args, size_t));
+			else
+				ret |= put32(b, va_arg(args, unsigned int));
+			break;
+		case '\0':
+			--fmt;
+			break;
+		default:
+			break;
+		}
+	}
+
+	return ret;
+}
+
+int console_binlog(int msg_level, const char *fmt, va_list args)
+{
+	struct binlog_buffer b;
+
+	/* Only strings in the stage itself can be looked up later. */
+	if ((const u8 *)fmt < _program || (const u8 *)fmt >= _eprogram)
+		return -1;
+
+	b.size = 0;
+	if (encode_args(&b, fmt, args))
+		return -1;
+
+	b.rec.marker = CONSOLE_BINLOG_MARKER;
+	b.rec.stage_level = (BINLOG_STAGE << 4) | (msg_level & 0xf);
+	b.rec.args_size = b.size;
+	b.rec.fmt_offset = (const u8 *)fmt - _program;
+
+	cbmemc_write(&b, sizeof(b.rec) + b.size);
+
+	return sizeof(b.rec) + b.size;
+}
+
+#endif /* __CONSOLE_BINLOG_ENABLE__ */
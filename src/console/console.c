@@ -15,6 +15,7 @@
 
 #include <console/cbmem_console.h>
 #include <console/ne2k.h>
+#include <console/profile.h>
 #include <console/qemu_debugcon.h>
 #include <console/spkmodem.h>
 #include <console/streams.h>
@@ -35,31 +36,72 @@ void console_hw_init(void)
 	__spiconsole_init();
 }
 
+/*
+ * Only the drivers that are built in are called and timed. Each driver is
+ * timed from where the previous one ended, so profiling a byte reads one
+ * timestamp per driver plus the one to start from.
+ */
+#define CONSOLE_PROFILE_CALL(driver, enabled, bytes, ts, call)		\
+	do {								\
+		if (!(enabled))						\
+			break;						\
+		call;							\
+		ts = console_profile_driver(driver, ts, bytes);		\
+	} while (0)
+
+#define SPKMODEM_ENABLED (IS_ENABLED(CONFIG_SPKMODEM) && \
+			  (ENV_ROMSTAGE || ENV_RAMSTAGE))
+#define QEMU_DEBUGCON_ENABLED (IS_ENABLED(CONFIG_CONSOLE_QEMU_DEBUGCON) && \
+			       (ENV_ROMSTAGE || ENV_RAMSTAGE))
+#define NE2K_ENABLED (IS_ENABLED(CONFIG_CONSOLE_NE2K) && \
+		      (ENV_ROMSTAGE || ENV_RAMSTAGE))
+
 void console_tx_byte(unsigned char byte)
 {
-	__cbmemc_tx_byte(byte);
-	__spkmodem_tx_byte(byte);
-	__qemu_debugcon_tx_byte(byte);
+	uint64_t ts = console_profile_start();
+
+	CONSOLE_PROFILE_CALL(CONSOLE_PROFILE_CBMEM, __CBMEM_CONSOLE_ENABLE__,
+			     1, ts, __cbmemc_tx_byte(byte));
+	CONSOLE_PROFILE_CALL(CONSOLE_PROFILE_SPKMODEM, SPKMODEM_ENABLED,
+			     1, ts, __spkmodem_tx_byte(byte));
+	CONSOLE_PROFILE_CALL(CONSOLE_PROFILE_QEMU_DEBUGCON,
+			     QEMU_DEBUGCON_ENABLED, 1, ts,
+			     __qemu_debugcon_tx_byte(byte));
 
 	/* Some consoles want newline conversion
 	 * to keep terminals happy.
 	 */
 	if (byte == '\n') {
-		__uart_tx_byte('\r');
-		__usb_tx_byte('\r');
+		CONSOLE_PROFILE_CALL(CONSOLE_PROFILE_UART,
+				     __CONSOLE_SERIAL_ENABLE__, 1, ts,
+				     __uart_tx_byte('\r'));
+		CONSOLE_PROFILE_CALL(CONSOLE_PROFILE_USB,
+				     __CONSOLE_USB_ENABLE__, 1, ts,
+				     __usb_tx_byte('\r'));
 	}
 
-	__uart_tx_byte(byte);
-	__ne2k_tx_byte(byte);
-	__usb_tx_byte(byte);
-	__spiconsole_tx_byte(byte);
+	CONSOLE_PROFILE_CALL(CONSOLE_PROFILE_UART, __CONSOLE_SERIAL_ENABLE__,
+			     1, ts, __uart_tx_byte(byte));
+	CONSOLE_PROFILE_CALL(CONSOLE_PROFILE_NE2K, NE2K_ENABLED,
+			     1, ts, __ne2k_tx_byte(byte));
+	CONSOLE_PROFILE_CALL(CONSOLE_PROFILE_USB, __CONSOLE_USB_ENABLE__,
+			     1, ts, __usb_tx_byte(byte));
+	CONSOLE_PROFILE_CALL(CONSOLE_PROFILE_SPI, __CONSOLE_SPI_ENABLE__,
+			     1, ts, __spiconsole_tx_byte(byte));
 }
 
 void console_tx_flush(void)
 {
-	__uart_tx_flush();
-	__ne2k_tx_flush();
-	__usb_tx_flush();
+	uint64_t ts = console_profile_start();
+
+	CONSOLE_PROFILE_CALL(CONSOLE_PROFILE_CBMEM, __CBMEM_CONSOLE_ENABLE__,
+			     0, ts, __cbmemc_tx_flush());
+	CONSOLE_PROFILE_CALL(CONSOLE_PROFILE_UART, __CONSOLE_SERIAL_ENABLE__,
+			     0, ts, __uart_tx_flush());
+	CONSOLE_PROFILE_CALL(CONSOLE_PROFILE_NE2K, NE2K_ENABLED,
+			     0, ts, __ne2k_tx_flush());
+	CONSOLE_PROFILE_CALL(CONSOLE_PROFILE_USB, __CONSOLE_USB_ENABLE__,
+			     0, ts, __usb_tx_flush());
 }
 
 void console_write_line(uint8_t *buffer, size_t number_of_bytes)
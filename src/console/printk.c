@@ -17,7 +17,10 @@
  * blatantly copied from linux/kernel/printk.c
  */
 
+#include <console/binlog.h>
+#include <console/cbmem_console.h>
 #include <console/console.h>
+#include <console/profile.h>
 #include <console/streams.h>
 #include <console/vtxprintf.h>
 #include <smp/spinlock.h>
@@ -25,6 +28,13 @@
 #include <stddef.h>
 #include <trace.h>
 
+#define PRINTK_LOCKLESS_APS \
+	(IS_ENABLED(CONFIG_CONSOLE_CBMEM_LOCKLESS_APS) && ENV_RAMSTAGE)
+
+#if PRINTK_LOCKLESS_APS
+#include <arch/cpu.h>
+#endif
+
 #if (!defined(__PRE_RAM__) && IS_ENABLED(CONFIG_HAVE_ROMSTAGE_CONSOLE_SPINLOCK)) || !IS_ENABLED(CONFIG_HAVE_ROMSTAGE_CONSOLE_SPINLOCK)
 DECLARE_SPIN_LOCK(console_lock)
 #endif
@@ -39,9 +49,17 @@ static void wrap_putchar(unsigned char byte, void *data)
 	do_putchar(byte);
 }
 
+#if PRINTK_LOCKLESS_APS
+static void wrap_cbmemc_putchar(unsigned char byte, void *data)
+{
+	cbmemc_tx_byte(byte);
+}
+#endif
+
 int do_printk(int msg_level, const char *fmt, ...)
 {
 	va_list args;
+	uint64_t start;
 	int i;
 
 	if (!console_log_level(msg_level))
@@ -52,6 +70,18 @@ int do_printk(int msg_level, const char *fmt, ...)
 		return 0;
 #endif
 
+#if PRINTK_LOCKLESS_APS
+	/* APs only log to the CBMEM ring, which doesn't need the console
+	 * lock. */
+	if (cpu_index() != 0) {
+		va_start(args, fmt);
+		i = vtxprintf(wrap_cbmemc_putchar, fmt, args, NULL);
+		va_end(args);
+		cbmemc_tx_flush();
+		return i;
+	}
+#endif
+
 	DISABLE_TRACE;
 #ifdef __PRE_RAM__
 #if IS_ENABLED(CONFIG_HAVE_ROMSTAGE_CONSOLE_SPINLOCK)
@@ -61,12 +91,22 @@ int do_printk(int msg_level, const char *fmt, ...)
 	spin_lock(&console_lock);
 #endif
 
+	start = console_profile_start();
+
 	va_start(args, fmt);
-	i = vtxprintf(wrap_putchar, fmt, args, NULL);
+	i = console_binlog(msg_level, fmt, args);
 	va_end(args);
 
+	if (i < 0) {
+		va_start(args, fmt);
+		i = vtxprintf(wrap_putchar, fmt, args, NULL);
+		va_end(args);
+	}
+
 	console_tx_flush();
 
+	console_profile_level(msg_level, start, i);
+
 #ifdef __PRE_RAM__
 #if IS_ENABLED(CONFIG_HAVE_ROMSTAGE_CONSOLE_SPINLOCK)
 	spin_unlock(romstage_console_lock());
@@ -82,9 +122,19 @@ int do_printk(int msg_level, const char *fmt, ...)
 #if IS_ENABLED (CONFIG_VBOOT)
 void do_printk_va_list(int msg_level, const char *fmt, va_list args)
 {
+	uint64_t start;
+	va_list copy;
+	int i;
+
 	if (!console_log_level(msg_level))
 		return;
-	vtxprintf(wrap_putchar, fmt, args, NULL);
+	start = console_profile_start();
+	va_copy(copy, args);
+	i = console_binlog(msg_level, fmt, copy);
+	va_end(copy);
+	if (i < 0)
+		i = vtxprintf(wrap_putchar, fmt, args, NULL);
 	console_tx_flush();
+	console_profile_level(msg_level, start, i);
 }
 #endif /* CONFIG_VBOOT */
@@ -0,0 +1,142 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <arch/early_variables.h>
+#include <cbmem.h>
+#include <console/profile.h>
+#include <string.h>
+
+/*
+ * The counters are kept local to the stage until CBMEM comes up. From then
+ * on they are accumulated in CBMEM_ID_CONSOLE_PROFILE directly, so that the
+ * table covers romstage, postcar and ramstage once the payload runs.
+ *
+ * All of this is called from within the console, so nothing in here may
+ * print anything.
+ */
+
+static struct console_profile local_profile CAR_GLOBAL;
+static struct console_profile *cbmem_profile CAR_GLOBAL;
+
+static struct console_profile *console_profile_get(void)
+{
+	struct console_profile *profile = car_get_var(cbmem_profile);
+
+	if (profile != NULL)
+		return profile;
+
+	return car_get_var_ptr(&local_profile);
+}
+
+static void counter_add(struct console_profile_counter *c, uint64_t ticks,
+			size_t bytes)
+{
+	c->ticks += ticks;
+	c->calls++;
+	c->bytes += bytes;
+}
+
+uint64_t console_profile_start(void)
+{
+	console_profile_get()->timestamps++;
+	return timestamp_get();
+}
+
+void console_profile_level(int level, uint64_t start, size_t bytes)
+{
+	uint64_t ticks = timestamp_get() - start;
+	struct console_profile *profile = console_profile_get();
+
+	profile->timestamps++;
+
+	if (level < 0 || level >= CONSOLE_PROFILE_NUM_LEVELS)
+		return;
+
+	counter_add(&profile->levels[level], ticks, bytes);
+}
+
+uint64_t console_profile_driver(enum console_profile_driver driver,
+				uint64_t start, size_t bytes)
+{
+	uint64_t now = timestamp_get();
+	struct console_profile *profile = console_profile_get();
+
+	profile->timestamps++;
+	counter_add(&profile->drivers[driver], now - start, bytes);
+
+	return now;
+}
+
+/* Measure what reading a timestamp costs, so cbmem can report the overhead. */
+static uint32_t timestamp_cost(void)
+{
+	uint64_t start = timestamp_get();
+	int i;
+
+	for (i = 0; i < CONSOLE_PROFILE_COST_SAMPLES; i++)
+		timestamp_get();
+
+	return timestamp_get() - start;
+}
+
+static void counters_merge(struct console_profile_counter *dst,
+			   const struct console_profile_counter *src, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		dst[i].ticks += src[i].ticks;
+		dst[i].calls += src[i].calls;
+		dst[i].bytes += src[i].bytes;
+	}
+}
+
+static void console_profile_sync_to_cbmem(int is_recovery)
+{
+	struct console_profile *local = car_get_var_ptr(&local_profile);
+	struct console_profile *profile;
+
+	/* Romstage is the first stage with CBMEM on every boot. A table found
+	 * there was left behind by the boot before a resume. */
+	if (ENV_ROMSTAGE)
+		profile = NULL;
+	else
+		profile = cbmem_find(CBMEM_ID_CONSOLE_PROFILE);
+
+	if (profile == NULL) {
+		profile = cbmem_add(CBMEM_ID_CONSOLE_PROFILE, sizeof(*profile));
+
+		/* Keep counting locally. */
+		if (profile == NULL)
+			return;
+
+		memset(profile, 0, sizeof(*profile));
+		profile->tick_freq_mhz = timestamp_tick_freq_mhz();
+		profile->num_levels = CONSOLE_PROFILE_NUM_LEVELS;
+		profile->num_drivers = CONSOLE_PROFILE_NUM_DRIVERS;
+		profile->timestamp_cost = timestamp_cost();
+	}
+
+	counters_merge(profile->levels, local->levels,
+		       CONSOLE_PROFILE_NUM_LEVELS);
+	counters_merge(profile->drivers, local->drivers,
+		       CONSOLE_PROFILE_NUM_DRIVERS);
+	profile->timestamps += local->timestamps;
+	memset(local, 0, sizeof(*local));
+
+	car_set_var(cbmem_profile, profile);
+}
+
+ROMSTAGE_CBMEM_INIT_HOOK(console_profile_sync_to_cbmem)
+POSTCAR_CBMEM_INIT_HOOK(console_profile_sync_to_cbmem)
+RAMSTAGE_CBMEM_INIT_HOOK(console_profile_sync_to_cbmem)
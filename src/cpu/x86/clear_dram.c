@@ -0,0 +1,274 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <arch/cpu.h>
+#include <bootmem.h>
+#include <bootstate.h>
+#include <console/console.h>
+#include <cpu/x86/mp.h>
+#include <cpu/x86/pae.h>
+#include <device/device.h>
+#include <stdlib.h>
+#include <string.h>
+#include <symbols.h>
+#include <timer.h>
+#include <timestamp.h>
+
+/*
+ * Clear all usable RAM once the memory map is final, i.e. after the coreboot
+ * tables have been written and before the payload is loaded. The RAM is split
+ * into one contiguous share per CPU and the shares are handed to the APs
+ * through the MP job queue. Memory above 4GiB is reached through the 2MiB
+ * PAE window of map_2M_page().
+ */
+
+/* Legacy tables and the real mode IVT live below 1MiB. Leave it alone. */
+#define CLEAR_DRAM_MIN_ADDR	(1 * MiB)
+#define CLEAR_DRAM_MAX_RANGES	32
+#define CLEAR_DRAM_PAGE_SIZE	(2 * MiB)
+#define CLEAR_DRAM_4G		(1ULL << 32)
+/* map_2M_page() remaps 2GiB-4GiB when it maps memory above 4GiB. */
+#define CLEAR_DRAM_PAE_WINDOW	0x80000000UL
+
+struct clear_range {
+	uint64_t base;
+	uint64_t size;
+};
+
+struct clear_share {
+	struct mp_job job;
+	/* Whether the share went to an AP, which needs to be waited for. */
+	int queued;
+	/* Offset and size of the share within all ranges put together. */
+	uint64_t offset;
+	uint64_t size;
+	uint64_t start_ts;
+	uint64_t end_ts;
+};
+
+static struct clear_range ranges[CLEAR_DRAM_MAX_RANGES];
+static int num_ranges;
+static int clear_above_4g;
+static struct clear_share shares[CONFIG_MAX_CPUS];
+
+static int has_movnti(void)
+{
+	return !!(cpuid_edx(1) & (1 << 26));
+}
+
+/* Non-temporal stores don't pull the cleared memory into the caches. */
+static void clear_block(void *start, size_t size)
+{
+	uint32_t *p = start;
+	uint32_t *end = p + size / sizeof(*p);
+
+	if (!has_movnti()) {
+		memset(start, 0, size);
+		return;
+	}
+
+	for (; p + 4 <= end; p += 4)
+		asm volatile (
+			"movnti %1, 0(%0)\n\t"
+			"movnti %1, 4(%0)\n\t"
+			"movnti %1, 8(%0)\n\t"
+			"movnti %1, 12(%0)\n\t"
+			: : "r" (p), "r" (0) : "memory");
+
+	memset(p, 0, start + size - (void *)p);
+	asm volatile ("sfence" : : : "memory");
+}
+
+static void clear_range_part(uint64_t base, uint64_t size)
+{
+	while (size) {
+		uint64_t len;
+		void *virt;
+
+		if (base < CLEAR_DRAM_4G) {
+			len = MIN(size, CLEAR_DRAM_4G - base);
+			clear_block((void *)(uintptr_t)base, len);
+		} else {
+			len = CLEAR_DRAM_PAGE_SIZE -
+				(base & (CLEAR_DRAM_PAGE_SIZE - 1));
+			len = MIN(size, len);
+			virt = map_2M_page(base / CLEAR_DRAM_PAGE_SIZE);
+			if (virt == MAPPING_ERROR)
+				return;
+			clear_block(virt + (base & (CLEAR_DRAM_PAGE_SIZE - 1)),
+				    len);
+		}
+
+		base += len;
+		size -= len;
+	}
+}
+
+/* Runs on any CPU. Must not call into the console, as the PAE window may
+ * hide its MMIO. */
+static void clear_share(void *arg)
+{
+	struct clear_share *share = arg;
+	uint64_t offset = share->offset;
+	uint64_t size = share->size;
+	int i;
+
+	share->start_ts = timestamp_get();
+
+	for (i = 0; i < num_ranges && size; i++) {
+		uint64_t len;
+
+		if (offset >= ranges[i].size) {
+			offset -= ranges[i].size;
+			continue;
+		}
+
+		len = MIN(size, ranges[i].size - offset);
+		clear_range_part(ranges[i].base + offset, len);
+		size -= len;
+		offset = 0;
+	}
+
+	/* Back to identity mapping without paging. */
+	if (clear_above_4g)
+		map_2M_page(0);
+
+	share->end_ts = timestamp_get();
+}
+
+static void add_clear_range(uint64_t base, uint64_t end)
+{
+	if (end <= base)
+		return;
+
+	if (num_ranges == ARRAY_SIZE(ranges)) {
+		printk(BIOS_ERR, "ERROR: Too many ranges, not clearing "
+			"0x%llx-0x%llx\n", base, end - 1);
+		return;
+	}
+
+	ranges[num_ranges].base = base;
+	ranges[num_ranges].size = end - base;
+	num_ranges++;
+}
+
+static int collect_range(const struct range_entry *r, void *arg)
+{
+	const uint64_t prog_base = (uintptr_t)_program;
+	const uint64_t prog_end = (uintptr_t)_eprogram;
+	uint64_t base = range_entry_base(r);
+	uint64_t end = range_entry_end(r);
+
+	if (range_entry_tag(r) != LB_MEM_RAM)
+		return 1;
+
+	base = MAX(base, CLEAR_DRAM_MIN_ADDR);
+
+	if (end > CLEAR_DRAM_4G && !clear_above_4g) {
+		printk(BIOS_ERR, "ERROR: ramstage overlaps the PAE window, "
+			"not clearing memory above 4GiB\n");
+		end = CLEAR_DRAM_4G;
+	}
+
+	/* A ramstage that isn't relocated to CBMEM sits in RAM. */
+	if (base < prog_end && prog_base < end) {
+		add_clear_range(base, prog_base);
+		base = prog_end;
+	}
+	add_clear_range(base, end);
+
+	return 1;
+}
+
+static void clear_dram(void *unused)
+{
+	uint64_t total = 0;
+	uint64_t share_size;
+	uint64_t offset;
+	int num_shares;
+	int i;
+
+	num_ranges = 0;
+	clear_above_4g = (uintptr_t)_eprogram <= CLEAR_DRAM_PAE_WINDOW;
+	bootmem_walk(collect_range, NULL);
+
+	for (i = 0; i < num_ranges; i++)
+		total += ranges[i].size;
+
+	num_shares = MIN(MAX(dev_count_cpu(), 1), ARRAY_SIZE(shares));
+	share_size = ALIGN_UP(DIV_ROUND_UP(total, num_shares),
+			      CLEAR_DRAM_PAGE_SIZE);
+
+	printk(BIOS_INFO, "Clearing %llu MiB of DRAM on %d CPUs\n",
+		total / MiB, num_shares);
+
+	timestamp_add_now(TS_START_CLEAR_DRAM);
+
+	/* The BSP keeps the first share to itself. */
+	offset = share_size;
+	for (i = 1; i < num_shares && offset < total; i++) {
+		shares[i].offset = offset;
+		shares[i].size = MIN(share_size, total - offset);
+		offset += shares[i].size;
+		shares[i].queued = !mp_job_submit(&shares[i].job, clear_share,
+						  &shares[i]);
+	}
+	num_shares = i;
+
+	shares[0].offset = 0;
+	shares[0].size = MIN(share_size, total);
+	shares[0].job.cpu = 0;
+	clear_share(&shares[0]);
+
+	/* The BSP also takes the shares no AP could take. */
+	for (i = 1; i < num_shares; i++) {
+		if (shares[i].queued)
+			continue;
+		shares[i].job.cpu = 0;
+		clear_share(&shares[i]);
+	}
+
+	for (i = 1; i < num_shares; i++) {
+		/* Allow for a slow CPU clearing its share at 100MiB/s. */
+		uint64_t expire_us = shares[i].size / MiB * 10 * USECS_PER_MSEC;
+
+		if (!shares[i].queued)
+			continue;
+		expire_us = MIN(expire_us + USECS_PER_SEC,
+				30 * 60 * (uint64_t)USECS_PER_SEC);
+		if (mp_job_wait(&shares[i].job, expire_us))
+			die("DRAM clearing didn't finish\n");
+	}
+
+	timestamp_add_now(TS_END_CLEAR_DRAM);
+
+	for (i = 0; i < num_shares; i++) {
+		uint64_t ticks = shares[i].end_ts - shares[i].start_ts;
+		int mhz = timestamp_tick_freq_mhz();
+
+		/* One ID per CPU, so the entries tell which CPU took how long. */
+		if (shares[i].job.cpu < TS_CLEAR_DRAM_NUM_CPUS)
+			timestamp_add(TS_CLEAR_DRAM_CPU_DONE +
+				      shares[i].job.cpu, shares[i].end_ts);
+
+		if (ticks == 0 || mhz <= 0)
+			continue;
+
+		/* Bytes per microsecond are MB/s. */
+		printk(BIOS_DEBUG, "CPU %d: cleared %llu MiB at %llu MB/s\n",
+			shares[i].job.cpu, shares[i].size / MiB,
+			shares[i].size * mhz / ticks);
+	}
+}
+
+BOOT_STATE_INIT_ENTRY(BS_WRITE_TABLES, BS_ON_EXIT, clear_dram, NULL);
@@ -893,6 +893,114 @@ static int run_ap_work(mp_callback_t func, long expire_us)
 	return -1;
 }
 
+/*
+ * Every AP has a ring of job pointers that only the BSP adds to and only the
+ * AP itself removes from, so no locking is needed beyond ordering the index
+ * updates against the slot accesses.
+ */
+#define MP_JOB_QUEUE_SIZE 8
+
+struct mp_job_queue {
+	struct mp_job *jobs[MP_JOB_QUEUE_SIZE];
+	/* Jobs submitted and jobs finished. Both only ever increase. */
+	volatile unsigned int head;
+	volatile unsigned int tail;
+	/* Set by the AP once it takes jobs from the queue. */
+	volatile int online;
+} __attribute__((aligned(CACHELINE_SIZE)));
+
+static struct mp_job_queue ap_job_queues[CONFIG_MAX_CPUS];
+static atomic_t jobs_pending;
+/* Set once mp_park_aps() started taking the APs away. */
+static int aps_parked;
+
+static void ap_run_jobs(struct mp_job_queue *q)
+{
+	while (q->tail != q->head) {
+		struct mp_job *job = q->jobs[q->tail % MP_JOB_QUEUE_SIZE];
+
+		job->func(job->arg);
+
+		mfence();
+		atomic_set(&job->done, 1);
+		q->tail++;
+		atomic_dec(&jobs_pending);
+	}
+}
+
+int mp_job_submit(struct mp_job *job, void (*func)(void *arg), void *arg)
+{
+	struct mp_job_queue *q = NULL;
+	unsigned int depth = MP_JOB_QUEUE_SIZE;
+	int cpu = -1;
+	int i;
+
+	if (!IS_ENABLED(CONFIG_PARALLEL_MP_AP_WORK) || aps_parked)
+		return -1;
+
+	/* Pick the AP with the fewest queued jobs, skipping absent ones. */
+	for (i = 1; i <= global_num_aps && i < CONFIG_MAX_CPUS; i++) {
+		struct mp_job_queue *cur = &ap_job_queues[i];
+		unsigned int cur_depth = cur->head - cur->tail;
+
+		if (cur->online && cur_depth < depth) {
+			q = cur;
+			depth = cur_depth;
+			cpu = i;
+		}
+	}
+
+	if (q == NULL)
+		return -1;
+
+	job->func = func;
+	job->arg = arg;
+	atomic_set(&job->done, 0);
+	job->cpu = cpu;
+	atomic_inc(&jobs_pending);
+	q->jobs[q->head % MP_JOB_QUEUE_SIZE] = job;
+	mfence();
+	q->head++;
+
+	return 0;
+}
+
+int mp_job_wait(struct mp_job *job, long expire_us)
+{
+	struct stopwatch sw;
+
+	stopwatch_init_usecs_expire(&sw, expire_us);
+	while (atomic_read(&job->done) == 0) {
+		if (stopwatch_expired(&sw)) {
+			printk(BIOS_ERR, "Job %p on CPU %d timed out.\n",
+				job->func, job->cpu);
+			return -1;
+		}
+		asm ("pause");
+	}
+	mfence();
+
+	return 0;
+}
+
+/* Wait for all submitted jobs to finish. */
+static int wait_for_jobs(long expire_us)
+{
+	struct stopwatch sw;
+
+	stopwatch_init_usecs_expire(&sw, expire_us);
+	while (atomic_read(&jobs_pending) != 0) {
+		if (stopwatch_expired(&sw)) {
+			printk(BIOS_ERR, "%d AP jobs still pending.\n",
+				atomic_read(&jobs_pending));
+			return -1;
+		}
+		asm ("pause");
+	}
+
+	return 0;
+}
+
 static void ap_wait_for_instruction(void)
 {
 	int cur_cpu = cpu_index();
@@ -900,10 +1008,13 @@ static void ap_wait_for_instruction(void)
 	if (!IS_ENABLED(CONFIG_PARALLEL_MP_AP_WORK))
 		return;
 
+	ap_job_queues[cur_cpu].online = 1;
+
 	while (1) {
 		mp_callback_t func = read_callback(&ap_callbacks[cur_cpu]);
 
 		if (func == NULL) {
+			ap_run_jobs(&ap_job_queues[cur_cpu]);
 			asm ("pause");
 			continue;
 		}
@@ -928,6 +1039,11 @@ int mp_run_on_all_cpus(void (*func)(void), long expire_us)
 
 int mp_park_aps(void)
 {
+	/* No new jobs, and don't pull APs away from queued ones. */
+	aps_parked = 1;
+	if (wait_for_jobs(100 * USECS_PER_MSEC))
+		return -1;
+
 	return mp_run_on_aps(park_this_cpu, 10 * USECS_PER_MSEC);
 }
 
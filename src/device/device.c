@@ -43,12 +43,15 @@
 #include <device/device.h>
 #include <device/pci_def.h>
 #include <device/pci_ids.h>
+#include <device/timing.h>
 #include <stdlib.h>
 #include <string.h>
 #include <smp/spinlock.h>
 #if CONFIG_ARCH_X86
 #include <arch/ebda.h>
 #endif
+#include <thread.h>
+#include <timestamp.h>
 #include <timer.h>
 
 /** Linked list of ALL devices */
@@ -216,6 +219,7 @@ static const char * resource2str(struct resource *res)
 static void read_resources(struct bus *bus)
 {
 	struct device *curdev;
+	uint64_t start;
 
 	printk(BIOS_SPEW, "%s %s bus %x link: %d\n", dev_path(bus->dev),
 	       __func__, bus->secondary, bus->link_num);
@@ -234,7 +238,9 @@ static void read_resources(struct bus *bus)
 			continue;
 		}
 		post_log_path(curdev);
+		start = device_timing_start(DEVICE_TIMING_READ_RESOURCES);
 		curdev->ops->read_resources(curdev);
+		device_timing_end(curdev, DEVICE_TIMING_READ_RESOURCES, start);
 
 		/* Read in the resources behind the current device's links. */
 		for (link = curdev->link_list; link; link = link->next)
@@ -836,6 +842,7 @@ static void set_vga_bridge_bits(void)
 void assign_resources(struct bus *bus)
 {
 	struct device *curdev;
+	uint64_t start;
 
 	printk(BIOS_SPEW, "%s assign_resources, bus %d link: %d\n",
 	       dev_path(bus->dev), bus->secondary, bus->link_num);
@@ -850,7 +857,9 @@ void assign_resources(struct bus *bus)
 			continue;
 		}
 		post_log_path(curdev);
+		start = device_timing_start(DEVICE_TIMING_SET_RESOURCES);
 		curdev->ops->set_resources(curdev);
+		device_timing_end(curdev, DEVICE_TIMING_SET_RESOURCES, start);
 	}
 	post_log_clear();
 	printk(BIOS_SPEW, "%s assign_resources, bus %d link: %d\n",
@@ -876,8 +885,14 @@ static void enable_resources(struct bus *link)
 
 	for (dev = link->children; dev; dev = dev->sibling) {
 		if (dev->enabled && dev->ops && dev->ops->enable_resources) {
+			uint64_t start;
+
 			post_log_path(dev);
+			start = device_timing_start(
+				DEVICE_TIMING_ENABLE_RESOURCES);
 			dev->ops->enable_resources(dev);
+			device_timing_end(dev, DEVICE_TIMING_ENABLE_RESOURCES,
+					  start);
 		}
 	}
 
@@ -930,7 +945,11 @@ static void scan_bus(struct device *busdev)
 	do_scan_bus = 1;
 	while (do_scan_bus) {
 		struct bus *link;
+		uint64_t start;
+
+		start = device_timing_start(DEVICE_TIMING_SCAN_BUS);
 		busdev->ops->scan_bus(busdev);
+		device_timing_end(busdev, DEVICE_TIMING_SCAN_BUS, start);
 		do_scan_bus = 0;
 		for (link = busdev->link_list; link; link = link->next) {
 			if (link->reset_needed) {
@@ -1115,6 +1134,107 @@ void dev_enable(void)
 	printk(BIOS_INFO, "done.\n");
 }
 
+#if IS_ENABLED(CONFIG_PARALLEL_DEVICE_INIT)
+#define MAX_INIT_RECORDS 64
+
+/* When each init() ran, in microseconds since dev_initialize() started. */
+struct init_record {
+	struct device *dev;
+	long start;
+	long end;
+};
+
+static struct init_record init_records[MAX_INIT_RECORDS];
+static int num_init_records;
+static int init_threads_running;
+static struct stopwatch init_sw;
+
+static struct init_record *init_record_start(struct device *dev)
+{
+	struct init_record *rec;
+
+	if (num_init_records == ARRAY_SIZE(init_records))
+		return NULL;
+
+	rec = &init_records[num_init_records++];
+	rec->dev = dev;
+	rec->start = stopwatch_duration_usecs(&init_sw);
+	return rec;
+}
+
+static void init_record_end(struct init_record *rec)
+{
+	if (rec != NULL)
+		rec->end = stopwatch_duration_usecs(&init_sw);
+}
+
+/* Print when each init() started and ended to show which ones overlapped. */
+static void init_records_show(void)
+{
+	int i;
+
+	printk(BIOS_DEBUG, "Device init timing (usecs):\n");
+	for (i = 0; i < num_init_records; i++) {
+		struct init_record *rec = &init_records[i];
+
+		printk(BIOS_DEBUG, "  %-30s %8ld - %8ld (%ld)%s\n",
+		       dev_path(rec->dev), rec->start, rec->end,
+		       rec->end - rec->start,
+		       rec->dev->ops->init_in_thread ? " threaded" : "");
+	}
+}
+#endif
+
+static void run_init(struct device *dev)
+{
+#if IS_ENABLED(CONFIG_PARALLEL_DEVICE_INIT)
+	struct init_record *rec = init_record_start(dev);
+#endif
+	uint64_t start;
+#if CONFIG_HAVE_MONOTONIC_TIMER
+	struct stopwatch sw;
+	stopwatch_init(&sw);
+#endif
+	if (dev->path.type == DEVICE_PATH_I2C) {
+		printk(BIOS_DEBUG, "smbus: %s[%d]->",
+		       dev_path(dev->bus->dev), dev->bus->link_num);
+	}
+
+	printk(BIOS_DEBUG, "%s init ...\n", dev_path(dev));
+	start = device_timing_start(DEVICE_TIMING_INIT);
+	dev->ops->init(dev);
+	device_timing_end(dev, DEVICE_TIMING_INIT, start);
+#if CONFIG_HAVE_MONOTONIC_TIMER
+	printk(BIOS_DEBUG, "%s init finished in %ld usecs\n", dev_path(dev),
+		stopwatch_duration_usecs(&sw));
+#endif
+#if IS_ENABLED(CONFIG_PARALLEL_DEVICE_INIT)
+	init_record_end(rec);
+#endif
+	dev->init_done = 1;
+}
+
+#if IS_ENABLED(CONFIG_PARALLEL_DEVICE_INIT)
+static void init_dev_thread(void *arg)
+{
+	timestamp_span_begin(TS_SPAN_DEV_INIT_THREAD);
+	run_init(arg);
+	timestamp_span_end(TS_SPAN_DEV_INIT_THREAD);
+	init_threads_running--;
+}
+#endif
+
+void dev_wait_for_init(struct device *dev)
+{
+	if (!dev->initialized || dev->init_done)
+		return;
+
+	timestamp_span_begin(TS_SPAN_DEV_INIT_WAIT);
+	while (!dev->init_done)
+		thread_yield();
+	timestamp_span_end(TS_SPAN_DEV_INIT_WAIT);
+}
+
 /**
  * Initialize a specific device.
  *
@@ -1130,22 +1250,21 @@ static void init_dev(struct device *dev)
 		return;
 
 	if (!dev->initialized && dev->ops && dev->ops->init) {
-#if CONFIG_HAVE_MONOTONIC_TIMER
-		struct stopwatch sw;
-		stopwatch_init(&sw);
-#endif
-		if (dev->path.type == DEVICE_PATH_I2C) {
-			printk(BIOS_DEBUG, "smbus: %s[%d]->",
-			       dev_path(dev->bus->dev), dev->bus->link_num);
-		}
-
-		printk(BIOS_DEBUG, "%s init ...\n", dev_path(dev));
 		dev->initialized = 1;
-		dev->ops->init(dev);
-#if CONFIG_HAVE_MONOTONIC_TIMER
-		printk(BIOS_DEBUG, "%s init finished in %ld usecs\n", dev_path(dev),
-			stopwatch_duration_usecs(&sw));
+
+		/* Parents may still be busy in a thread of their own. */
+		if (dev->bus != NULL && dev->bus->dev != dev)
+			dev_wait_for_init(dev->bus->dev);
+
+#if IS_ENABLED(CONFIG_PARALLEL_DEVICE_INIT)
+		if (dev->ops->init_in_thread) {
+			init_threads_running++;
+			if (thread_run(init_dev_thread, dev) == 0)
+				return;
+			init_threads_running--;
+		}
 #endif
+		run_init(dev);
 	}
 }
 
@@ -1171,6 +1290,11 @@ static void init_link(struct bus *link)
  *
  * Starting at the root device, call the device's init() method to do
  * device-specific setup, then call each child's init() method.
+ *
+ * With PARALLEL_DEVICE_INIT, devices that set init_in_thread in their
+ * operations get their init() method called in a thread of their own. It
+ * runs until it waits in udelay(), then the next device is initialized. A
+ * device is always initialized after its parent has finished.
  */
 void dev_initialize(void)
 {
@@ -1178,6 +1302,10 @@ void dev_initialize(void)
 
 	printk(BIOS_INFO, "Initializing devices...\n");
 
+#if IS_ENABLED(CONFIG_PARALLEL_DEVICE_INIT)
+	stopwatch_init(&init_sw);
+#endif
+
 #if CONFIG_ARCH_X86
 	/* Ensure EBDA is prepared before Option ROMs. */
 	setup_default_ebda();
@@ -1189,6 +1317,16 @@ void dev_initialize(void)
 	/* Now initialize everything. */
 	for (link = dev_root.link_list; link; link = link->next)
 		init_link(link);
+
+#if IS_ENABLED(CONFIG_PARALLEL_DEVICE_INIT)
+	if (init_threads_running) {
+		timestamp_span_begin(TS_SPAN_DEV_INIT_WAIT);
+		while (init_threads_running)
+			thread_yield();
+		timestamp_span_end(TS_SPAN_DEV_INIT_WAIT);
+	}
+	init_records_show();
+#endif
 	post_log_clear();
 
 	printk(BIOS_INFO, "Devices initialized\n");
@@ -1210,8 +1348,12 @@ static void final_dev(struct device *dev)
 		return;
 
 	if (dev->ops && dev->ops->final) {
+		uint64_t start;
+
 		printk(BIOS_DEBUG, "%s final\n", dev_path(dev));
+		start = device_timing_start(DEVICE_TIMING_FINAL);
 		dev->ops->final(dev);
+		device_timing_end(dev, DEVICE_TIMING_FINAL, start);
 	}
 }
 
@@ -0,0 +1,131 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <bootstate.h>
+#include <cbmem.h>
+#include <console/console.h>
+#include <device/device.h>
+#include <device/timing.h>
+#include <stdlib.h>
+#include <string.h>
+#include <timestamp.h>
+
+/*
+ * The time every device spends in each of its callbacks is collected here
+ * while the device tree is walked. Once all devices are finalized the
+ * numbers are handed to the payload in CBMEM_ID_DEVICE_TIMING.
+ */
+
+#define MAX_TIMED_DEVICES	256
+#define MAX_NESTING		16
+
+struct device_timing {
+	struct device *dev;
+	uint64_t ticks[DEVICE_TIMING_NUM_OPS];
+};
+
+static struct device_timing timings[MAX_TIMED_DEVICES];
+static int num_timings;
+
+/* Time spent in nested callbacks, per nesting level. */
+static uint64_t nested_ticks[MAX_NESTING];
+static int nesting;
+
+static struct device_timing *device_timing_get(struct device *dev)
+{
+	static struct device_timing *last;
+	int i;
+
+	/* Most callbacks are timed one device after the other. */
+	if (last != NULL && last->dev == dev)
+		return last;
+
+	for (i = 0; i < num_timings; i++) {
+		if (timings[i].dev == dev) {
+			last = &timings[i];
+			return last;
+		}
+	}
+
+	if (num_timings == ARRAY_SIZE(timings))
+		return NULL;
+
+	last = &timings[num_timings++];
+	last->dev = dev;
+	return last;
+}
+
+uint64_t device_timing_start(enum device_timing_op op)
+{
+	if (op != DEVICE_TIMING_INIT) {
+		if (nesting < MAX_NESTING)
+			nested_ticks[nesting] = 0;
+		nesting++;
+	}
+
+	return timestamp_get();
+}
+
+void device_timing_end(struct device *dev, enum device_timing_op op,
+		       uint64_t start)
+{
+	uint64_t ticks = timestamp_get() - start;
+	struct device_timing *t;
+
+	if (op != DEVICE_TIMING_INIT && nesting > 0) {
+		nesting--;
+
+		/* Only charge the time not spent in nested callbacks. */
+		if (nesting < MAX_NESTING) {
+			uint64_t nested = nested_ticks[nesting];
+
+			if (nesting > 0)
+				nested_ticks[nesting - 1] += ticks;
+			ticks -= MIN(nested, ticks);
+		}
+	}
+
+	t = device_timing_get(dev);
+	if (t != NULL)
+		t->ticks[op] += ticks;
+}
+
+static void device_timing_save(void *unused)
+{
+	struct device_timing_table *table;
+	size_t size;
+	int i;
+
+	size = sizeof(*table) + num_timings * sizeof(table->entries[0]);
+	table = cbmem_add(CBMEM_ID_DEVICE_TIMING, size);
+
+	if (table == NULL) {
+		printk(BIOS_ERR, "ERROR: No device timing table allocated\n");
+		return;
+	}
+
+	table->tick_freq_mhz = timestamp_tick_freq_mhz();
+	table->num_ops = DEVICE_TIMING_NUM_OPS;
+	table->reserved = 0;
+	table->num_entries = num_timings;
+
+	for (i = 0; i < num_timings; i++) {
+		struct device_timing_entry *e = &table->entries[i];
+
+		strncpy(e->path, dev_path(timings[i].dev), sizeof(e->path));
+		e->path[sizeof(e->path) - 1] = '\0';
+		memcpy(e->ticks, timings[i].ticks, sizeof(e->ticks));
+	}
+}
+
+BOOT_STATE_INIT_ENTRY(BS_WRITE_TABLES, BS_ON_ENTRY, device_timing_save, NULL);
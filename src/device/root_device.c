@@ -19,6 +19,7 @@
  */
 
 #include <console/console.h>
+#include <console/uart.h>
 #include <device/device.h>
 #include <device/pci.h>
 #include <reset.h>
@@ -132,6 +133,7 @@ static void root_dev_scan_bus(device_t bus)
 static void root_dev_reset(struct bus *bus)
 {
 	printk(BIOS_INFO, "Resetting board...\n");
+	uart_buffered_drain();
 	hard_reset();
 }
 
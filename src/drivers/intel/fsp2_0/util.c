@@ -14,6 +14,7 @@
 #include <arch/io.h>
 #include <cbfs.h>
 #include <console/console.h>
+#include <console/uart.h>
 #include <fsp/util.h>
 #include <lib.h>
 #include <reset.h>
@@ -106,6 +107,7 @@ void fsp_handle_reset(uint32_t status)
 		return;
 
 	printk(BIOS_SPEW, "FSP: handling reset type %x\n", status);
+	uart_buffered_drain();
 
 	switch(status) {
 	case FSP_STATUS_RESET_REQUIRED_COLD:
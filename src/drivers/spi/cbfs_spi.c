@@ -65,6 +65,24 @@ static ssize_t spi_readat(const struct region_device *rd, void *b,
 	return size;
 }
 
+static int spi_readat_async(const struct region_device *rd,
+			struct rdev_async_read *req, void *b, size_t offset,
+			size_t size)
+{
+	if (spi_flash_read_async(spi_flash_info, offset, size, b))
+		return -1;
+	req->result = size;
+	return 0;
+}
+
+static ssize_t spi_read_wait(const struct region_device *rd,
+			struct rdev_async_read *req)
+{
+	if (spi_flash_read_wait(spi_flash_info))
+		return -1;
+	return req->result;
+}
+
 static ssize_t spi_writeat(const struct region_device *rd, const void *b,
 				size_t offset, size_t size)
 {
@@ -86,6 +104,8 @@ static const struct region_device_ops spi_ops = {
 	.mmap = mmap_helper_rdev_mmap,
 	.munmap = mmap_helper_rdev_munmap,
 	.readat = spi_readat,
+	.readat_async = spi_readat_async,
+	.read_wait = spi_read_wait,
 	.writeat = spi_writeat,
 	.eraseat = spi_eraseat,
 };
@@ -14,13 +14,69 @@
  * GNU General Public License for more details.
  */
 
+#include <arch/early_variables.h>
 #include <assert.h>
+#include <console/console.h>
 #include <spi-generic.h>
 #include <string.h>
+#include <thread.h>
+
+/* As long as the slowest SPI flash sector erase may take. */
+#define SPI_RESERVATION_TIMEOUT_MS	10000
+
+struct spi_reservation {
+	int active;
+	unsigned int bus;
+	int owner;
+};
+
+static struct spi_reservation spi_reservation CAR_GLOBAL;
+
+void spi_reserve_bus(const struct spi_slave *slave)
+{
+	struct spi_reservation *res = car_get_var_ptr(&spi_reservation);
+
+	res->bus = slave->bus;
+	res->owner = thread_id();
+	res->active = 1;
+}
+
+void spi_unreserve_bus(const struct spi_slave *slave)
+{
+	struct spi_reservation *res = car_get_var_ptr(&spi_reservation);
+
+	res->active = 0;
+}
+
+static int spi_bus_reserved(const struct spi_slave *slave)
+{
+	const struct spi_reservation *res = car_get_var_ptr(&spi_reservation);
+
+	return res->active && res->bus == slave->bus &&
+		res->owner != thread_id();
+}
+
+int spi_wait_for_bus(const struct spi_slave *slave)
+{
+	if (!spi_bus_reserved(slave))
+		return 0;
+
+	if (!wait_ms(SPI_RESERVATION_TIMEOUT_MS, !spi_bus_reserved(slave))) {
+		printk(BIOS_ERR, "SPI: timeout waiting for bus %u\n",
+		       slave->bus);
+		return -1;
+	}
+
+	return 0;
+}
 
 int spi_claim_bus(const struct spi_slave *slave)
 {
 	const struct spi_ctrlr *ctrlr = slave->ctrlr;
+
+	if (spi_wait_for_bus(slave))
+		return -1;
+
 	if (ctrlr && ctrlr->claim_bus)
 		return ctrlr->claim_bus(slave);
 	return 0;
@@ -20,6 +20,7 @@
 #include <spi_flash.h>
 
 #include "spi_flash_internal.h"
+#include <thread.h>
 #include <timer.h>
 
 static struct spi_flash *spi_flash_dev = NULL;
@@ -139,25 +140,23 @@ int spi_flash_cmd_poll_bit(const struct spi_flash *flash, unsigned long timeout,
 			   u8 cmd, u8 poll_bit)
 {
 	const struct spi_slave *spi = &flash->spi;
-	int ret;
+	int ret = 0;
 	u8 status;
-	struct mono_time current, end;
+	long waited;
 
-	timer_monotonic_get(&current);
-	end = current;
-	mono_time_add_msecs(&end, timeout);
+	/* Other threads can't use the flash before the operation is done. */
+	spi_reserve_bus(spi);
+	waited = wait_ms(timeout,
+			 (ret = spi_flash_cmd_read(spi, &cmd, 1, &status, 1)) ||
+			 (status & poll_bit) == 0);
+	spi_unreserve_bus(spi);
 
-	do {
-		ret = spi_flash_cmd_read(spi, &cmd, 1, &status, 1);
-		if (ret)
-			return -1;
-		if ((status & poll_bit) == 0)
-			return 0;
-		timer_monotonic_get(&current);
-	} while (!mono_time_after(&current, &end));
-
-	printk(BIOS_DEBUG, "SF: timeout at %ld msec\n",timeout);
-	return -1;
+	if (!waited) {
+		printk(BIOS_DEBUG, "SF: timeout at %ld msec\n",timeout);
+		return -1;
+	}
+
+	return ret ? -1 : 0;
 }
 
 int spi_flash_cmd_wait_ready(const struct spi_flash *flash,
@@ -371,14 +370,36 @@ struct spi_flash *spi_flash_probe(unsigned int bus, unsigned int cs)
 int spi_flash_read(const struct spi_flash *flash, u32 offset, size_t len,
 		void *buf)
 {
+	if (spi_wait_for_bus(&flash->spi))
+		return -1;
+	return flash->internal_read(flash, offset, len, buf);
+}
+
+int spi_flash_read_async(const struct spi_flash *flash, u32 offset,
+		size_t len, void *buf)
+{
+	if (spi_wait_for_bus(&flash->spi))
+		return -1;
+	if (flash->internal_read_async)
+		return flash->internal_read_async(flash, offset, len, buf);
 	return flash->internal_read(flash, offset, len, buf);
 }
 
+int spi_flash_read_wait(const struct spi_flash *flash)
+{
+	if (flash->internal_read_wait)
+		return flash->internal_read_wait(flash);
+	return 0;
+}
+
 int spi_flash_write(const struct spi_flash *flash, u32 offset, size_t len,
 		const void *buf)
 {
 	int ret;
 
+	if (spi_wait_for_bus(&flash->spi))
+		return -1;
+
 	if (spi_flash_volatile_group_begin(flash))
 		return -1;
 
@@ -394,6 +415,9 @@ int spi_flash_erase(const struct spi_flash *flash, u32 offset, size_t len)
 {
 	int ret;
 
+	if (spi_wait_for_bus(&flash->spi))
+		return -1;
+
 	if (spi_flash_volatile_group_begin(flash))
 		return -1;
 
@@ -407,6 +431,8 @@ int spi_flash_erase(const struct spi_flash *flash, u32 offset, size_t len)
 
 int spi_flash_status(const struct spi_flash *flash, u8 *reg)
 {
+	if (spi_wait_for_bus(&flash->spi))
+		return -1;
 	return flash->internal_status(flash, reg);
 }
 
@@ -0,0 +1,153 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <console/uart.h>
+#include <smp/node.h>
+#include <smp/spinlock.h>
+#include <stdlib.h>
+#include <timer.h>
+
+/*
+ * The ramstage serial console writes into this ring instead of waiting for
+ * the UART. The ring is drained without waiting, as much as the transmit
+ * FIFO takes at a time, at the end of every printk and from the timer queue.
+ * Only when the ring is full does the console wait for the UART again.
+ *
+ * Nothing called with buffer_lock held may udelay(): with COOP_MULTITASKING
+ * that switches threads, and the timer queue callback run by the idle thread
+ * takes buffer_lock too. So waiting for the UART is done by polling here.
+ */
+
+#define BUFFER_SIZE	CONFIG_CONSOLE_SERIAL_BUFFER_SIZE
+
+/* Same as the 8250 drivers, assume the UART is stuck after 50ms per byte. */
+#define SINGLE_CHAR_TIMEOUT_US	(50 * 1000)
+
+static u8 buffer[BUFFER_SIZE];
+/* Free running, the data is at buffer[tail % BUFFER_SIZE] up to head. */
+static size_t head;
+static size_t tail;
+
+#if IS_ENABLED(CONFIG_TIMER_QUEUE)
+static struct timeout_callback drain_timer;
+static int drain_timer_pending;
+#endif
+
+DECLARE_SPIN_LOCK(buffer_lock)
+
+static void drain_burst(void)
+{
+	while (head != tail) {
+		size_t pos = tail % BUFFER_SIZE;
+		size_t len = MIN(head - tail, BUFFER_SIZE - pos);
+		size_t done;
+
+		done = uart_tx_burst(CONFIG_UART_FOR_CONSOLE, &buffer[pos], len);
+		tail += done;
+
+		if (done < len)
+			break;
+	}
+}
+
+/* Wait until at least one byte went out. */
+static void drain_wait(void)
+{
+	struct stopwatch sw;
+	size_t old_tail = tail;
+
+	stopwatch_init_usecs_expire(&sw, SINGLE_CHAR_TIMEOUT_US);
+
+	while (tail == old_tail) {
+		drain_burst();
+		if (stopwatch_expired(&sw)) {
+			/* Give up on the byte, like uart_tx_byte() would. */
+			tail++;
+			break;
+		}
+	}
+}
+
+#if IS_ENABLED(CONFIG_TIMER_QUEUE)
+/* Time it takes to send a full 16 byte FIFO, at 10 bits per character. */
+static unsigned long drain_interval_us(void)
+{
+	return 16 * 10 * (unsigned long)USECS_PER_SEC / default_baudrate();
+}
+
+static void drain_timer_callback(struct timeout_callback *tocb)
+{
+	spin_lock(&buffer_lock);
+
+	drain_burst();
+
+	if (head != tail)
+		timer_sched_callback(&drain_timer, drain_interval_us());
+	else
+		drain_timer_pending = 0;
+
+	spin_unlock(&buffer_lock);
+}
+
+/* The timer queue isn't SMP safe, only schedule from the BSP. */
+static void drain_timer_start(void)
+{
+	if (drain_timer_pending || head == tail)
+		return;
+
+	if (IS_ENABLED(CONFIG_SMP) && !boot_cpu())
+		return;
+
+	drain_timer.callback = drain_timer_callback;
+	if (!timer_sched_callback(&drain_timer, drain_interval_us()))
+		drain_timer_pending = 1;
+}
+#else
+static void drain_timer_start(void) {}
+#endif
+
+void uart_buffered_tx_byte(unsigned char data)
+{
+	spin_lock(&buffer_lock);
+
+	if (head - tail == BUFFER_SIZE)
+		drain_wait();
+
+	buffer[head % BUFFER_SIZE] = data;
+	head++;
+
+	spin_unlock(&buffer_lock);
+}
+
+void uart_buffered_tx_flush(void)
+{
+	spin_lock(&buffer_lock);
+
+	drain_burst();
+	drain_timer_start();
+
+	spin_unlock(&buffer_lock);
+}
+
+void uart_buffered_drain(void)
+{
+	spin_lock(&buffer_lock);
+
+	while (head != tail)
+		drain_wait();
+
+	spin_unlock(&buffer_lock);
+
+	/* The ring is empty, the last bytes may still be in the FIFO. */
+	uart_tx_flush(CONFIG_UART_FOR_CONSOLE);
+}
@@ -48,6 +48,28 @@ static void uart8250_tx_byte(unsigned base_port, unsigned char data)
 	outb(data, base_port + UART8250_TBR);
 }
 
+/* Only write more than one byte when the UART has a working FIFO. */
+static size_t uart8250_tx_burst(unsigned base_port, const u8 *data,
+				size_t len)
+{
+	size_t i;
+
+	if (!uart8250_can_tx_byte(base_port))
+		return 0;
+
+	/* THRE means the whole transmit FIFO is empty. */
+	if ((inb(base_port + UART8250_IIR) & UART8250_IIR_FIFO) !=
+	    UART8250_IIR_FIFO)
+		len = MIN(len, 1);
+	else
+		len = MIN(len, UART8250_TX_FIFO_SIZE);
+
+	for (i = 0; i < len; i++)
+		outb(data[i], base_port + UART8250_TBR);
+
+	return len;
+}
+
 static void uart8250_tx_flush(unsigned base_port)
 {
 	unsigned long int i = FIFO_TIMEOUT;
@@ -117,6 +139,11 @@ void uart_tx_byte(int idx, unsigned char data)
 	uart8250_tx_byte(uart_platform_base(idx), data);
 }
 
+size_t uart_tx_burst(int idx, const u8 *data, size_t len)
+{
+	return uart8250_tx_burst(uart_platform_base(idx), data, len);
+}
+
 unsigned char uart_rx_byte(int idx)
 {
 	return uart8250_rx_byte(uart_platform_base(idx));
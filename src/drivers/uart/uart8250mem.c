@@ -21,6 +21,7 @@
 #include <delay.h>
 #include <rules.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include "uart8250reg.h"
 
 /* Should support 8250, 16450, 16550, 16550A type UARTs */
@@ -67,6 +68,27 @@ static void uart8250_mem_tx_byte(void *base, unsigned char data)
 	uart8250_write(base, UART8250_TBR, data);
 }
 
+/* Only write more than one byte when the UART has a working FIFO. */
+static size_t uart8250_mem_tx_burst(void *base, const u8 *data, size_t len)
+{
+	size_t i;
+
+	if (!uart8250_mem_can_tx_byte(base))
+		return 0;
+
+	/* THRE means the whole transmit FIFO is empty. */
+	if ((uart8250_read(base, UART8250_IIR) & UART8250_IIR_FIFO) !=
+	    UART8250_IIR_FIFO)
+		len = MIN(len, 1);
+	else
+		len = MIN(len, UART8250_TX_FIFO_SIZE);
+
+	for (i = 0; i < len; i++)
+		uart8250_write(base, UART8250_TBR, data[i]);
+
+	return len;
+}
+
 static void uart8250_mem_tx_flush(void *base)
 {
 	unsigned long int i = FIFO_TIMEOUT;
@@ -130,6 +152,14 @@ void uart_tx_byte(int idx, unsigned char data)
 	uart8250_mem_tx_byte(base, data);
 }
 
+size_t uart_tx_burst(int idx, const u8 *data, size_t len)
+{
+	void *base = uart_platform_baseptr(idx);
+	if (!base)
+		return len;
+	return uart8250_mem_tx_burst(base, data, len);
+}
+
 unsigned char uart_rx_byte(int idx)
 {
 	void *base = uart_platform_baseptr(idx);
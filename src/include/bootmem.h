@@ -38,6 +38,14 @@ void bootmem_write_memory_table(struct lb_memory *mem);
 /* Print current range map of boot memory. */
 void bootmem_dump_ranges(void);
 
+typedef int (*range_action_t)(const struct range_entry *r, void *arg);
+
+/*
+ * Call action for every bootmem range in ascending order until it returns 0.
+ * Returns 0 if the walk was stopped early, 1 otherwise.
+ */
+int bootmem_walk(range_action_t action, void *arg);
+
 /* Return 1 if region targets usable RAM, 0 otherwise. */
 int bootmem_region_targets_usable_ram(uint64_t start, uint64_t size);
 
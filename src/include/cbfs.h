@@ -45,8 +45,9 @@ size_t cbfs_boot_load_struct(const char *name, void *buf, size_t buf_size);
 /* Load |in_size| bytes from |rdev| at |offset| to the |buffer_size| bytes
  * large |buffer|, decompressing it according to |compression| in the process.
  * Returns the decompressed file size, or 0 on error.
- * LZMA files will be mapped for decompression. LZ4 files will be decompressed
- * in-place with the buffer size requirements outlined in compression.h. */
+ * LZMA files will be mapped for decompression on memory mapped boot media and
+ * streamed in small windows otherwise. LZ4 files will be decompressed in-place
+ * with the buffer size requirements outlined in compression.h. */
 size_t cbfs_load_and_decompress(const struct region_device *rdev, size_t offset,
 	size_t in_size, void *buffer, size_t buffer_size, uint32_t compression);
 
@@ -73,6 +74,18 @@ struct cbfs_props {
 /* Return < 0 on error otherwise props are filled out accordingly. */
 int cbfs_boot_region_properties(struct cbfs_props *props);
 
+/* Locate file within cbfs using the boot CBFS index. Returns 0 on success,
+ * < 0 if the file doesn't exist and > 0 if cbfs_locate() needs to be used
+ * instead. */
+int cbfs_boot_index_locate(struct cbfsf *fh, const struct region_device *cbfs,
+				const char *name, uint32_t *type);
+/* Fill in the compression attributes of the file fh located by name and type
+ * without reading its metadata. Returns 0 on success, < 0 if the index can't
+ * provide them. */
+int cbfs_boot_index_decompression_info(const struct cbfsf *fh,
+				const char *name, uint32_t *type,
+				uint32_t *algo, size_t *size);
+
 /* Allow external logic to take action prior to locating a program
  * (stage or payload). */
 void cbfs_prepare_program_locate(void);
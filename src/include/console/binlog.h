@@ -0,0 +1,39 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __CONSOLE_BINLOG_H__
+#define __CONSOLE_BINLOG_H__
+
+#include <console/cbmem_console.h>
+#include <console/vtxprintf.h>
+#include <rules.h>
+
+#define __CONSOLE_BINLOG_ENABLE__ \
+	(IS_ENABLED(CONFIG_CONSOLE_CBMEM_BINARY) && (__CBMEM_CONSOLE_ENABLE__))
+
+#if __CONSOLE_BINLOG_ENABLE__
+/*
+ * Store the message as a binary record in the CBMEM console instead of
+ * formatting it. Returns the size of the record, or < 0 when the message
+ * has to be formatted after all. args is consumed either way.
+ */
+int console_binlog(int msg_level, const char *fmt, va_list args);
+#else
+static inline int console_binlog(int msg_level, const char *fmt,
+				 va_list args)
+{
+	return -1;
+}
+#endif
+
+#endif /* __CONSOLE_BINLOG_H__ */
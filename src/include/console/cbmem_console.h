@@ -16,10 +16,14 @@
 #define _CONSOLE_CBMEM_CONSOLE_H_
 
 #include <rules.h>
+#include <stddef.h>
 #include <stdint.h>
 
 void cbmemc_init(void);
 void cbmemc_tx_byte(unsigned char data);
+void cbmemc_tx_flush(void);
+/* Write a block of data, in one go if the console is a ring. */
+void cbmemc_write(const void *data, size_t size);
 
 #define __CBMEM_CONSOLE_ENABLE__	CONFIG_CONSOLE_CBMEM && \
 	(ENV_RAMSTAGE || ENV_VERSTAGE || ENV_POSTCAR  || \
@@ -30,9 +34,11 @@ void cbmemc_tx_byte(unsigned char data);
 #if __CBMEM_CONSOLE_ENABLE__
 static inline void __cbmemc_init(void)	{ cbmemc_init(); }
 static inline void __cbmemc_tx_byte(u8 data)	{ cbmemc_tx_byte(data); }
+static inline void __cbmemc_tx_flush(void)	{ cbmemc_tx_flush(); }
 #else
 static inline void __cbmemc_init(void)	{}
 static inline void __cbmemc_tx_byte(u8 data)	{}
+static inline void __cbmemc_tx_flush(void)	{}
 #endif
 
 void cbmem_dump_console(void);
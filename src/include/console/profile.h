@@ -0,0 +1,51 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __CONSOLE_PROFILE_H__
+#define __CONSOLE_PROFILE_H__
+
+#include <commonlib/console_profile_serialized.h>
+#include <rules.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <timestamp.h>
+
+#if IS_ENABLED(CONFIG_CONSOLE_PROFILE) && \
+	(ENV_ROMSTAGE || ENV_POSTCAR || ENV_RAMSTAGE)
+#define __CONSOLE_PROFILE_ENABLE__	1
+
+/* Return the current timestamp to start timing at. */
+uint64_t console_profile_start(void);
+/* Account the time since start and the bytes printed to a log level. */
+void console_profile_level(int level, uint64_t start, size_t bytes);
+/*
+ * Account the time since start and the bytes sent to a console driver.
+ * Returns the current timestamp, so that it can be the start of the next
+ * driver.
+ */
+uint64_t console_profile_driver(enum console_profile_driver driver,
+				uint64_t start, size_t bytes);
+#else
+#define __CONSOLE_PROFILE_ENABLE__	0
+
+static inline uint64_t console_profile_start(void) { return 0; }
+static inline void console_profile_level(int level, uint64_t start,
+					 size_t bytes) {}
+static inline uint64_t console_profile_driver(
+	enum console_profile_driver driver, uint64_t start, size_t bytes)
+{
+	return start;
+}
+#endif
+
+#endif
@@ -17,6 +17,7 @@
 #define CONSOLE_UART_H
 
 #include <rules.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /* Return the clock frequency UART uses as reference clock for
@@ -45,6 +46,10 @@ void uart_tx_byte(int idx, unsigned char data);
 void uart_tx_flush(int idx);
 unsigned char uart_rx_byte(int idx);
 
+/* Write as many bytes as the UART takes without waiting and return how many
+ * were written. Only needed for CONSOLE_SERIAL_BUFFERED. */
+size_t uart_tx_burst(int idx, const u8 *data, size_t len);
+
 uintptr_t uart_platform_base(int idx);
 
 #if !defined(__ROMCC__)
@@ -59,7 +64,24 @@ void oxford_remap(unsigned int new_base);
 	(ENV_BOOTBLOCK || ENV_ROMSTAGE || ENV_RAMSTAGE || ENV_VERSTAGE || \
 	ENV_POSTCAR || (ENV_SMM && CONFIG_DEBUG_SMI))
 
-#if __CONSOLE_SERIAL_ENABLE__
+#define __CONSOLE_SERIAL_BUFFERED__ \
+	(IS_ENABLED(CONFIG_CONSOLE_SERIAL_BUFFERED) && ENV_RAMSTAGE)
+
+#if __CONSOLE_SERIAL_BUFFERED__
+void uart_buffered_tx_byte(unsigned char data);
+/* Start sending the buffered output without waiting for the UART. */
+void uart_buffered_tx_flush(void);
+/* Wait until all buffered output has been sent. */
+void uart_buffered_drain(void);
+#else
+static inline void uart_buffered_drain(void)	{}
+#endif
+
+#if __CONSOLE_SERIAL_ENABLE__ && __CONSOLE_SERIAL_BUFFERED__
+static inline void __uart_init(void)		{ uart_init(CONFIG_UART_FOR_CONSOLE); }
+static inline void __uart_tx_byte(u8 data)	{ uart_buffered_tx_byte(data); }
+static inline void __uart_tx_flush(void)	{ uart_buffered_tx_flush(); }
+#elif __CONSOLE_SERIAL_ENABLE__
 static inline void __uart_init(void)		{ uart_init(CONFIG_UART_FOR_CONSOLE); }
 static inline void __uart_tx_byte(u8 data)	{ uart_tx_byte(CONFIG_UART_FOR_CONSOLE, data); }
 static inline void __uart_tx_flush(void)	{ uart_tx_flush(CONFIG_UART_FOR_CONSOLE); }
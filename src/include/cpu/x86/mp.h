@@ -136,6 +136,32 @@ int mp_run_on_aps(void (*func)(void), long expire_us);
 /* Like mp_run_on_aps() but also runs func on BSP. */
 int mp_run_on_all_cpus(void (*func)(void), long expire_us);
 
+/*
+ * Jobs let the BSP hand independent pieces of work to idle APs and join them
+ * later, instead of broadcasting one callback to every AP and waiting for all
+ * of them. Each AP has a small queue of jobs and new jobs go to the AP with
+ * the least amount of queued work. Just like the functions above these may
+ * only be used by the BSP, and only with PARALLEL_MP_AP_WORK. The mp_job
+ * object must stay valid until mp_job_wait() returned success for it.
+ */
+struct mp_job {
+	void (*func)(void *arg);
+	void *arg;
+	/* Index of the CPU running the job. */
+	int cpu;
+	atomic_t done;
+};
+
+/*
+ * Queue func(arg) on an AP. Returns < 0 without running the job if no AP can
+ * take it, e.g. because the APs didn't come up, were parked by mp_park_aps()
+ * or have full queues. The caller then needs to run it itself.
+ */
+int mp_job_submit(struct mp_job *job, void (*func)(void *arg), void *arg);
+
+/* Wait for job to finish. Returns < 0 if it didn't finish in expire_us. */
+int mp_job_wait(struct mp_job *job, long expire_us);
+
 /*
  * Park all APs to prepare for OS boot. This is handled automatically
  * by the coreboot infrastructure.
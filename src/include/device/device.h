@@ -69,6 +69,9 @@ struct device_operations {
 	const struct smbus_bus_operations *ops_smbus_bus;
 	const struct pci_bus_operations * (*ops_pci_bus)(device_t dev);
 	const struct pnp_mode_ops *ops_pnp_mode;
+	/* With PARALLEL_DEVICE_INIT, run init() in a thread of its own so
+	 * that it overlaps with other devices' init() while it waits. */
+	int init_in_thread;
 };
 
 /**
@@ -127,6 +130,7 @@ struct device {
 	unsigned int	hdr_type;	/* PCI header type */
 	unsigned int    enabled : 1;	/* set if we should enable the device */
 	unsigned int    initialized : 1; /* set if we have initialized the device */
+	unsigned int    init_done : 1;	/* set once init() has returned */
 	unsigned int    on_mainboard : 1;
 	struct pci_irq_info pci_irq_info[4];
 	u8 command;
@@ -174,6 +178,9 @@ void dev_enumerate(void);
 void dev_configure(void);
 void dev_enable(void);
 void dev_initialize(void);
+/* Wait until init() of dev has finished. init() callbacks running in a thread
+ * use this to order themselves after the devices they depend on. */
+void dev_wait_for_init(struct device *dev);
 void dev_optimize(void);
 void dev_finalize(void);
 void dev_finalize_chips(void);
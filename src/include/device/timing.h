@@ -0,0 +1,42 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __DEVICE_TIMING_H__
+#define __DEVICE_TIMING_H__
+
+#include <commonlib/device_timing_serialized.h>
+#include <stdint.h>
+
+struct device;
+
+#if IS_ENABLED(CONFIG_DEVICE_TIMING)
+/*
+ * Bracket a call to one of the device_operations callbacks of dev. Calls of
+ * the same kind may nest, e.g. through scan_bus() of a bridge. init() is
+ * the exception, it may run in threads and must not nest.
+ */
+uint64_t device_timing_start(enum device_timing_op op);
+void device_timing_end(struct device *dev, enum device_timing_op op,
+		       uint64_t start);
+#else
+static inline uint64_t device_timing_start(enum device_timing_op op)
+{
+	return 0;
+}
+static inline void device_timing_end(struct device *dev,
+				     enum device_timing_op op, uint64_t start)
+{
+}
+#endif
+
+#endif /* __DEVICE_TIMING_H__ */
@@ -22,6 +22,11 @@
 
 /* Defined in src/lib/lzma.c. Returns decompressed size or 0 on error. */
 size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn);
+/* Same as ulzman() but reads the srcn bytes large compressed image at offset
+ * within rdev in small windows instead of requiring a mapping of all of it. */
+struct region_device;
+size_t ulzma_rdev(const struct region_device *rdev, size_t offset,
+			size_t srcn, void *dst, size_t dstn);
 
 /* Defined in src/lib/ramtest.c */
 void ram_check(unsigned long start, unsigned long stop);
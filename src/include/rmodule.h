@@ -60,6 +60,11 @@ struct rmod_stage_load {
 
 /* Both of the following functions return 0 on success, -1 on error. */
 int rmodule_stage_load(struct rmod_stage_load *rsl);
+/*
+ * Only allocate the CBMEM region rmodule_stage_load() would load the stage
+ * to and set it as the program's area. The stage is not loaded.
+ */
+int rmodule_stage_reserve(struct rmod_stage_load *rsl);
 
 struct rmodule {
 	void *location;
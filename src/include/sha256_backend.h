@@ -0,0 +1,64 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __SHA256_BACKEND_H__
+#define __SHA256_BACKEND_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA256_BLOCK_SIZE	64
+#define SHA256_DIGEST_SIZE	32
+
+/*
+ * An accelerated SHA-256 implementation, e.g. CPU instructions or a crypto
+ * engine. A backend only provides the compression function. Padding and
+ * buffering of partial blocks are done by the generic code.
+ */
+struct sha256_backend {
+	const char *name;
+	/* Return non-zero if the backend can be used. Optional. */
+	int (*probe)(void);
+	/* Update the state with num_blocks consecutive 64-byte blocks. */
+	void (*transform)(uint32_t state[8], const uint8_t *data,
+			  size_t num_blocks);
+};
+
+/* Provided by the architecture code. */
+extern const struct sha256_backend sha256_x86_shani_backend;
+extern const struct sha256_backend sha256_armv8_ce_backend;
+
+/*
+ * SoCs with a SHA-256 engine return it here. It is preferred over the CPU
+ * instructions. The default implementation returns NULL.
+ */
+const struct sha256_backend *soc_sha256_backend(void);
+
+/* Return the backend to be used, or NULL if there is none. */
+const struct sha256_backend *sha256_backend_get(void);
+
+struct sha256_ctx {
+	const struct sha256_backend *backend;
+	uint32_t state[8];
+	uint8_t buf[SHA256_BLOCK_SIZE];
+	size_t buf_len;
+	uint64_t total;
+};
+
+/* Returns < 0 if there is no backend, in which case the other functions
+ * must not be called. */
+int sha256_init(struct sha256_ctx *ctx);
+void sha256_update(struct sha256_ctx *ctx, const void *data, size_t len);
+void sha256_final(struct sha256_ctx *ctx, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+#endif /* __SHA256_BACKEND_H__ */
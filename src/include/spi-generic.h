@@ -187,6 +187,31 @@ int spi_claim_bus(const struct spi_slave *slave);
  */
 void spi_release_bus(const struct spi_slave *slave);
 
+/*-----------------------------------------------------------------------
+ * Reserve the bus of a slave for the current thread
+ *
+ * Used while a thread lets others run until the slave has finished an
+ * operation, e.g. while polling a SPI flash for the end of an erase.
+ * Until spi_unreserve_bus() is called, other threads wait for the bus in
+ * spi_claim_bus() and spi_wait_for_bus().
+ *
+ *   slave:	The SPI slave
+ */
+void spi_reserve_bus(const struct spi_slave *slave);
+void spi_unreserve_bus(const struct spi_slave *slave);
+
+/*-----------------------------------------------------------------------
+ * Wait until no other thread has the bus of a slave reserved
+ *
+ * For users that access the slave without claiming the bus first.
+ *
+ *   slave:	The SPI slave
+ *
+ * Returns: 0 if the bus is free, or a negative value if the reservation
+ * timed out.
+ */
+int spi_wait_for_bus(const struct spi_slave *slave);
+
 /*-----------------------------------------------------------------------
  * SPI transfer
  *
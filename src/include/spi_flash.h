@@ -44,6 +44,10 @@ struct spi_flash {
 	int (*internal_erase)(const struct spi_flash *flash, u32 offset,
 				size_t len);
 	int (*internal_status)(const struct spi_flash *flash, u8 *reg);
+	/* Optional, see spi_flash_read_async(). */
+	int (*internal_read_async)(const struct spi_flash *flash, u32 offset,
+				size_t len, void *buf);
+	int (*internal_read_wait)(const struct spi_flash *flash);
 };
 
 void lb_spi_flash(struct lb_header *header);
@@ -65,6 +69,15 @@ int spi_flash_write(const struct spi_flash *flash, u32 offset, size_t len,
 		    const void *buf);
 int spi_flash_erase(const struct spi_flash *flash, u32 offset, size_t len);
 int spi_flash_status(const struct spi_flash *flash, u8 *reg);
+/*
+ * Start a read that may still be in progress when this returns, e.g. through
+ * DMA. spi_flash_read_wait() finishes it and returns its result. Only one such
+ * read can be outstanding and buf must not be touched in between. Drivers
+ * without support for it complete the read here.
+ */
+int spi_flash_read_async(const struct spi_flash *flash, u32 offset,
+			 size_t len, void *buf);
+int spi_flash_read_wait(const struct spi_flash *flash);
 /*
  * Some SPI controllers require exclusive access to SPI flash when volatile
  * operations like erase or write are being performed. In such cases,
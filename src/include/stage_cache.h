@@ -30,6 +30,12 @@ enum {
 void stage_cache_add(int stage_id, const struct prog *stage);
 /* Load the cached stage at given location returning the stage entry point. */
 void stage_cache_load_stage(int stage_id, struct prog *stage);
+/*
+ * Load a stage kept from the previous boot by WARM_BOOT_STAGE_CACHE. The
+ * program's area has to be the memory reserved for the stage on this boot.
+ * Returns 0 on success, < 0 if there is no usable cached stage.
+ */
+int stage_cache_load_warm(int stage_id, struct prog *stage);
 /* Fill in parameters for the external stage cache, if utilized. */
 void stage_cache_external_region(void **base, size_t *size);
 
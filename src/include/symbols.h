@@ -57,6 +57,10 @@ extern u8 _cbfs_cache[];
 extern u8 _ecbfs_cache[];
 #define _cbfs_cache_size (_ecbfs_cache - _cbfs_cache)
 
+extern u8 _cbfs_index[];
+extern u8 _ecbfs_index[];
+#define _cbfs_index_size (_ecbfs_index - _cbfs_index)
+
 extern u8 _payload[];
 extern u8 _epayload[];
 #define _payload_size (_epayload - _payload)
@@ -51,6 +51,9 @@ int thread_run_until(void (*func)(void *), void *arg,
 /* Return 0 on successful yield for the given amount of time, < 0 when thread
  * did not yield. */
 int thread_yield_microseconds(unsigned microsecs);
+/* Let all other runnable threads run once. Return 0 on successful yield, < 0
+ * when thread did not yield. */
+int thread_yield(void);
 
 /* Allow and prevent thread cooperation on current running thread. By default
  * all threads are marked to be cooperative. That means a thread can yield
@@ -59,6 +62,10 @@ int thread_yield_microseconds(unsigned microsecs);
 void thread_cooperate(void);
 void thread_prevent_coop(void);
 
+/* Return the ID of the running thread. 0 is the thread that runs the boot
+ * state machine, and any thread on the APs. */
+int thread_id(void);
+
 static inline void thread_init_cpu_info_non_bsp(struct cpu_info *ci)
 {
 	ci->thread = NULL;
@@ -75,10 +82,42 @@ void arch_prepare_thread(struct thread *t,
 static inline void threads_initialize(void) {}
 static inline int thread_run(void (*func)(void *), void *arg) { return -1; }
 static inline int thread_yield_microseconds(unsigned microsecs) { return -1; }
+static inline int thread_yield(void) { return -1; }
 static inline void thread_cooperate(void) {}
 static inline void thread_prevent_coop(void) {}
+static inline int thread_id(void) { return 0; }
 struct cpu_info;
 static inline void thread_init_cpu_info_non_bsp(struct cpu_info *ci) { }
 #endif
 
+/*
+ * Poll condition until it becomes true or timeout_us microseconds have passed.
+ * Other threads get to run between the polls, so hardware that is slow to
+ * respond doesn't hold up the rest of the boot. Evaluates to the number of
+ * microseconds waited (at least 1) on success, 0 on timeout.
+ */
+#define wait_us(timeout_us, condition)					\
+	({								\
+		long __ret = 0;						\
+		struct stopwatch __sw;					\
+		stopwatch_init_usecs_expire(&__sw, timeout_us);	\
+		while (1) {						\
+			if (condition) {				\
+				stopwatch_tick(&__sw);			\
+				__ret = stopwatch_duration_usecs(&__sw);\
+				if (__ret == 0)				\
+					__ret = 1;			\
+				break;					\
+			}						\
+			if (stopwatch_expired(&__sw))			\
+				break;					\
+			thread_yield();					\
+		}							\
+		__ret;							\
+	})
+
+#define wait_ms(timeout_ms, condition)					\
+	((wait_us((timeout_ms) * USECS_PER_MSEC, condition) +		\
+	  USECS_PER_MSEC - 1) / USECS_PER_MSEC)
+
 #endif /* THREAD_H_ */
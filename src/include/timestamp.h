@@ -17,6 +17,7 @@
 #define __TIMESTAMP_H__
 
 #include <commonlib/timestamp_serialized.h>
+#include <rules.h>
 
 #if CONFIG_COLLECT_TIMESTAMPS && (CONFIG_EARLY_CBMEM_INIT || !defined(__PRE_RAM__))
 /*
@@ -41,6 +42,18 @@ void timestamp_add_now(enum timestamp_id id);
 #define timestamp_add_now(id)
 #endif
 
+#if CONFIG_COLLECT_TIMESTAMPS && CONFIG_TIMESTAMP_SPANS && ENV_RAMSTAGE
+/*
+ * Record the begin or end of a span on the current CPU and thread. Spans
+ * nest, i.e. the span begun last has to be ended first.
+ */
+void timestamp_span_begin(enum timestamp_id id);
+void timestamp_span_end(enum timestamp_id id);
+#else
+static inline void timestamp_span_begin(enum timestamp_id id) {}
+static inline void timestamp_span_end(enum timestamp_id id) {}
+#endif
+
 /* Implemented by the architecture code */
 uint64_t timestamp_get(void);
 uint64_t get_initial_timestamp(void);
@@ -108,6 +108,18 @@ void bootmem_dump_ranges(void)
 	}
 }
 
+int bootmem_walk(range_action_t action, void *arg)
+{
+	const struct range_entry *r;
+
+	memranges_each_entry(r, &bootmem) {
+		if (!action(r, arg))
+			return 0;
+	}
+
+	return 1;
+}
+
 int bootmem_region_targets_usable_ram(uint64_t start, uint64_t size)
 {
 	const struct range_entry *r;
@@ -53,6 +53,13 @@ int cbfs_boot_locate(struct cbfsf *fh, const char *name, uint32_t *type)
 	if (rdev_chain(&rdev, boot_dev, props.offset, props.size))
 		return -1;
 
+	if (IS_ENABLED(CONFIG_CBFS_INDEX) && !ENV_SMM) {
+		int ret = cbfs_boot_index_locate(fh, &rdev, name, type);
+
+		if (ret <= 0)
+			return ret;
+	}
+
 	return cbfs_locate(fh, &rdev, name, type);
 }
 
@@ -86,6 +93,132 @@ int cbfs_locate_file_in_region(struct cbfsf *fh, const char *region_name,
 	return cbfs_locate(fh, &rdev, name, type);
 }
 
+/* Number of bytes to read after loaded to have everything up to want. */
+static size_t lz4_chunk(const void *compr_start, size_t in_size,
+			const void *loaded, const void *want)
+{
+	const void *end = compr_start + in_size;
+
+	if (want > end)
+		want = end;
+
+	return want > loaded ? want - loaded : 0;
+}
+
+/*
+ * Load an LZ4 image to the tail of the buffer like ulz4fn() expects it, but
+ * decompress each block as soon as it has been read instead of waiting for
+ * the whole image. Blocks are read together with the header of the block
+ * following them, so there is one boot device access per block. On boot
+ * devices that support asynchronous reads the next block is read while the
+ * current one is decompressed.
+ */
+static size_t cbfs_load_lz4_pipelined(const struct region_device *rdev,
+	size_t offset, size_t in_size, void *buffer, size_t buffer_size)
+{
+	const int block_timestamps = IS_ENABLED(CONFIG_LZ4_BLOCK_TIMESTAMPS);
+	void *compr_start = buffer + buffer_size - in_size;
+	void *in = compr_start;
+	void *loaded = compr_start;
+	void *out = buffer;
+	struct rdev_async_read req;
+	size_t reading = 0;
+	size_t header_size;
+	size_t trailer;
+	int has_block_checksum;
+	size_t chunk;
+
+	/* The frame header is followed by at least one block header. */
+	chunk = MIN(in_size, LZ4F_MAX_HEADER_SIZE + LZ4F_BLOCK_HEADER_SIZE);
+	if (rdev_readat(rdev, loaded, offset, chunk) != chunk)
+		return 0;
+	loaded += chunk;
+
+	header_size = ulz4f_header(in, chunk, &has_block_checksum);
+	if (!header_size)
+		return 0;
+	in += header_size;
+	trailer = has_block_checksum ? LZ4F_BLOCK_CHECKSUM_SIZE : 0;
+
+	if (!block_timestamps)
+		timestamp_add_now(TS_START_ULZ4F);
+
+	while (1) {
+		void *block_end;
+		int not_compressed;
+		size_t size;
+		int ret;
+
+		if (reading) {
+			if (rdev_read_wait(&req) != reading)
+				return 0;
+			loaded += reading;
+			reading = 0;
+		}
+
+		if (in + LZ4F_BLOCK_HEADER_SIZE > loaded)
+			return 0;	/* input overrun */
+
+		size = ulz4f_block_header(in, &not_compressed);
+		in += LZ4F_BLOCK_HEADER_SIZE;
+
+		if (!size)
+			break;		/* decompression successful */
+
+		if ((size_t)(in - compr_start) + size > in_size)
+			return 0;	/* input overrun */
+
+		/* Fetch this block, its checksum and the next block header,
+		 * unless the previous read brought them in already. */
+		block_end = in + size + trailer;
+		chunk = lz4_chunk(compr_start, in_size, loaded,
+				  block_end + LZ4F_BLOCK_HEADER_SIZE);
+		if (chunk && rdev_readat(rdev, loaded,
+				offset + (loaded - compr_start), chunk) != chunk)
+			return 0;
+		loaded += chunk;
+
+		/* Start reading the next block while this one is being
+		 * decompressed. The output stays below the input. */
+		if (block_end + LZ4F_BLOCK_HEADER_SIZE <= loaded) {
+			int next_not_compressed;
+			size_t next = ulz4f_block_header(block_end,
+							 &next_not_compressed);
+
+			if (next)
+				reading = lz4_chunk(compr_start, in_size,
+					loaded, block_end + next + trailer +
+					2 * LZ4F_BLOCK_HEADER_SIZE);
+			if (reading && rdev_readat_async(rdev, &req, loaded,
+					offset + (loaded - compr_start),
+					reading) < 0)
+				return 0;
+		}
+
+		if (block_timestamps)
+			timestamp_add_now(TS_START_ULZ4F);
+		ret = ulz4f_block(in, size, not_compressed, out,
+				  buffer + buffer_size - out);
+		if (block_timestamps)
+			timestamp_add_now(TS_END_ULZ4F);
+
+		if (ret < 0) {
+			/* Don't leave a read going into the buffer. */
+			if (reading)
+				rdev_read_wait(&req);
+			return 0;	/* decompression error */
+		}
+		out += ret;
+
+		in = block_end;
+	}
+
+	if (!block_timestamps)
+		timestamp_add_now(TS_END_ULZ4F);
+
+	return out - buffer;
+}
+
 size_t cbfs_load_and_decompress(const struct region_device *rdev, size_t offset,
 	size_t in_size, void *buffer, size_t buffer_size, uint32_t compression)
 {
@@ -108,6 +241,10 @@ size_t cbfs_load_and_decompress(const struct region_device *rdev, size_t offset,
 		 * area for in-place decompression. It is the responsibility of
 		 * the caller to ensure that buffer_size is large enough
 		 * (see compression.h, guaranteed by cbfstool for stages). */
+		if (!IS_ENABLED(CONFIG_BOOT_DEVICE_MEMORY_MAPPED))
+			return cbfs_load_lz4_pipelined(rdev, offset, in_size,
+						       buffer, buffer_size);
+
 		void *compr_start = buffer + buffer_size - in_size;
 		if (rdev_readat(rdev, compr_start, offset, in_size) != in_size)
 			return 0;
@@ -123,6 +260,16 @@ size_t cbfs_load_and_decompress(const struct region_device *rdev, size_t offset,
 		if ((ENV_ROMSTAGE || ENV_POSTCAR)
 			&& !IS_ENABLED(CONFIG_COMPRESS_RAMSTAGE))
 			return 0;
+		/* Media which isn't memory mapped would need to be copied in
+		 * full into the mmap cache first. Stream it instead. */
+		if (!IS_ENABLED(CONFIG_BOOT_DEVICE_MEMORY_MAPPED)) {
+			timestamp_add_now(TS_START_ULZMA);
+			out_size = ulzma_rdev(rdev, offset, in_size, buffer,
+						buffer_size);
+			timestamp_add_now(TS_END_ULZMA);
+			return out_size;
+		}
+
 		void *map = rdev_mmap(rdev, offset, in_size);
 		if (map == NULL)
 			return 0;
@@ -182,6 +329,17 @@ void *cbfs_boot_load_stage_by_name(const char *name)
 	return prog_entry(&stage);
 }
 
+static int cbfs_boot_decompression_info(struct cbfsf *fh, const char *name,
+					uint32_t *type, uint32_t *algo,
+					size_t *size)
+{
+	if (IS_ENABLED(CONFIG_CBFS_INDEX) && !ENV_SMM &&
+	    !cbfs_boot_index_decompression_info(fh, name, type, algo, size))
+		return 0;
+
+	return cbfsf_decompression_info(fh, algo, size);
+}
+
 size_t cbfs_boot_load_struct(const char *name, void *buf, size_t buf_size)
 {
 	struct cbfsf fh;
@@ -192,9 +350,9 @@ size_t cbfs_boot_load_struct(const char *name, void *buf, size_t buf_size)
 	if (cbfs_boot_locate(&fh, name, &type) < 0)
 		return 0;
 
-	if (cbfsf_decompression_info(&fh, &compression_algo,
-				     &decompressed_size) < 0
-				     || decompressed_size > buf_size)
+	if (cbfs_boot_decompression_info(&fh, name, &type, &compression_algo,
+					 &decompressed_size) < 0
+					 || decompressed_size > buf_size)
 		return 0;
 
 	return cbfs_load_and_decompress(&fh.data, 0, region_device_sz(&fh.data),
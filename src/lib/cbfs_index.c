@@ -0,0 +1,193 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <arch/early_variables.h>
+#include <cbfs.h>
+#include <cbmem.h>
+#include <console/console.h>
+#include <rules.h>
+#include <smp/node.h>
+#include <string.h>
+#include <symbols.h>
+
+/*
+ * The boot CBFS index is built on the first lookup that finds no valid
+ * index. Pre-RAM stages share it through the CBFS_INDEX() memlayout region
+ * when there is one, otherwise every stage keeps its own copy in BSS. Once
+ * CBMEM is up the index is handed off through CBMEM_ID_CBFS_INDEX so that
+ * later stages reuse it instead of walking the CBFS again.
+ */
+
+DECLARE_OPTIONAL_REGION(cbfs_index);
+
+#if defined(__PRE_RAM__)
+#define USE_CBFS_INDEX_REGION (_cbfs_index_size > 0)
+#else
+#define USE_CBFS_INDEX_REGION 0
+#endif
+
+/* Cache-as-RAM stages can't have BSS. car.ld always provides the region. */
+#if defined(__PRE_RAM__) && IS_ENABLED(CONFIG_CACHE_AS_RAM)
+#define CBFS_INDEX_IN_BSS 0
+#else
+#define CBFS_INDEX_IN_BSS 1
+#endif
+
+#define HAS_CBMEM (ENV_ROMSTAGE || ENV_RAMSTAGE || ENV_POSTCAR)
+
+#if CBFS_INDEX_IN_BSS
+static uint8_t cbfs_index_storage[CONFIG_CBFS_INDEX_SIZE];
+#endif
+static int cbfs_index_in_cbmem CAR_GLOBAL;
+
+/* Multiple processors may run through CBFS code before ramstage on some x86
+ * platforms. Only let the BSP touch the shared index there. */
+static int cbfs_index_should_run(void)
+{
+	if ((!ENV_RAMSTAGE && IS_ENABLED(CONFIG_ARCH_X86)) && !boot_cpu())
+		return 0;
+
+	return 1;
+}
+
+/* Return the storage local to this stage, i.e. the one used before CBMEM is
+ * online. */
+static struct cbfs_index *cbfs_index_local(size_t *size)
+{
+	if (USE_CBFS_INDEX_REGION) {
+		*size = _cbfs_index_size;
+		return car_get_var_ptr((void *)_cbfs_index);
+	}
+
+#if CBFS_INDEX_IN_BSS
+	*size = sizeof(cbfs_index_storage);
+	return (struct cbfs_index *)cbfs_index_storage;
+#else
+	return NULL;
+#endif
+}
+
+static struct cbfs_index *cbfs_index_get(size_t *size)
+{
+	if (HAS_CBMEM && car_get_var(cbfs_index_in_cbmem)) {
+		const struct cbmem_entry *e;
+
+		e = cbmem_entry_find(CBMEM_ID_CBFS_INDEX);
+
+		if (e != NULL) {
+			*size = cbmem_entry_size(e);
+			return cbmem_entry_start(e);
+		}
+	}
+
+	return cbfs_index_local(size);
+}
+
+int cbfs_boot_index_locate(struct cbfsf *fh, const struct region_device *cbfs,
+				const char *name, uint32_t *type)
+{
+	const int verify = IS_ENABLED(CONFIG_CBFS_INDEX_VERIFY);
+	struct cbfs_index *index;
+	size_t size;
+
+	if (!cbfs_index_should_run())
+		return 1;
+
+	index = cbfs_index_get(&size);
+
+	if (index == NULL)
+		return 1;
+
+	if (!cbfs_index_valid(index, cbfs, verify) &&
+	    cbfs_index_build(index, size, cbfs))
+		return 1;
+
+	return cbfs_index_locate(index, fh, cbfs, name, type, verify);
+}
+
+int cbfs_boot_index_decompression_info(const struct cbfsf *fh,
+				const char *name, uint32_t *type,
+				uint32_t *algo, size_t *size)
+{
+	const struct cbfs_index_entry *e;
+	struct cbfs_index *index;
+	size_t index_size;
+	size_t offset;
+
+	/* Attributes are read back from the media in verification mode. */
+	if (IS_ENABLED(CONFIG_CBFS_INDEX_VERIFY) || !cbfs_index_should_run())
+		return -1;
+
+	index = cbfs_index_get(&index_size);
+
+	if (index == NULL || index->magic != CBFS_INDEX_MAGIC)
+		return -1;
+
+	e = cbfs_index_find(index, name, type);
+	if (e == NULL)
+		return -1;
+
+	/* Only trust the entry if it is the file that was located. */
+	offset = region_device_offset(&fh->metadata);
+
+	if (offset != index->cbfs_offset + e->offset ||
+	    e->metadata_size != region_device_sz(&fh->metadata) ||
+	    e->len != region_device_sz(&fh->data))
+		return -1;
+
+	*algo = e->compression;
+	*size = e->decompressed_size;
+	return 0;
+}
+
+static void cbfs_index_sync_to_cbmem(int is_recovery)
+{
+	const struct cbmem_entry *e;
+	struct cbfs_index *index;
+	struct cbfs_index *local;
+	size_t local_size;
+
+	if (!cbfs_index_should_run())
+		return;
+
+	e = cbmem_entry_find(CBMEM_ID_CBFS_INDEX);
+
+	if (e == NULL) {
+		e = cbmem_entry_add(CBMEM_ID_CBFS_INDEX,
+					CONFIG_CBFS_INDEX_SIZE);
+
+		if (e == NULL) {
+			printk(BIOS_ERR, "ERROR: No CBFS index allocated\n");
+			return;
+		}
+
+		index = cbmem_entry_start(e);
+		index->magic = 0;
+
+		/* Hand off whatever has been indexed so far. */
+		local = cbfs_index_local(&local_size);
+		if (local != NULL && local_size <= cbmem_entry_size(e))
+			memcpy(index, local, local_size);
+	} else if (ENV_ROMSTAGE && is_recovery) {
+		/* The index left behind by the previous boot can't be trusted
+		 * as the flash contents may have changed in the meantime. */
+		index = cbmem_entry_start(e);
+		index->magic = 0;
+	}
+
+	car_set_var(cbfs_index_in_cbmem, 1);
+}
+
+ROMSTAGE_CBMEM_INIT_HOOK(cbfs_index_sync_to_cbmem)
+POSTCAR_CBMEM_INIT_HOOK(cbfs_index_sync_to_cbmem)
+RAMSTAGE_CBMEM_INIT_HOOK(cbfs_index_sync_to_cbmem)
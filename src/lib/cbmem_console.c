@@ -18,23 +18,56 @@
 #include <console/uart.h>
 #include <cbmem.h>
 #include <arch/early_variables.h>
+#include <commonlib/cbmem_console_serialized.h>
+#include <rules.h>
 #include <symbols.h>
 #include <string.h>
 
+#define CBMEMC_LOCKLESS (IS_ENABLED(CONFIG_CONSOLE_CBMEM_LOCKLESS_APS) && \
+			 ENV_RAMSTAGE)
+
+#if CBMEMC_LOCKLESS
+#include <arch/cpu.h>
+#include <smp/spinlock.h>
+#endif
+
 /*
  * Structure describing console buffer. It is overlaid on a flat memory area,
  * with body covering the extent of the memory. Once the buffer is
  * full, the cursor keeps going but the data is dropped on the floor. This
  * allows to tell how much data was lost in the process.
+ *
+ * With CONSOLE_CBMEM_RING the body is a ring instead, see
+ * commonlib/cbmem_console_serialized.h for how the cursor is encoded then.
  */
 struct cbmem_console {
 	u32 size;
 	u32 cursor;
 	u8  body[0];
-}  __attribute__ ((__packed__));
+};
 
 static struct cbmem_console *cbmem_console_p CAR_GLOBAL;
 
+/*
+ * In ring buffer mode output is staged here and committed to the ring a line
+ * at a time. With CONSOLE_CBMEM_LOCKLESS_APS every CPU has a line of its own
+ * and lines are committed without holding the console lock.
+ */
+#define CBMEMC_LINE_SIZE	128
+
+#if CBMEMC_LOCKLESS
+#define CBMEMC_NUM_LINES	CONFIG_MAX_CPUS
+#else
+#define CBMEMC_NUM_LINES	1
+#endif
+
+struct cbmemc_line {
+	u32 len;
+	u8 buf[CBMEMC_LINE_SIZE];
+};
+
+static struct cbmemc_line cbmemc_lines[CBMEMC_NUM_LINES] CAR_GLOBAL;
+
 static void copy_console_buffer(struct cbmem_console *old_cons_p,
 	struct cbmem_console *new_cons_p);
 
@@ -59,9 +92,139 @@ static void copy_console_buffer(struct cbmem_console *old_cons_p,
 #else
 #define STATIC_CONSOLE_SIZE CONFIG_CONSOLE_CBMEM_BUFFER_SIZE
 #endif
-static u8 static_console[STATIC_CONSOLE_SIZE];
+static u8 static_console[STATIC_CONSOLE_SIZE] __attribute__((aligned(4)));
+#endif
+
+static struct cbmemc_line *cbmemc_line(void)
+{
+	struct cbmemc_line *lines = car_get_var_ptr(cbmemc_lines);
+	unsigned long index = 0;
+
+#if CBMEMC_LOCKLESS
+	index = cpu_index();
+	if (index >= CBMEMC_NUM_LINES)
+		index = 0;
+#endif
+	return &lines[index];
+}
+
+static u32 cbmemc_cursor_cmpxchg(struct cbmem_console *cons, u32 old, u32 new)
+{
+	volatile u32 *cursor = &cons->cursor;
+
+	if (CBMEMC_LOCKLESS)
+		return __sync_val_compare_and_swap(cursor, old, new);
+
+	*cursor = new;
+	return old;
+}
+
+#if CBMEMC_LOCKLESS
+/*
+ * Lockless writers copy their data after reserving room for it, so a writer
+ * starting the next lap of the ring could overwrite a copy that is still in
+ * progress. Laps are therefore started by one writer at a time, once it is
+ * the only one with a copy outstanding.
+ */
+DECLARE_SPIN_LOCK(cbmemc_lap_lock)
+static int cbmemc_copying;
 #endif
 
+static void cbmemc_copy_begin(void)
+{
+#if CBMEMC_LOCKLESS
+	__sync_fetch_and_add(&cbmemc_copying, 1);
+#endif
+}
+
+static void cbmemc_copy_end(void)
+{
+#if CBMEMC_LOCKLESS
+	__sync_fetch_and_sub(&cbmemc_copying, 1);
+#endif
+}
+
+/* Returns 0 if the cursor needs to be read again before starting a lap. */
+static int cbmemc_lap_ready(int *locked)
+{
+#if CBMEMC_LOCKLESS
+	if (!*locked) {
+		/* Don't keep the writer holding the lock waiting for us. */
+		cbmemc_copy_end();
+		spin_lock(&cbmemc_lap_lock);
+		cbmemc_copy_begin();
+		*locked = 1;
+		return 0;
+	}
+
+	if (*(volatile int *)&cbmemc_copying != 1) {
+		cpu_relax();
+		return 0;
+	}
+#endif
+	return 1;
+}
+
+static void cbmemc_lap_unlock(int locked)
+{
+#if CBMEMC_LOCKLESS
+	if (locked)
+		spin_unlock(&cbmemc_lap_lock);
+#endif
+}
+
+/* Reserve room for the data in the ring, then copy it in. */
+static void cbmemc_ring_write(struct cbmem_console *cons, const u8 *data,
+			      u32 len)
+{
+	u32 old, new, start, first;
+	int locked = 0;
+
+	if (len > cons->size) {
+		data += len - cons->size;
+		len = cons->size;
+	}
+
+	if (len == 0)
+		return;
+
+	cbmemc_copy_begin();
+
+	for (;;) {
+		old = cons->cursor;
+		start = old & CBMEM_CONSOLE_CURSOR_MASK;
+		if (start >= cons->size)
+			start = 0;
+		if ((start == 0 || start + len > cons->size) &&
+		    !cbmemc_lap_ready(&locked))
+			continue;
+		new = start + len;
+		if (new >= cons->size)
+			new = (new - cons->size) | CBMEM_CONSOLE_OVERFLOW;
+		new |= old & CBMEM_CONSOLE_OVERFLOW;
+		if (cbmemc_cursor_cmpxchg(cons, old, new) == old)
+			break;
+	}
+
+	cbmemc_lap_unlock(locked);
+
+	first = cons->size - start;
+	if (first > len)
+		first = len;
+
+	memcpy(cons->body + start, data, first);
+	memcpy(cons->body, data + first, len - first);
+
+	cbmemc_copy_end();
+}
+
+static void cbmemc_line_commit(struct cbmem_console *cons,
+			       struct cbmemc_line *line)
+{
+	cbmemc_ring_write(cons, line->buf, line->len);
+	line->len = 0;
+}
+
 /* flags for init */
 #define CBMEMC_RESET	(1<<0)
 #define CBMEMC_APPEND	(1<<1)
@@ -143,11 +306,73 @@ void cbmemc_tx_byte(unsigned char data)
 	if (!cbm_cons_p)
 		return;
 
+	if (IS_ENABLED(CONFIG_CONSOLE_CBMEM_RING)) {
+		struct cbmemc_line *line = cbmemc_line();
+
+		line->buf[line->len++] = data;
+		if (data == '\n' || line->len == sizeof(line->buf))
+			cbmemc_line_commit(cbm_cons_p, line);
+		return;
+	}
+
 	cursor = cbm_cons_p->cursor++;
 	if (cursor < cbm_cons_p->size)
 		cbm_cons_p->body[cursor] = data;
 }
 
+void cbmemc_tx_flush(void)
+{
+	struct cbmem_console *cbm_cons_p = current_console();
+	struct cbmemc_line *line;
+
+	if (!IS_ENABLED(CONFIG_CONSOLE_CBMEM_RING) || !cbm_cons_p)
+		return;
+
+	line = cbmemc_line();
+	if (line->len)
+		cbmemc_line_commit(cbm_cons_p, line);
+}
+
+void cbmemc_write(const void *data, size_t size)
+{
+	struct cbmem_console *cbm_cons_p = current_console();
+	const u8 *p = data;
+
+	if (!cbm_cons_p)
+		return;
+
+	if (!IS_ENABLED(CONFIG_CONSOLE_CBMEM_RING)) {
+		while (size--)
+			cbmemc_tx_byte(*p++);
+		return;
+	}
+
+	/* Keep the data in order with what is staged already. */
+	cbmemc_tx_flush();
+	cbmemc_ring_write(cbm_cons_p, p, size);
+}
+
+/* Append the old ring to the new one, oldest data first. */
+static void copy_console_ring(struct cbmem_console *old_cons_p,
+	struct cbmem_console *new_cons_p)
+{
+	u32 cursor = old_cons_p->cursor & CBMEM_CONSOLE_CURSOR_MASK;
+
+	if (cursor > old_cons_p->size)
+		cursor = old_cons_p->size;
+
+	if (old_cons_p->cursor & CBMEM_CONSOLE_OVERFLOW) {
+		const char wrap_str[] = "\n\n*** Log wrapped, oldest output lost. ***\n\n";
+
+		cbmemc_ring_write(new_cons_p, (const u8 *)wrap_str,
+				  sizeof(wrap_str) - 1);
+		cbmemc_ring_write(new_cons_p, old_cons_p->body + cursor,
+				  old_cons_p->size - cursor);
+	}
+
+	cbmemc_ring_write(new_cons_p, old_cons_p->body, cursor);
+}
+
 /*
  * Copy the current console buffer (either from the cache as RAM area, or from
  * the static buffer, pointed at by cbmem_console_p) into the CBMEM console
@@ -163,6 +388,11 @@ static void copy_console_buffer(struct cbmem_console *old_cons_p,
 	u32 copy_size, dropped_chars;
 	u32 cursor = new_cons_p->cursor;
 
+	if (IS_ENABLED(CONFIG_CONSOLE_CBMEM_RING)) {
+		copy_console_ring(old_cons_p, new_cons_p);
+		return;
+	}
+
 	if (old_cons_p->cursor < old_cons_p->size)
 		copy_size = old_cons_p->cursor;
 	else
@@ -250,17 +480,35 @@ RAMSTAGE_CBMEM_INIT_HOOK(cbmemc_reinit)
 POSTCAR_CBMEM_INIT_HOOK(cbmemc_reinit)
 
 #if IS_ENABLED(CONFIG_CONSOLE_CBMEM_DUMP_TO_UART)
+static void dump_to_uart(const u8 *data, u32 len)
+{
+	while (len--)
+		uart_tx_byte(0, *data++);
+}
+
 void cbmem_dump_console(void)
 {
 	struct cbmem_console *cbm_cons_p;
-	int cursor;
+	u32 cursor;
 
 	cbm_cons_p = current_console();
 	if (!cbm_cons_p)
 		return;
 
 	uart_init(0);
-	for (cursor = 0; cursor < cbm_cons_p->cursor; cursor++)
-		uart_tx_byte(0, cbm_cons_p->body[cursor]);
+
+	cursor = cbm_cons_p->cursor;
+	if (IS_ENABLED(CONFIG_CONSOLE_CBMEM_RING)) {
+		cursor &= CBMEM_CONSOLE_CURSOR_MASK;
+		if (cursor > cbm_cons_p->size)
+			cursor = cbm_cons_p->size;
+		if (cbm_cons_p->cursor & CBMEM_CONSOLE_OVERFLOW)
+			dump_to_uart(cbm_cons_p->body + cursor,
+				     cbm_cons_p->size - cursor);
+	} else if (cursor > cbm_cons_p->size) {
+		cursor = cbm_cons_p->size;
+	}
+
+	dump_to_uart(cbm_cons_p->body, cursor);
 }
 #endif
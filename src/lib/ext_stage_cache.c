@@ -45,6 +45,137 @@ static void stage_cache_create_empty(void)
 		printk(BIOS_DEBUG, "Could not limit stage cache size.\n");
 }
 
+/* What a ramstage kept across a normal boot was loaded from. */
+struct stage_cache_warm {
+	uint64_t file_hash;
+	uint64_t image_hash;
+};
+
+#define WARM_HASH_INIT	0xcbf29ce484222325ULL
+#define WARM_HASH_PRIME	0x100000001b3ULL
+
+/*
+ * FNV-1a on 32-bit words. It only has to notice a changed file or image,
+ * both of which can only be written by the firmware.
+ */
+static uint64_t warm_hash(const void *data, size_t size)
+{
+	uint64_t hash = WARM_HASH_INIT;
+	const uint8_t *p = data;
+	uint32_t w;
+
+	for (; size >= sizeof(w); size -= sizeof(w), p += sizeof(w)) {
+		memcpy(&w, p, sizeof(w));
+		hash = (hash ^ w) * WARM_HASH_PRIME;
+	}
+
+	for (; size; size--, p++)
+		hash = (hash ^ *p) * WARM_HASH_PRIME;
+
+	return hash;
+}
+
+static int ramstage_file_hash(uint64_t *hash)
+{
+	struct prog ramstage =
+		PROG_INIT(PROG_RAMSTAGE, CONFIG_CBFS_PREFIX "/ramstage");
+	const struct region_device *rdev;
+	void *data;
+
+	if (prog_locate(&ramstage))
+		return -1;
+
+	rdev = prog_rdev(&ramstage);
+	data = rdev_mmap_full(rdev);
+	if (data == NULL)
+		return -1;
+
+	*hash = warm_hash(data, region_device_sz(rdev));
+	rdev_munmap(rdev, data);
+
+	return 0;
+}
+
+/*
+ * Keep the ramstage of the previous boot if it is intact and was loaded
+ * from the same CBFS file. Everything else is cached again on this boot.
+ */
+static void stage_cache_create_warm(void)
+{
+	struct stage_cache_warm warm;
+	struct stage_cache meta;
+	const struct imd_entry *e;
+	struct imd *imd;
+	uint64_t file_hash;
+	void *base;
+	size_t size;
+	void *c;
+
+	imd = imd_get();
+	stage_cache_external_region(&base, &size);
+	imd_handle_init(imd, (void *)(size + (uintptr_t)base));
+
+	/* Nothing is left after a cold boot. */
+	if (imd_recover(imd))
+		goto empty;
+
+	e = imd_entry_find(imd, CBMEM_ID_STAGEx_WARM + STAGE_RAMSTAGE);
+	if (e == NULL)
+		goto empty;
+	memcpy(&warm, imd_entry_at(imd, e), sizeof(warm));
+
+	e = imd_entry_find(imd, CBMEM_ID_STAGEx_META + STAGE_RAMSTAGE);
+	if (e == NULL)
+		goto empty;
+	memcpy(&meta, imd_entry_at(imd, e), sizeof(meta));
+
+	e = imd_entry_find(imd, CBMEM_ID_STAGEx_CACHE + STAGE_RAMSTAGE);
+	if (e == NULL)
+		goto empty;
+	c = imd_entry_at(imd, e);
+	size = imd_entry_size(imd, e);
+
+	if (warm_hash(c, size) != warm.image_hash) {
+		printk(BIOS_DEBUG, "Cached ramstage is corrupted.\n");
+		goto empty;
+	}
+
+	if (ramstage_file_hash(&file_hash) || file_hash != warm.file_hash) {
+		printk(BIOS_DEBUG, "Ramstage changed, not keeping it cached.\n");
+		goto empty;
+	}
+
+	/*
+	 * Start over with only the ramstage. The root and the small region
+	 * are created where they were, so the old image is left alone until
+	 * it is moved up to its new entry.
+	 */
+	stage_cache_create_empty();
+
+	e = imd_entry_add(imd, CBMEM_ID_STAGEx_META + STAGE_RAMSTAGE,
+			  sizeof(meta));
+	if (e == NULL)
+		goto empty;
+	memcpy(imd_entry_at(imd, e), &meta, sizeof(meta));
+
+	e = imd_entry_add(imd, CBMEM_ID_STAGEx_WARM + STAGE_RAMSTAGE,
+			  sizeof(warm));
+	if (e == NULL)
+		goto empty;
+	memcpy(imd_entry_at(imd, e), &warm, sizeof(warm));
+
+	e = imd_entry_add(imd, CBMEM_ID_STAGEx_CACHE + STAGE_RAMSTAGE, size);
+	if (e == NULL)
+		goto empty;
+	memmove(imd_entry_at(imd, e), c, size);
+
+	printk(BIOS_DEBUG, "Keeping cached ramstage for this boot.\n");
+	return;
+
+empty:
+	stage_cache_create_empty();
+}
+
 static void stage_cache_recover(void)
 {
 	struct imd *imd;
@@ -66,7 +197,8 @@ void stage_cache_add(int stage_id, const struct prog *stage)
 	void *c;
 
 	imd = imd_get();
-	e = imd_entry_add(imd, CBMEM_ID_STAGEx_META + stage_id, sizeof(*meta));
+	e = imd_entry_find_or_add(imd, CBMEM_ID_STAGEx_META + stage_id,
+				  sizeof(*meta));
 
 	if (e == NULL)
 		return;
@@ -76,8 +208,14 @@ void stage_cache_add(int stage_id, const struct prog *stage)
 	meta->load_addr = (uintptr_t)prog_start(stage);
 	meta->entry_addr = (uintptr_t)prog_entry(stage);
 
-	e = imd_entry_add(imd, CBMEM_ID_STAGEx_CACHE + stage_id,
-				prog_size(stage));
+	/*
+	 * A ramstage kept from the previous boot is the same size, but may be
+	 * loaded elsewhere on this boot. Overwrite it.
+	 */
+	e = imd_entry_find(imd, CBMEM_ID_STAGEx_CACHE + stage_id);
+	if (e == NULL || imd_entry_size(imd, e) != prog_size(stage))
+		e = imd_entry_add(imd, CBMEM_ID_STAGEx_CACHE + stage_id,
+					prog_size(stage));
 
 	if (e == NULL)
 		return;
@@ -85,6 +223,21 @@ void stage_cache_add(int stage_id, const struct prog *stage)
 	c = imd_entry_at(imd, e);
 
 	memcpy(c, prog_start(stage), prog_size(stage));
+
+	if (IS_ENABLED(CONFIG_WARM_BOOT_STAGE_CACHE) &&
+	    stage_id == STAGE_RAMSTAGE) {
+		struct stage_cache_warm *warm;
+
+		e = imd_entry_find_or_add(imd, CBMEM_ID_STAGEx_WARM + stage_id,
+					  sizeof(*warm));
+		if (e == NULL)
+			return;
+
+		warm = imd_entry_at(imd, e);
+		if (ramstage_file_hash(&warm->file_hash))
+			warm->file_hash = 0;
+		warm->image_hash = warm_hash(c, prog_size(stage));
+	}
 }
 
 void stage_cache_load_stage(int stage_id, struct prog *stage)
@@ -116,10 +269,58 @@ void stage_cache_load_stage(int stage_id, struct prog *stage)
 	prog_set_entry(stage, (void *)(uintptr_t)meta->entry_addr, NULL);
 }
 
+int stage_cache_load_warm(int stage_id, struct prog *stage)
+{
+	struct imd *imd;
+	struct stage_cache *meta;
+	const struct imd_entry *e;
+	uintptr_t start;
+	uintptr_t end;
+	void *c;
+	size_t size;
+
+	imd = imd_get();
+
+	/* Only present if the image matches the CBFS file. */
+	if (imd_entry_find(imd, CBMEM_ID_STAGEx_WARM + stage_id) == NULL)
+		return -1;
+
+	e = imd_entry_find(imd, CBMEM_ID_STAGEx_META + stage_id);
+	if (e == NULL)
+		return -1;
+
+	meta = imd_entry_at(imd, e);
+
+	e = imd_entry_find(imd, CBMEM_ID_STAGEx_CACHE + stage_id);
+	if (e == NULL)
+		return -1;
+
+	c = imd_entry_at(imd, e);
+	size = imd_entry_size(imd, e);
+
+	/* The image is relocated, it has to go where it went last time. */
+	start = (uintptr_t)prog_start(stage);
+	end = start + prog_size(stage);
+	if (meta->load_addr < start || meta->load_addr + size > end) {
+		printk(BIOS_DEBUG, "Cached stage %d doesn't fit %p-%p.\n",
+		       stage_id, (void *)start, (void *)end);
+		return -1;
+	}
+
+	memcpy((void *)(uintptr_t)meta->load_addr, c, size);
+
+	prog_set_area(stage, (void *)(uintptr_t)meta->load_addr, size);
+	prog_set_entry(stage, (void *)(uintptr_t)meta->entry_addr, NULL);
+
+	return 0;
+}
+
 static void stage_cache_setup(int is_recovery)
 {
 	if (is_recovery)
 		stage_cache_recover();
+	else if (IS_ENABLED(CONFIG_WARM_BOOT_STAGE_CACHE))
+		stage_cache_create_warm();
 	else
 		stage_cache_create_empty();
 }
@@ -286,6 +286,7 @@ static void bs_call_callbacks(struct boot_state *state,
                               boot_state_sequence_t seq)
 {
 	struct boot_phase *phase = &state->phases[seq];
+	int blocked = 0;
 
 	while (1) {
 		if (phase->callbacks != NULL) {
@@ -312,8 +313,15 @@ static void bs_call_callbacks(struct boot_state *state,
 		/* Something is blocking this state from transitioning. As
 		 * there are no more callbacks a pending timer needs to be
 		 * ran to unblock the state. */
+		if (!blocked) {
+			timestamp_span_begin(TS_SPAN_BS_BLOCKED);
+			blocked = 1;
+		}
 		bs_run_timers(0);
 	}
+
+	if (blocked)
+		timestamp_span_end(TS_SPAN_BS_BLOCKED);
 }
 
 /* Keep track of the current state. */
@@ -346,6 +354,8 @@ static void bs_walk_state_machine(void)
 
 		bs_run_timers(0);
 
+		timestamp_span_begin(TS_SPAN_BOOT_STATE + state->id);
+
 		bs_sample_time(state);
 
 		bs_call_callbacks(state, current_phase.seq);
@@ -378,6 +388,8 @@ static void bs_walk_state_machine(void)
 
 		bs_sample_time(state);
 
+		timestamp_span_end(TS_SPAN_BOOT_STATE + state->id);
+
 		bs_report_time(state);
 
 		state->complete = 1;
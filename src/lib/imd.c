@@ -53,6 +53,17 @@ struct imd_root {
 } __attribute__((packed));
 
 #define IMD_FLAG_LOCKED 1
+/* The root is followed by an index of its entries by id. */
+#define IMD_FLAG_INDEXED 2
+
+/*
+ * The index is an open addressing hash table with linear probing placed
+ * right after entries[max_entries]. Each slot holds an entry number plus 1
+ * or 0 when empty. It has twice as many slots as the root has entries, so
+ * there is always an empty slot to end a probe sequence.
+ */
+typedef uint16_t imd_index_slot_t;
+#define IMD_INDEX_SLOTS_PER_ENTRY 2
 
 static void *relative_pointer(void *base, ssize_t offset)
 {
@@ -98,12 +109,113 @@ static struct imd_entry *root_last_entry(struct imd_root *r)
 static size_t root_num_entries(size_t root_size)
 {
 	size_t entries_size;
+	size_t entry_size;
 
 	entries_size = root_size;
 	entries_size -= sizeof(struct imd_root_pointer);
 	entries_size -= sizeof(struct imd_root);
 
-	return entries_size / sizeof(struct imd_entry);
+	entry_size = sizeof(struct imd_entry);
+	if (IS_ENABLED(CONFIG_IMD_HASH_INDEX))
+		entry_size += IMD_INDEX_SLOTS_PER_ENTRY *
+				sizeof(imd_index_slot_t);
+
+	return entries_size / entry_size;
+}
+
+/*
+ * Checked at runtime rather than with IS_ENABLED(), so that stages built
+ * without IMD_HASH_INDEX keep the index of a root created with it current.
+ */
+static bool root_is_indexed(const struct imd_root *r)
+{
+	return !!(r->flags & IMD_FLAG_INDEXED);
+}
+
+static imd_index_slot_t *root_index(struct imd_root *r)
+{
+	return (imd_index_slot_t *)&r->entries[r->max_entries];
+}
+
+static size_t root_index_slots(const struct imd_root *r)
+{
+	return r->max_entries * IMD_INDEX_SLOTS_PER_ENTRY;
+}
+
+static size_t root_index_home(const struct imd_root *r, uint32_t id)
+{
+	/* CBMEM ids are mostly ASCII tags, spread them out first. */
+	return (id * 2654435761u) % root_index_slots(r);
+}
+
+static size_t root_index_next(const struct imd_root *r, size_t slot)
+{
+	return slot + 1 == root_index_slots(r) ? 0 : slot + 1;
+}
+
+static void root_index_insert(struct imd_root *r, size_t entry)
+{
+	imd_index_slot_t *index = root_index(r);
+	uint32_t id = r->entries[entry].id;
+	size_t slot;
+
+	for (slot = root_index_home(r, id); index[slot] != 0;
+			slot = root_index_next(r, slot)) {
+		/* Like the linear search the first entry of an id wins. */
+		if (r->entries[index[slot] - 1].id == id)
+			return;
+	}
+
+	index[slot] = entry + 1;
+}
+
+/*
+ * Only the last entry can be removed. It was also the last one inserted,
+ * so nothing probed past its slot since and emptying the slot restores the
+ * index to what it was before.
+ */
+static void root_index_remove(struct imd_root *r, size_t entry)
+{
+	imd_index_slot_t *index = root_index(r);
+	size_t slot;
+
+	for (slot = root_index_home(r, r->entries[entry].id); index[slot] != 0;
+			slot = root_index_next(r, slot)) {
+		if (index[slot] == entry + 1) {
+			index[slot] = 0;
+			return;
+		}
+	}
+
+	/* Not found means it was shadowed by an earlier entry of its id. */
+}
+
+static void root_index_rebuild(struct imd_root *r)
+{
+	size_t i;
+
+	memset(root_index(r), 0,
+		root_index_slots(r) * sizeof(imd_index_slot_t));
+
+	/* The first entry covers the root and is never looked up. */
+	for (i = 1; i < r->num_entries; i++)
+		root_index_insert(r, i);
+}
+
+static struct imd_entry *root_index_find(struct imd_root *r, uint32_t id)
+{
+	imd_index_slot_t *index = root_index(r);
+	size_t slot;
+
+	for (slot = root_index_home(r, id); index[slot] != 0;
+			slot = root_index_next(r, slot)) {
+		size_t entry = index[slot] - 1;
+
+		if (entry < r->num_entries && r->entries[entry].id == id)
+			return &r->entries[entry];
+	}
+
+	return NULL;
 }
 
 static size_t imd_root_data_left(struct imd_root *r)
@@ -188,6 +300,11 @@ static int imdr_create_empty(struct imdr *imdr, size_t root_size,
 	/* Calculate size left for entries. */
 	r->max_entries = root_num_entries(root_size);
 
+	if (IS_ENABLED(CONFIG_IMD_HASH_INDEX)) {
+		r->flags |= IMD_FLAG_INDEXED;
+		root_index_rebuild(r);
+	}
+
 	/* Fill in first entry covering the root region. */
 	r->num_entries = 1;
 	e = &r->entries[0];
@@ -227,6 +344,14 @@ static int imdr_recover(struct imdr *imdr)
 	if (!IS_POWER_OF_2(r->entry_align))
 		return -1;
 
+	/* The index has to fit below the root pointer. */
+	if (root_is_indexed(r)) {
+		imd_index_slot_t *end = &root_index(r)[root_index_slots(r)];
+
+		if ((uintptr_t)end > (uintptr_t)rp)
+			return -1;
+	}
+
 	low_limit = (uintptr_t)relative_pointer(r, r->max_offset);
 
 	/* If no max_offset then lowest limit is 0. */
@@ -248,6 +373,10 @@ static int imdr_recover(struct imdr *imdr)
 			return -1;
 	}
 
+	/* Don't trust the index of the previous stage. */
+	if (root_is_indexed(r))
+		root_index_rebuild(r);
+
 	/* Set root pointer. */
 	imdr->r = r;
 
@@ -266,6 +395,9 @@ static const struct imd_entry *imdr_entry_find(const struct imdr *imdr,
 	if (r == NULL)
 		return NULL;
 
+	if (root_is_indexed(r))
+		return root_index_find(r, id);
+
 	e = NULL;
 	/* Skip first entry covering the root. */
 	for (i = 1; i < r->num_entries; i++) {
@@ -346,6 +478,9 @@ static struct imd_entry *imd_entry_add_to_root(struct imd_root *r, uint32_t id,
 
 	imd_entry_assign(entry, id, e_offset, size);
 
+	if (root_is_indexed(r))
+		root_index_insert(r, r->num_entries - 1);
+
 	return entry;
 }
 
@@ -649,6 +784,9 @@ int imd_entry_remove(const struct imd *imd, const struct imd_entry *entry)
 	if (entry != root_last_entry(r))
 		return -1;
 
+	if (root_is_indexed(r))
+		root_index_remove(r, r->num_entries - 1);
+
 	r->num_entries--;
 
 	return 0;
@@ -9,6 +9,8 @@
  *
  */
 
+#include <commonlib/helpers.h>
+#include <commonlib/region.h>
 #include <console/console.h>
 #include <string.h>
 #include <lib.h>
@@ -16,37 +18,54 @@
 
 #include "lzmadecode.h"
 
-size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn)
+#define LZMA_HEADER_SIZE (LZMA_PROPERTIES_SIZE + 8)
+#define LZMA_SCRATCHPAD_SIZE 15980
+
+/* Size of the input windows used when streaming from a region_device. One
+ * window is read while the decoder works on the other one. */
+#define LZMA_STREAM_WINDOW_SIZE (2 * KiB)
+
+/* Parse the LZMA stream header. Returns 0 on success, < 0 on error. */
+static int lzma_decode_header(CLzmaDecoderState *state, UInt32 *outSize,
+				const unsigned char *header, void *scratchpad)
 {
 	unsigned char properties[LZMA_PROPERTIES_SIZE];
-	const int data_offset = LZMA_PROPERTIES_SIZE + 8;
-	UInt32 outSize;
-	SizeT inProcessed;
-	SizeT outProcessed;
-	int res;
-	CLzmaDecoderState state;
 	SizeT mallocneeds;
-	MAYBE_STATIC unsigned char scratchpad[15980];
 	const unsigned char *cp;
 
-	memcpy(properties, src, LZMA_PROPERTIES_SIZE);
+	memcpy(properties, header, LZMA_PROPERTIES_SIZE);
 	/* The outSize in LZMA stream is a 64bit integer stored in little-endian
 	 * (ref: lzma.cc@LZMACompress: put_64). To prevent accessing by
 	 * unaligned memory address and to load in correct endianness, read each
 	 * byte and re-construct. */
-	cp = src + LZMA_PROPERTIES_SIZE;
-	outSize = cp[3] << 24 | cp[2] << 16 | cp[1] << 8 | cp[0];
-	if (LzmaDecodeProperties(&state.Properties, properties,
+	cp = header + LZMA_PROPERTIES_SIZE;
+	*outSize = cp[3] << 24 | cp[2] << 16 | cp[1] << 8 | cp[0];
+	if (LzmaDecodeProperties(&state->Properties, properties,
 				 LZMA_PROPERTIES_SIZE) != LZMA_RESULT_OK) {
 		printk(BIOS_WARNING, "lzma: Incorrect stream properties.\n");
-		return 0;
+		return -1;
 	}
-	mallocneeds = (LzmaGetNumProbs(&state.Properties) * sizeof(CProb));
-	if (mallocneeds > 15980) {
+	mallocneeds = (LzmaGetNumProbs(&state->Properties) * sizeof(CProb));
+	if (mallocneeds > LZMA_SCRATCHPAD_SIZE) {
 		printk(BIOS_WARNING, "lzma: Decoder scratchpad too small!\n");
-		return 0;
+		return -1;
 	}
-	state.Probs = (CProb *)scratchpad;
+	state->Probs = (CProb *)scratchpad;
+	return 0;
+}
+
+size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn)
+{
+	const int data_offset = LZMA_HEADER_SIZE;
+	UInt32 outSize;
+	SizeT inProcessed;
+	SizeT outProcessed;
+	int res;
+	CLzmaDecoderState state;
+	MAYBE_STATIC unsigned char scratchpad[LZMA_SCRATCHPAD_SIZE];
+
+	if (lzma_decode_header(&state, &outSize, src, scratchpad))
+		return 0;
 	res = LzmaDecode(&state, src + data_offset, srcn - data_offset,
 			 &inProcessed, dst, outSize, &outProcessed);
 	if (res != 0) {
@@ -55,3 +74,98 @@ size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn)
 	}
 	return outProcessed;
 }
+
+struct lzma_rdev_stream {
+	ILzmaInStream stream;
+	const struct region_device *rdev;
+	size_t offset;
+	size_t left;
+	unsigned char (*windows)[LZMA_STREAM_WINDOW_SIZE];
+	int cur;
+	/* Size of the read going into windows[cur], 0 if there is none. */
+	size_t reading;
+	struct rdev_async_read req;
+};
+
+/* Start reading the next window of input. */
+static void lzma_rdev_start(struct lzma_rdev_stream *s)
+{
+	size_t size = MIN(s->left, LZMA_STREAM_WINDOW_SIZE);
+
+	s->reading = 0;
+	if (size == 0)
+		return;
+
+	if (rdev_readat_async(s->rdev, &s->req, s->windows[s->cur],
+			      s->offset, size) < 0)
+		return;
+
+	s->reading = size;
+	s->offset += size;
+	s->left -= size;
+}
+
+static SizeT lzma_rdev_read(ILzmaInStream *in, const unsigned char **buf)
+{
+	struct lzma_rdev_stream *s;
+	size_t size;
+
+	s = container_of(in, struct lzma_rdev_stream, stream);
+	size = s->reading;
+
+	if (size == 0)
+		return 0;
+
+	s->reading = 0;
+	if (rdev_read_wait(&s->req) != size)
+		return 0;
+
+	*buf = s->windows[s->cur];
+
+	/* The decoder is done with the other window now, fill it. */
+	s->cur = !s->cur;
+	lzma_rdev_start(s);
+
+	return size;
+}
+
+size_t ulzma_rdev(const struct region_device *rdev, size_t offset,
+			size_t srcn, void *dst, size_t dstn)
+{
+	unsigned char header[LZMA_HEADER_SIZE];
+	UInt32 outSize;
+	SizeT outProcessed;
+	int res;
+	CLzmaDecoderState state;
+	MAYBE_STATIC unsigned char scratchpad[LZMA_SCRATCHPAD_SIZE];
+	MAYBE_STATIC unsigned char windows[2][LZMA_STREAM_WINDOW_SIZE];
+	struct lzma_rdev_stream s = {
+		.stream = { .Read = lzma_rdev_read },
+		.rdev = rdev,
+		.offset = offset + sizeof(header),
+		.left = srcn - sizeof(header),
+		.windows = windows,
+	};
+
+	if (srcn < sizeof(header))
+		return 0;
+
+	if (rdev_readat(rdev, header, offset, sizeof(header)) != sizeof(header))
+		return 0;
+
+	if (lzma_decode_header(&state, &outSize, header, scratchpad))
+		return 0;
+
+	lzma_rdev_start(&s);
+	res = LzmaDecodeStream(&state, &s.stream, dst, outSize, &outProcessed);
+
+	/* The decoder may stop before it asked for all of the input. */
+	if (s.reading)
+		rdev_read_wait(&s.req);
+
+	if (res != 0) {
+		printk(BIOS_WARNING, "lzma: Decoding error = %d\n", res);
+		return 0;
+	}
+	return outProcessed;
+}
@@ -41,7 +41,10 @@
   { int i; for(i = 0; i < 5; i++) { RC_TEST; Code = (Code << 8) | RC_READ_BYTE; }}
 
 
-#define RC_TEST { if (Buffer == BufferLim) return LZMA_RESULT_DATA_ERROR; }
+/* Once the current input window is used up, ask the input stream (if any)
+ * for the next one. */
+#define RC_TEST { if (Buffer == BufferLim && \
+    LzmaRefill(inCallback, &Buffer, &BufferLim)) return LZMA_RESULT_DATA_ERROR; }
 
 #define RC_INIT(buffer, bufferSize) Buffer = buffer; BufferLim = buffer + bufferSize; RC_INIT2
 
@@ -139,7 +142,22 @@ int LzmaDecodeProperties(CLzmaProperties *propsRes, const unsigned char *propsDa
 
 #define kLzmaStreamWasFinishedId (-1)
 
-int LzmaDecode(CLzmaDecoderState *vs,
+/* Returns 0 if a new non-empty input window was provided, 1 otherwise. */
+static int LzmaRefill(ILzmaInStream *inCallback, const Byte **buffer,
+    const Byte **bufferLim)
+{
+  SizeT size;
+
+  if (inCallback == 0)
+    return 1;
+
+  size = inCallback->Read(inCallback, buffer);
+  *bufferLim = *buffer + size;
+
+  return size == 0;
+}
+
+static int LzmaDecodeInternal(CLzmaDecoderState *vs, ILzmaInStream *inCallback,
     const unsigned char *inStream, SizeT inSize, SizeT *inSizeProcessed,
     unsigned char *outStream, SizeT outSize, SizeT *outSizeProcessed)
 {
@@ -165,7 +183,8 @@ int LzmaDecode(CLzmaDecoderState *vs,
   UInt32 Range;
   UInt32 Code;
 
-  *inSizeProcessed = 0;
+  if (inSizeProcessed != 0)
+    *inSizeProcessed = 0;
   *outSizeProcessed = 0;
 
   {
@@ -405,7 +424,23 @@ int LzmaDecode(CLzmaDecoderState *vs,
   RC_NORMALIZE;
 
 
-  *inSizeProcessed = (SizeT)(Buffer - inStream);
+  if (inSizeProcessed != 0)
+    *inSizeProcessed = (SizeT)(Buffer - inStream);
   *outSizeProcessed = nowPos;
   return LZMA_RESULT_OK;
 }
+
+int LzmaDecode(CLzmaDecoderState *vs,
+    const unsigned char *inStream, SizeT inSize, SizeT *inSizeProcessed,
+    unsigned char *outStream, SizeT outSize, SizeT *outSizeProcessed)
+{
+  return LzmaDecodeInternal(vs, 0, inStream, inSize, inSizeProcessed,
+      outStream, outSize, outSizeProcessed);
+}
+
+int LzmaDecodeStream(CLzmaDecoderState *vs, ILzmaInStream *inStream,
+    unsigned char *outStream, SizeT outSize, SizeT *outSizeProcessed)
+{
+  return LzmaDecodeInternal(vs, inStream, 0, 0, 0,
+      outStream, outSize, outSizeProcessed);
+}
@@ -64,4 +64,16 @@ int LzmaDecode(CLzmaDecoderState *vs,
     const unsigned char *inStream, SizeT inSize, SizeT *inSizeProcessed,
     unsigned char *outStream, SizeT outSize, SizeT *outSizeProcessed);
 
+/* Input provider for LzmaDecodeStream(). Read() points *buf to the next
+   window of compressed input and returns its size, or 0 once no more input
+   is available. A window stays valid until the next call to Read(). */
+typedef struct _ILzmaInStream
+{
+  SizeT (*Read)(struct _ILzmaInStream *inStream, const unsigned char **buf);
+} ILzmaInStream;
+
+/* Same as LzmaDecode() but consumes the input window by window. */
+int LzmaDecodeStream(CLzmaDecoderState *vs, ILzmaInStream *inStream,
+    unsigned char *outStream, SizeT outSize, SizeT *outSizeProcessed);
+
 #endif
@@ -1,12 +1,47 @@
+#include <stdint.h>
 #include <string.h>
+
+#include "string_word.h"
+
 void *memcpy(void *vdest, const void *vsrc, size_t bytes)
 {
-	const char *src = vsrc;
-	char *dest = vdest;
-	int i;
+	const unsigned char *src = vsrc;
+	unsigned char *dest = vdest;
+
+	/* Word accesses only work if both pointers can be aligned at once. */
+	if ((((uintptr_t)dest ^ (uintptr_t)src) & WORD_MASK) == 0) {
+		const word_t *wsrc;
+		word_t *wdest;
+
+		while (((uintptr_t)dest & WORD_MASK) && bytes) {
+			*dest++ = *src++;
+			bytes--;
+		}
+
+		wsrc = (const word_t *)src;
+		wdest = (word_t *)dest;
+
+		while (bytes >= 4 * WORD_SIZE) {
+			wdest[0] = wsrc[0];
+			wdest[1] = wsrc[1];
+			wdest[2] = wsrc[2];
+			wdest[3] = wsrc[3];
+			wdest += 4;
+			wsrc += 4;
+			bytes -= 4 * WORD_SIZE;
+		}
+
+		while (bytes >= WORD_SIZE) {
+			*wdest++ = *wsrc++;
+			bytes -= WORD_SIZE;
+		}
+
+		src = (const unsigned char *)wsrc;
+		dest = (unsigned char *)wdest;
+	}
 
-	for (i = 0; i < (int)bytes; i++)
-		dest[i] = src[i];
+	while (bytes--)
+		*dest++ = *src++;
 
 	return vdest;
 }
@@ -1,19 +1,74 @@
+#include <stdint.h>
 #include <string.h>
+
+#include "string_word.h"
+
+/*
+ * Copying word by word is safe for overlapping buffers as long as every word
+ * is read before the word overlapping it is written, i.e. when copying
+ * towards lower addresses front to back and towards higher ones back to front.
+ */
 void *memmove(void *vdest, const void *vsrc, size_t count)
 {
-	const char *src = vsrc;
-	char *dest = vdest;
+	const unsigned char *src = vsrc;
+	unsigned char *dest = vdest;
+	int aligned = (((uintptr_t)dest ^ (uintptr_t)src) & WORD_MASK) == 0;
 
-	if (dest <= src) {
-		while (count--) {
-			*dest++ = *src++;
+	if (dest == src || count == 0)
+		return vdest;
+
+	if (dest < src) {
+		if (aligned) {
+			const word_t *wsrc;
+			word_t *wdest;
+
+			while (((uintptr_t)dest & WORD_MASK) && count) {
+				*dest++ = *src++;
+				count--;
+			}
+
+			wsrc = (const word_t *)src;
+			wdest = (word_t *)dest;
+
+			while (count >= WORD_SIZE) {
+				*wdest++ = *wsrc++;
+				count -= WORD_SIZE;
+			}
+
+			src = (const unsigned char *)wsrc;
+			dest = (unsigned char *)wdest;
 		}
+
+		while (count--)
+			*dest++ = *src++;
 	} else {
-		src  += count - 1;
-		dest += count - 1;
-		while(count--) {
-			*dest-- = *src--;
+		src += count;
+		dest += count;
+
+		if (aligned) {
+			const word_t *wsrc;
+			word_t *wdest;
+
+			while (((uintptr_t)dest & WORD_MASK) && count) {
+				*--dest = *--src;
+				count--;
+			}
+
+			wsrc = (const word_t *)src;
+			wdest = (word_t *)dest;
+
+			while (count >= WORD_SIZE) {
+				*--wdest = *--wsrc;
+				count -= WORD_SIZE;
+			}
+
+			src = (const unsigned char *)wsrc;
+			dest = (unsigned char *)wdest;
 		}
+
+		while (count--)
+			*--dest = *--src;
 	}
+
 	return vdest;
 }
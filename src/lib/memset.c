@@ -1,12 +1,46 @@
+#include <stdint.h>
 #include <string.h>
 
+#include "string_word.h"
+
 void *memset(void *s, int c, size_t n)
 {
-	int i;
-	char *ss = (char *) s;
+	unsigned char *ss = s;
+	word_t *ws;
+	word_t w;
+
+	while (((uintptr_t)ss & WORD_MASK) && n) {
+		*ss++ = c;
+		n--;
+	}
+
+	/* Replicate the fill byte into every byte of a word. */
+	w = (unsigned char)c;
+	w |= w << 8;
+	w |= w << 16;
+	if (WORD_SIZE > 4)
+		w |= (w << 16) << 16;
+
+	ws = (word_t *)ss;
+
+	while (n >= 4 * WORD_SIZE) {
+		ws[0] = w;
+		ws[1] = w;
+		ws[2] = w;
+		ws[3] = w;
+		ws += 4;
+		n -= 4 * WORD_SIZE;
+	}
+
+	while (n >= WORD_SIZE) {
+		*ws++ = w;
+		n -= WORD_SIZE;
+	}
+
+	ss = (unsigned char *)ws;
 
-	for (i = 0; i < (int)n; i++)
-		ss[i] = c;
+	while (n--)
+		*ss++ = c;
 
 	return s;
 }
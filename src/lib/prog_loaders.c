@@ -18,6 +18,7 @@
 #include <cbfs.h>
 #include <cbmem.h>
 #include <console/console.h>
+#include <console/uart.h>
 #include <fallback.h>
 #include <halt.h>
 #include <lib.h>
@@ -75,6 +76,11 @@ void __attribute__((weak)) stage_cache_add(int stage_id,
 						const struct prog *stage) {}
 void __attribute__((weak)) stage_cache_load_stage(int stage_id,
 							struct prog *stage) {}
+int __attribute__((weak)) stage_cache_load_warm(int stage_id,
+						struct prog *stage)
+{
+	return -1;
+}
 
 static void ramstage_cache_invalid(void)
 {
@@ -110,6 +116,31 @@ static int load_relocatable_ramstage(struct prog *ramstage)
 	return rmodule_stage_load(&rmod_ram);
 }
 
+/* Returns 0 if the ramstage from the previous boot could be used. */
+static int load_warm_ramstage(struct prog *ramstage)
+{
+	/* Still the CBFS file, for loading it if the cache can't be used. */
+	struct prog file = *ramstage;
+	struct rmod_stage_load rmod_ram = {
+		.cbmem_id = CBMEM_ID_RAMSTAGE,
+		.prog = ramstage,
+	};
+
+	if (!IS_ENABLED(CONFIG_WARM_BOOT_STAGE_CACHE) ||
+	    romstage_handoff_is_resume())
+		return -1;
+
+	/* It can only be used where rmodule_stage_load() would put it. */
+	if (rmodule_stage_reserve(&rmod_ram) ||
+	    stage_cache_load_warm(STAGE_RAMSTAGE, ramstage)) {
+		*ramstage = file;
+		return -1;
+	}
+
+	printk(BIOS_DEBUG, "Using ramstage cached on the previous boot.\n");
+	return 0;
+}
+
 static int load_nonrelocatable_ramstage(struct prog *ramstage)
 {
 	if (IS_ENABLED(CONFIG_HAVE_ACPI_RESUME)) {
@@ -144,6 +175,8 @@ void run_ramstage(void)
 	timestamp_add_now(TS_START_COPYRAM);
 
 	if (IS_ENABLED(CONFIG_RELOCATABLE_RAMSTAGE)) {
+		if (!load_warm_ramstage(&ramstage))
+			goto run;
 		if (load_relocatable_ramstage(&ramstage))
 			goto fail;
 	} else if (load_nonrelocatable_ramstage(&ramstage))
@@ -151,6 +184,8 @@ void run_ramstage(void)
 
 	stage_cache_add(STAGE_RAMSTAGE, &ramstage);
 
+run:
+
 	timestamp_add_now(TS_END_COPYRAM);
 
 	prog_run(&ramstage);
@@ -208,6 +243,8 @@ void payload_run(void)
 	 */
 	checkstack(_estack, 0);
 
+	uart_buffered_drain();
+
 	prog_run(payload);
 }
 
@@ -249,34 +249,62 @@ int rmodule_calc_region(unsigned int region_alignment, size_t rmodule_size,
 	return region_alignment - sizeof(struct rmodule_header);
 }
 
-int rmodule_stage_load(struct rmod_stage_load *rsl)
+static char *rmodule_stage_region(struct rmod_stage_load *rsl,
+				  struct cbfs_stage *stage, size_t *region_size,
+				  int *rmodule_offset, int *load_offset)
 {
-	struct rmodule rmod_stage;
+	if (rsl->prog == NULL || prog_name(rsl->prog) == NULL)
+		return NULL;
+
+	if (rdev_readat(prog_rdev(rsl->prog), stage, 0, sizeof(*stage)) !=
+	    sizeof(*stage))
+		return NULL;
+
+	*rmodule_offset =
+		rmodule_calc_region(DYN_CBMEM_ALIGN_SIZE,
+		                    stage->memlen, region_size, load_offset);
+
+	return cbmem_add(rsl->cbmem_id, *region_size);
+}
+
+int rmodule_stage_reserve(struct rmod_stage_load *rsl)
+{
+	struct cbfs_stage stage;
 	size_t region_size;
 	char *stage_region;
 	int rmodule_offset;
 	int load_offset;
-	struct cbfs_stage stage;
-	void *rmod_loc;
-	struct region_device *fh;
 
-	if (rsl->prog == NULL || prog_name(rsl->prog) == NULL)
+	stage_region = rmodule_stage_region(rsl, &stage, &region_size,
+					    &rmodule_offset, &load_offset);
+
+	if (stage_region == NULL)
 		return -1;
 
-	fh = prog_rdev(rsl->prog);
+	prog_set_area(rsl->prog, stage_region, region_size);
 
-	if (rdev_readat(fh, &stage, 0, sizeof(stage)) != sizeof(stage))
-		return -1;
+	return 0;
+}
 
-	rmodule_offset =
-		rmodule_calc_region(DYN_CBMEM_ALIGN_SIZE,
-		                    stage.memlen, &region_size, &load_offset);
+int rmodule_stage_load(struct rmod_stage_load *rsl)
+{
+	struct rmodule rmod_stage;
+	size_t region_size;
+	char *stage_region;
+	int rmodule_offset;
+	int load_offset;
+	struct cbfs_stage stage;
+	void *rmod_loc;
+	struct region_device *fh;
 
-	stage_region = cbmem_add(rsl->cbmem_id, region_size);
+	stage_region = rmodule_stage_region(rsl, &stage, &region_size,
+					    &rmodule_offset, &load_offset);
 
 	if (stage_region == NULL)
 		return -1;
 
+	fh = prog_rdev(rsl->prog);
+
 	rmod_loc = &stage_region[rmodule_offset];
 
 	printk(BIOS_INFO, "Decompressing stage %s @ 0x%p (%d bytes)\n",
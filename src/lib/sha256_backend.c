@@ -0,0 +1,132 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <commonlib/endian.h>
+#include <commonlib/helpers.h>
+#include <rules.h>
+#include <sha256_backend.h>
+#include <string.h>
+
+static const uint32_t sha256_init_state[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+__attribute__((weak)) const struct sha256_backend *soc_sha256_backend(void)
+{
+	return NULL;
+}
+
+static int backend_usable(const struct sha256_backend *backend)
+{
+	if (backend == NULL)
+		return 0;
+
+	return backend->probe == NULL || backend->probe();
+}
+
+static const struct sha256_backend *arch_sha256_backend(void)
+{
+	if (ENV_X86)
+		return &sha256_x86_shani_backend;
+	if (ENV_ARM64)
+		return &sha256_armv8_ce_backend;
+	return NULL;
+}
+
+const struct sha256_backend *sha256_backend_get(void)
+{
+	const struct sha256_backend *backend = soc_sha256_backend();
+
+	if (backend_usable(backend))
+		return backend;
+
+	backend = arch_sha256_backend();
+
+	if (backend_usable(backend))
+		return backend;
+
+	return NULL;
+}
+
+int sha256_init(struct sha256_ctx *ctx)
+{
+	ctx->backend = sha256_backend_get();
+
+	if (ctx->backend == NULL)
+		return -1;
+
+	memcpy(ctx->state, sha256_init_state, sizeof(ctx->state));
+	ctx->buf_len = 0;
+	ctx->total = 0;
+
+	return 0;
+}
+
+void sha256_update(struct sha256_ctx *ctx, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+	size_t blocks;
+
+	ctx->total += len;
+
+	if (ctx->buf_len) {
+		size_t n = MIN(len, SHA256_BLOCK_SIZE - ctx->buf_len);
+
+		memcpy(ctx->buf + ctx->buf_len, p, n);
+		ctx->buf_len += n;
+		p += n;
+		len -= n;
+
+		if (ctx->buf_len < SHA256_BLOCK_SIZE)
+			return;
+
+		ctx->backend->transform(ctx->state, ctx->buf, 1);
+		ctx->buf_len = 0;
+	}
+
+	/* Full blocks are hashed straight from the caller's buffer. */
+	blocks = len / SHA256_BLOCK_SIZE;
+	if (blocks) {
+		ctx->backend->transform(ctx->state, p, blocks);
+		p += blocks * SHA256_BLOCK_SIZE;
+		len -= blocks * SHA256_BLOCK_SIZE;
+	}
+
+	memcpy(ctx->buf, p, len);
+	ctx->buf_len = len;
+}
+
+void sha256_final(struct sha256_ctx *ctx, uint8_t digest[SHA256_DIGEST_SIZE])
+{
+	const uint64_t bits = ctx->total * 8;
+	size_t i;
+
+	ctx->buf[ctx->buf_len++] = 0x80;
+
+	/* The length goes into the last 8 bytes of the final block. */
+	if (ctx->buf_len > SHA256_BLOCK_SIZE - sizeof(bits)) {
+		memset(ctx->buf + ctx->buf_len, 0,
+		       SHA256_BLOCK_SIZE - ctx->buf_len);
+		ctx->backend->transform(ctx->state, ctx->buf, 1);
+		ctx->buf_len = 0;
+	}
+
+	memset(ctx->buf + ctx->buf_len, 0,
+	       SHA256_BLOCK_SIZE - sizeof(bits) - ctx->buf_len);
+	write_be64(ctx->buf + SHA256_BLOCK_SIZE - sizeof(bits), bits);
+	ctx->backend->transform(ctx->state, ctx->buf, 1);
+
+	for (i = 0; i < ARRAY_SIZE(ctx->state); i++)
+		write_be32(digest + i * sizeof(uint32_t), ctx->state[i]);
+}
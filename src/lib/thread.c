@@ -353,6 +353,11 @@ int thread_yield_microseconds(unsigned microsecs)
 	return 0;
 }
 
+int thread_yield(void)
+{
+	return thread_yield_microseconds(0);
+}
+
 void thread_cooperate(void)
 {
 	struct thread *current;
@@ -372,3 +377,15 @@ void thread_prevent_coop(void)
 	if (current != NULL)
 		current->can_yield = 0;
 }
+
+int thread_id(void)
+{
+	struct thread *current;
+
+	current = current_thread();
+
+	if (current == NULL)
+		return 0;
+
+	return current->id;
+}
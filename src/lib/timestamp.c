@@ -24,8 +24,13 @@
 #include <arch/early_variables.h>
 #include <rules.h>
 #include <smp/node.h>
+#include <smp/spinlock.h>
+#if ENV_RAMSTAGE
+#include <thread.h>
+#endif
 
-#define MAX_TIMESTAMPS 84
+/* Spans take two entries each. */
+#define MAX_TIMESTAMPS (IS_ENABLED(CONFIG_TIMESTAMP_SPANS) ? 256 : 84)
 
 /* When changing this number, adjust TIMESTAMP() size ASSERT() in memlayout.h */
 #define MAX_BSS_TIMESTAMP_CACHE 16
@@ -152,19 +157,42 @@ static struct timestamp_table *timestamp_table_get(void)
 	return ts_table;
 }
 
-static void timestamp_add_table_entry(struct timestamp_table *ts_table,
-				      enum timestamp_id id, uint64_t ts_time)
+#if ENV_RAMSTAGE
+/* APs record spans in ramstage. */
+DECLARE_SPIN_LOCK(ts_lock)
+#define timestamp_lock()	spin_lock(&ts_lock)
+#define timestamp_unlock()	spin_unlock(&ts_lock)
+#else
+#define timestamp_lock()	do {} while (0)
+#define timestamp_unlock()	do {} while (0)
+#endif
+
+/* Returns 1 when the table just got full. Needs the timestamp lock. */
+static int __timestamp_add_table_entry(struct timestamp_table *ts_table,
+				       uint32_t id, uint64_t ts_time)
 {
 	struct timestamp_entry *tse;
 
 	if (ts_table->num_entries >= ts_table->max_entries)
-		return;
+		return 0;
 
 	tse = &ts_table->entries[ts_table->num_entries++];
 	tse->entry_id = id;
 	tse->entry_stamp = ts_time - ts_table->base_time;
 
-	if (ts_table->num_entries == ts_table->max_entries)
+	return ts_table->num_entries == ts_table->max_entries;
+}
+
+static void timestamp_add_table_entry(struct timestamp_table *ts_table,
+				      uint32_t id, uint64_t ts_time)
+{
+	int full;
+
+	timestamp_lock();
+	full = __timestamp_add_table_entry(ts_table, id, ts_time);
+	timestamp_unlock();
+
+	if (full)
 		printk(BIOS_ERR, "ERROR: Timestamp table full\n");
 }
 
@@ -187,6 +215,49 @@ void timestamp_add_now(enum timestamp_id id)
 	timestamp_add(id, timestamp_get());
 }
 
+#if IS_ENABLED(CONFIG_TIMESTAMP_SPANS) && ENV_RAMSTAGE
+static void timestamp_add_span(enum timestamp_id id, uint32_t flag)
+{
+	struct timestamp_table *ts_table;
+	uint32_t cpu = 0;
+	uint32_t entry_id;
+	int full;
+
+#if IS_ENABLED(CONFIG_ARCH_X86)
+	cpu = cpu_index();
+#endif
+
+	entry_id = flag | (id & TS_SPAN_ID_MASK);
+	entry_id |= (cpu & TS_SPAN_CPU_MASK) << TS_SPAN_CPU_SHIFT;
+	entry_id |= (thread_id() & TS_SPAN_THREAD_MASK) <<
+		TS_SPAN_THREAD_SHIFT;
+
+	ts_table = timestamp_table_get();
+
+	/* Spans are optional, don't complain about them. */
+	if (!ts_table)
+		return;
+
+	/* Keep the entries of all CPUs in order. */
+	timestamp_lock();
+	full = __timestamp_add_table_entry(ts_table, entry_id, timestamp_get());
+	timestamp_unlock();
+
+	if (full)
+		printk(BIOS_ERR, "ERROR: Timestamp table full\n");
+}
+
+void timestamp_span_begin(enum timestamp_id id)
+{
+	timestamp_add_span(id, TS_SPAN_BEGIN);
+}
+
+void timestamp_span_end(enum timestamp_id id)
+{
+	timestamp_add_span(id, TS_SPAN_END);
+}
+#endif
+
 void timestamp_init(uint64_t base)
 {
 	struct timestamp_cache *ts_cache;
@@ -20,7 +20,7 @@
 #include <device/pci_ids.h>
 #include <soc/pci_devs.h>
 #include <soc/pci_ids.h>
-#include <timer.h>
+#include <thread.h>
 
 #define DUAL_ROLE_CFG0		0x80d8
 # define DRD_CONFIG_MASK	(0x3 << 0)
@@ -48,7 +48,7 @@ static void configure_host_mode_port0(struct device *dev)
 	const struct resource *res;
 	uint32_t reg;
 	struct device *xdci_dev = XDCI_DEV;
-	struct stopwatch sw;
+	long elapsed;
 
 	/*
 	 * Only default to host mode if the xdci device is present and
@@ -72,18 +72,15 @@ static void configure_host_mode_port0(struct device *dev)
 	reg |= SW_VBUS_DEASSERT_VALID;
 	write32(cfg0, reg);
 
-	stopwatch_init_msecs_expire(&sw, 10);
-
 	/* Wait for the host mode status bit. */
-	while ((read32(cfg1) & DRD_MODE_MASK) != DRD_MODE_HOST) {
-		if (stopwatch_expired(&sw)) {
-			printk(BIOS_INFO, "Timed out waiting for host mode.\n");
-			break;
-		}
+	elapsed = wait_ms(10, (read32(cfg1) & DRD_MODE_MASK) == DRD_MODE_HOST);
+	if (!elapsed) {
+		printk(BIOS_INFO, "Timed out waiting for host mode.\n");
+		return;
 	}
 
-	printk(BIOS_INFO, "XHCI port 0 host switch over took %lu ms\n",
-		stopwatch_duration_msecs(&sw));
+	printk(BIOS_INFO, "XHCI port 0 host switch over took %ld ms\n",
+		elapsed);
 }
 
 static void xhci_init(struct device *dev)
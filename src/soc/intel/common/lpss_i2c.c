@@ -15,12 +15,14 @@
  */
 
 #include <arch/acpigen.h>
+#include <arch/early_variables.h>
 #include <arch/io.h>
 #include <commonlib/helpers.h>
 #include <console/console.h>
 #include <device/device.h>
 #include <device/i2c.h>
 #include <string.h>
+#include <thread.h>
 #include <timer.h>
 #include "lpss_i2c.h"
 
@@ -266,15 +268,12 @@ static int lpss_i2c_disable(struct lpss_i2c_regs *regs)
 	uint32_t enable = read32(&regs->enable);
 
 	if (enable & ENABLE_CONTROLLER) {
-		struct stopwatch sw;
-
 		write32(&regs->enable, enable & ~ENABLE_CONTROLLER);
 
 		/* Wait for enable bit to clear */
-		stopwatch_init_usecs_expire(&sw, LPSS_I2C_TIMEOUT_US);
-		while (read32(&regs->enable_status) & ENABLE_CONTROLLER)
-			if (stopwatch_expired(&sw))
-				return -1;
+		if (!wait_us(LPSS_I2C_TIMEOUT_US,
+			     !(read32(&regs->enable_status) & ENABLE_CONTROLLER)))
+			return -1;
 	}
 
 	return 0;
@@ -283,22 +282,15 @@ static int lpss_i2c_disable(struct lpss_i2c_regs *regs)
 /* Wait for this I2C controller to go idle for transmit */
 static int lpss_i2c_wait_for_bus_idle(struct lpss_i2c_regs *regs)
 {
-	struct stopwatch sw;
-
-	/* Start timeout for up to 16 bytes in FIFO */
-	stopwatch_init_usecs_expire(&sw, 16 * LPSS_I2C_TIMEOUT_US);
-
-	while (!stopwatch_expired(&sw)) {
-		uint32_t status = read32(&regs->status);
-
-		/* Check for master activity and keep waiting */
-		if (status & STATUS_MASTER_ACTIVITY)
-			continue;
+	uint32_t status;
 
-		/* Check for TX FIFO empty to indicate TX idle */
-		if (status & STATUS_TX_FIFO_EMPTY)
-			return 0;
-	}
+	/* Wait for no master activity and TX FIFO empty to indicate TX idle,
+	 * with a timeout for up to 16 bytes in FIFO */
+	if (wait_us(16 * LPSS_I2C_TIMEOUT_US,
+		    (status = read32(&regs->status),
+		     !(status & STATUS_MASTER_ACTIVITY) &&
+		     (status & STATUS_TX_FIFO_EMPTY))))
+		return 0;
 
 	/* Timed out while waiting for bus to go idle */
 	return -1;
@@ -345,8 +337,8 @@ static int lpss_i2c_transfer_byte(struct lpss_i2c_regs *regs,
 	return 0;
 }
 
-/* Global I2C bus handler, defined in include/i2c.h */
-int platform_i2c_transfer(unsigned bus, struct i2c_seg *segments, int count)
+static int lpss_i2c_transfer(unsigned bus, struct i2c_seg *segments,
+			     int count)
 {
 	struct stopwatch sw;
 	struct lpss_i2c_regs *regs;
@@ -406,12 +398,10 @@ int platform_i2c_transfer(unsigned bus, struct i2c_seg *segments, int count)
 	}
 
 	/* Wait for interrupt status to indicate transfer is complete */
-	stopwatch_init_usecs_expire(&sw, LPSS_I2C_TIMEOUT_US);
-	while (!(read32(&regs->raw_intr_stat) & INTR_STAT_STOP_DET)) {
-		if (stopwatch_expired(&sw)) {
-			printk(BIOS_ERR, "I2C stop bit not received\n");
-			goto out;
-		}
+	if (!wait_us(LPSS_I2C_TIMEOUT_US,
+		     read32(&regs->raw_intr_stat) & INTR_STAT_STOP_DET)) {
+		printk(BIOS_ERR, "I2C stop bit not received\n");
+		goto out;
 	}
 
 	/* Read to clear INTR_STAT_STOP_DET */
@@ -441,6 +431,30 @@ out:
 	return ret;
 }
 
+/* Buses with a transfer in progress. Transfers let other threads run while
+ * they wait for the controller, which must not start another transfer on the
+ * same bus in the meantime. */
+static uint32_t lpss_i2c_busy CAR_GLOBAL;
+
+/* Global I2C bus handler, defined in include/i2c.h */
+int platform_i2c_transfer(unsigned bus, struct i2c_seg *segments, int count)
+{
+	uint32_t mask = bus < 32 ? 1U << bus : 0;
+	int ret;
+
+	if (!wait_us(16 * LPSS_I2C_TIMEOUT_US,
+		     !(car_get_var(lpss_i2c_busy) & mask))) {
+		printk(BIOS_ERR, "I2C bus %u busy\n", bus);
+		return -1;
+	}
+
+	car_set_var(lpss_i2c_busy, car_get_var(lpss_i2c_busy) | mask);
+	ret = lpss_i2c_transfer(bus, segments, count);
+	car_set_var(lpss_i2c_busy, car_get_var(lpss_i2c_busy) & ~mask);
+
+	return ret;
+}
+
 /*
  * Write ACPI object to describe speed configuration.
  *
@@ -17,6 +17,7 @@
 
 #include <arch/hlt.h>
 #include <arch/io.h>
+#include <console/uart.h>
 #include <reset.h>
 
 /* Reset control port */
@@ -36,6 +37,7 @@ void WEAK reset_prepare(void) { /* do nothing */ }
 #if IS_ENABLED(CONFIG_HAVE_HARD_RESET)
 void hard_reset(void)
 {
+	uart_buffered_drain();
 	reset_prepare();
 	/* S0->S5->S0 trip. */
 	outb(RST_CPU | SYS_RST | FULL_RST, RST_CNT);
@@ -46,6 +48,7 @@ void hard_reset(void)
 
 void soft_reset(void)
 {
+	uart_buffered_drain();
 	reset_prepare();
 	/* PMC_PLTRST# asserted. */
 	outb(RST_CPU | SYS_RST, RST_CNT);
@@ -55,6 +58,7 @@ void soft_reset(void)
 
 void cpu_reset(void)
 {
+	uart_buffered_drain();
 	reset_prepare();
 	/* Sends INIT# to CPU */
 	outb(RST_CPU, RST_CNT);
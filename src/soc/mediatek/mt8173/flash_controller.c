@@ -113,11 +113,9 @@ unsigned int spi_crop_chunk(unsigned int cmd_len, unsigned int buf_len)
 	return min(65535, buf_len);
 }
 
-static int dma_read(u32 addr, u8 *buf, u32 len, uintptr_t dma_buf,
-		    size_t dma_buf_len)
+static void dma_start(u32 addr, u8 *buf, u32 len, uintptr_t dma_buf,
+		      size_t dma_buf_len)
 {
-	struct stopwatch sw;
-
 	assert(IS_ALIGNED((uintptr_t)buf, SFLASH_DMA_ALIGN) &&
 	       IS_ALIGNED(len, SFLASH_DMA_ALIGN) &&
 	       len <= dma_buf_len);
@@ -131,6 +129,11 @@ static int dma_read(u32 addr, u8 *buf, u32 len, uintptr_t dma_buf,
 	write32(&mt8173_nor->fdma_end_dadr, (dma_buf + len));
 	/* start dma */
 	write32(&mt8173_nor->fdma_ctl, SFLASH_DMA_TRIGGER | SFLASH_DMA_WDLE_EN);
+}
+
+static int dma_finish(u8 *buf, u32 len, uintptr_t dma_buf)
+{
+	struct stopwatch sw;
 
 	stopwatch_init_usecs_expire(&sw, SFLASH_POLLINGREG_US);
 	while ((read32(&mt8173_nor->fdma_ctl) & SFLASH_DMA_TRIGGER) != 0) {
@@ -144,6 +147,13 @@ static int dma_read(u32 addr, u8 *buf, u32 len, uintptr_t dma_buf,
 	return 0;
 }
 
+static int dma_read(u32 addr, u8 *buf, u32 len, uintptr_t dma_buf,
+		    size_t dma_buf_len)
+{
+	dma_start(addr, buf, len, dma_buf, dma_buf_len);
+	return dma_finish(buf, len, dma_buf);
+}
+
 static int pio_read(u32 addr, u8 *buf, u32 len)
 {
 	set_sfpaddr(addr);
@@ -157,8 +167,35 @@ static int pio_read(u32 addr, u8 *buf, u32 len)
 	return 0;
 }
 
-static int nor_read(const struct spi_flash *flash, u32 addr, size_t len,
-		void *buf)
+/*
+ * An asynchronous read leaves its last DMA transfer running. The bytes after
+ * it that are too few for DMA are read once the transfer is done.
+ */
+static struct {
+	int active;
+	int result;
+	u8 *buf;
+	u32 len;
+	uintptr_t dma_buf;
+	u32 tail_addr;
+	u32 tail_len;
+} pending_read;
+
+/* Complete an outstanding asynchronous read before using the controller. */
+static void finish_pending_read(void)
+{
+	if (!pending_read.active)
+		return;
+
+	pending_read.active = 0;
+	if (dma_finish(pending_read.buf, pending_read.len,
+		       pending_read.dma_buf) ||
+	    pio_read(pending_read.tail_addr, pending_read.buf +
+		     pending_read.len, pending_read.tail_len))
+		pending_read.result = -1;
+}
+
+static int do_read(u32 addr, size_t len, void *buf, int async)
 {
 	u32 next;
 
@@ -166,6 +203,8 @@ static int nor_read(const struct spi_flash *flash, u32 addr, size_t len,
 	uintptr_t dma_buf;
 	size_t dma_buf_len;
 
+	finish_pending_read();
+
 	if (!IS_ALIGNED((uintptr_t)buf, SFLASH_DMA_ALIGN)) {
 		next = MIN(ALIGN_UP((uintptr_t)buf, SFLASH_DMA_ALIGN) -
 			   (uintptr_t)buf, len);
@@ -185,6 +224,21 @@ static int nor_read(const struct spi_flash *flash, u32 addr, size_t len,
 	while (len - done >= SFLASH_DMA_ALIGN) {
 		next = MIN(dma_buf_len, ALIGN_DOWN(len - done,
 			   SFLASH_DMA_ALIGN));
+
+		/* Leave the last transfer running for nor_read_wait(). */
+		if (async && len - done - next < SFLASH_DMA_ALIGN) {
+			dma_start(addr + done, buf + done, next, dma_buf,
+				  dma_buf_len);
+			pending_read.active = 1;
+			pending_read.result = 0;
+			pending_read.buf = buf + done;
+			pending_read.len = next;
+			pending_read.dma_buf = dma_buf;
+			pending_read.tail_addr = addr + done + next;
+			pending_read.tail_len = len - done - next;
+			return 0;
+		}
+
 		if (dma_read(addr + done, buf + done, next, dma_buf,
 			     dma_buf_len))
 			return -1;
@@ -196,11 +250,35 @@ static int nor_read(const struct spi_flash *flash, u32 addr, size_t len,
 	return 0;
 }
 
+static int nor_read(const struct spi_flash *flash, u32 addr, size_t len,
+		void *buf)
+{
+	return do_read(addr, len, buf, 0);
+}
+
+static int nor_read_async(const struct spi_flash *flash, u32 addr,
+		size_t len, void *buf)
+{
+	return do_read(addr, len, buf, 1);
+}
+
+static int nor_read_wait(const struct spi_flash *flash)
+{
+	int ret;
+
+	finish_pending_read();
+	ret = pending_read.result;
+	pending_read.result = 0;
+
+	return ret;
+}
+
 static int nor_write(const struct spi_flash *flash, u32 addr, size_t len,
 		const void *buf)
 {
 	const u8 *buffer = (const u8 *)buf;
 
+	finish_pending_read();
 	set_sfpaddr(addr);
 	while (len) {
 		write8(&mt8173_nor->wdata, *buffer);
@@ -220,6 +298,7 @@ static int nor_erase(const struct spi_flash *flash, u32 offset, size_t len)
 	int sector_start = offset;
 	int sector_num = (u32)len / flash->sector_size;
 
+	finish_pending_read();
 	while (sector_num) {
 		if (!sector_erase(sector_start)) {
 			sector_start += flash->sector_size;
@@ -247,6 +326,8 @@ struct spi_flash *spi_flash_programmer_probe(struct spi_slave *spi, int force)
 	flash.internal_write = nor_write;
 	flash.internal_erase = nor_erase;
 	flash.internal_read = nor_read;
+	flash.internal_read_async = nor_read_async;
+	flash.internal_read_wait = nor_read_wait;
 	flash.internal_status = 0;
 	flash.sector_size = 0x1000;
 	flash.erase_cmd = SECTOR_ERASE_CMD;
@@ -15,6 +15,7 @@
 
 #include <arch/io.h>
 #include <assert.h>
+#include <commonlib/cbfs.h>
 #include <delay.h>
 #include <soc/addressmap.h>
 #include <soc/soc.h>
@@ -67,6 +68,11 @@ struct rk3288_crypto {
 } *crypto = (void *)CRYPTO_BASE;
 check_member(rk3288_crypto, trng_dout[7], 0x220);
 
+int cbfs_hwcrypto_supported(enum vb2_hash_algorithm hash_alg)
+{
+	return hash_alg == VB2_HASH_SHA256;
+}
+
 int vb2ex_hwcrypto_digest_init(enum vb2_hash_algorithm hash_alg,
 			       uint32_t data_size)
 {
@@ -256,6 +256,8 @@ static struct device_operations sata_ops = {
 	.set_resources = pci_dev_set_resources,
 	.enable_resources = pci_dev_enable_resources,
 	.init = sata_init,
+	/* Waiting for the drives to come up takes a while. */
+	.init_in_thread = 1,
 	.scan_bus = 0,
 	.ops_pci = &lops_pci,
 };
@@ -0,0 +1,65 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <arch/early_variables.h>
+#include <commonlib/cbfs.h>
+#include <console/console.h>
+#include <sha256_backend.h>
+#include <vb2_api.h>
+
+/*
+ * vboot calls vb2ex_hwcrypto_digest_init() first and falls back to its own
+ * hashing if that fails, so only SHA-256 with an available backend is taken
+ * here. vboot only has one hardware digest going at any time.
+ */
+
+static struct sha256_ctx hwcrypto_ctx CAR_GLOBAL;
+
+int cbfs_hwcrypto_supported(enum vb2_hash_algorithm hash_alg)
+{
+	return hash_alg == VB2_HASH_SHA256 && sha256_backend_get() != NULL;
+}
+
+int vb2ex_hwcrypto_digest_init(enum vb2_hash_algorithm hash_alg,
+			       uint32_t data_size)
+{
+	struct sha256_ctx *ctx = car_get_var_ptr(&hwcrypto_ctx);
+
+	if (hash_alg != VB2_HASH_SHA256)
+		return VB2_ERROR_EX_HWCRYPTO_UNSUPPORTED;
+
+	if (sha256_init(ctx))
+		return VB2_ERROR_EX_HWCRYPTO_UNSUPPORTED;
+
+	printk(BIOS_DEBUG, "Hashing %u bytes with %s\n", data_size,
+	       ctx->backend->name);
+
+	return VB2_SUCCESS;
+}
+
+int vb2ex_hwcrypto_digest_extend(const uint8_t *buf, uint32_t size)
+{
+	sha256_update(car_get_var_ptr(&hwcrypto_ctx), buf, size);
+
+	return VB2_SUCCESS;
+}
+
+int vb2ex_hwcrypto_digest_finalize(uint8_t *digest, uint32_t digest_size)
+{
+	if (digest_size < SHA256_DIGEST_SIZE)
+		return VB2_ERROR_UNKNOWN;
+
+	sha256_final(car_get_var_ptr(&hwcrypto_ctx), digest);
+
+	return VB2_SUCCESS;
+}
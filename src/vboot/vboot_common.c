@@ -18,6 +18,7 @@
 #include <cbmem.h>
 #include <console/cbmem_console.h>
 #include <console/console.h>
+#include <console/uart.h>
 #include <fmap.h>
 #include <reset.h>
 #include <rules.h>
@@ -110,6 +111,7 @@ void vboot_reboot(void)
 	if (IS_ENABLED(CONFIG_CONSOLE_CBMEM_DUMP_TO_UART))
 		cbmem_dump_console();
 	vboot_platform_prepare_reboot();
+	uart_buffered_drain();
 	hard_reset();
 	die("failed to reboot");
 }
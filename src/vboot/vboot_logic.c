@@ -14,9 +14,11 @@
  */
 
 #include <antirollback.h>
+#include <arch/early_variables.h>
 #include <arch/exception.h>
 #include <assert.h>
 #include <bootmode.h>
+#include <commonlib/cbfs.h>
 #include <console/console.h>
 #include <console/vtxprintf.h>
 #include <delay.h>
@@ -29,8 +31,6 @@
 /* The max hash size to expect is for SHA512. */
 #define VBOOT_MAX_HASH_SIZE VB2_SHA512_DIGEST_SIZE
 
-#define TODO_BLOCK_SIZE 1024
-
 static int is_slot_a(struct vb2_context *ctx)
 {
 	return !(ctx->flags & VB2_CONTEXT_FW_SLOT_B);
@@ -94,7 +94,13 @@ int vb2ex_read_resource(struct vb2_context *ctx,
 	return VB2_SUCCESS;
 }
 
-/* No-op stubs that can be overridden by SoCs with hardware crypto support. */
+/* No-op stubs, overridden by hwcrypto.c when VBOOT_HWCRYPTO is enabled. */
+__attribute__((weak))
+int cbfs_hwcrypto_supported(enum vb2_hash_algorithm hash_alg)
+{
+	return 0;
+}
+
 __attribute__((weak))
 int vb2ex_hwcrypto_digest_init(enum vb2_hash_algorithm hash_alg,
 			       uint32_t data_size)
@@ -179,15 +185,24 @@ static int handle_digest_result(void *slot_hash, size_t slot_hash_sz)
 	return 0;
 }
 
+/*
+ * The body is read into one buffer while the other one is being hashed.
+ * Aligned to a cache line for the sake of boot devices reading through DMA.
+ */
+static uint8_t hash_buffers[2][CONFIG_VBOOT_HASH_BLOCK_SIZE] CAR_GLOBAL
+	__attribute__((aligned(64)));
+
 static int hash_body(struct vb2_context *ctx, struct region_device *fw_main)
 {
 	uint64_t load_ts;
 	uint32_t expected_size;
-	uint8_t block[TODO_BLOCK_SIZE];
+	uint8_t (*buffers)[CONFIG_VBOOT_HASH_BLOCK_SIZE];
 	uint8_t hash_digest[VBOOT_MAX_HASH_SIZE];
 	const size_t hash_digest_sz = sizeof(hash_digest);
-	size_t block_size = sizeof(block);
+	struct rdev_async_read req;
+	size_t block_size;
 	size_t offset;
+	int cur;
 	int rv;
 
 	/* Clear the full digest so that any hash digests less than the
@@ -198,6 +213,7 @@ static int hash_body(struct vb2_context *ctx, struct region_device *fw_main)
 	 * Since loading the firmware and calculating its hash is intertwined,
 	 * we use this little trick to measure them separately and pretend it
 	 * was first loaded and then hashed in one piece with the timestamps.
+	 * Only the time spent waiting for the media counts as loading.
 	 * (This split won't make sense with memory-mapped media like on x86.)
 	 */
 	load_ts = timestamp_get();
@@ -222,23 +238,43 @@ static int hash_body(struct vb2_context *ctx, struct region_device *fw_main)
 		return VB2_ERROR_UNKNOWN;
 	}
 
+	buffers = car_get_var_ptr(hash_buffers);
+	cur = 0;
+	block_size = MIN(expected_size, sizeof(buffers[0]));
+
+	if (block_size && rdev_readat_async(fw_main, &req, buffers[cur],
+					    offset, block_size) < 0)
+		return VB2_ERROR_UNKNOWN;
+
 	/* Extend over the body */
 	while (expected_size) {
+		const uint8_t *block = buffers[cur];
+		size_t hash_size = block_size;
 		uint64_t temp_ts;
-		if (block_size > expected_size)
-			block_size = expected_size;
 
 		temp_ts = timestamp_get();
-		if (rdev_readat(fw_main, block, offset, block_size) < 0)
+		if (rdev_read_wait(&req) < 0)
 			return VB2_ERROR_UNKNOWN;
-		load_ts += timestamp_get() - temp_ts;
-
-		rv = vb2api_extend_hash(ctx, block, block_size);
-		if (rv)
-			return rv;
 
 		expected_size -= block_size;
 		offset += block_size;
+
+		/* Get the next block going before hashing this one. */
+		if (expected_size) {
+			cur = !cur;
+			block_size = MIN(expected_size, sizeof(buffers[0]));
+			if (rdev_readat_async(fw_main, &req, buffers[cur],
+					      offset, block_size) < 0)
+				return VB2_ERROR_UNKNOWN;
+		}
+		load_ts += timestamp_get() - temp_ts;
+
+		rv = vb2api_extend_hash(ctx, block, hash_size);
+		if (rv) {
+			if (expected_size)
+				rdev_read_wait(&req);
+			return rv;
+		}
 	}
 
 	timestamp_add(TS_DONE_LOADING, load_ts);
@@ -0,0 +1,79 @@
+#!/bin/sh
+#
+# This file is part of the coreboot project.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; version 2 of the License.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+
+# Checks where `cbfstool batch -p` places files.
+# Usage: batch_test.sh [path to cbfstool]
+
+CBFSTOOL=$(realpath "${1:-./cbfstool}")
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+cd "$TMP" || exit 1
+
+failed=0
+
+fail() {
+	echo "FAIL: $*"
+	failed=1
+}
+
+file() {
+	head -c "$(($2))" /dev/urandom > "$1"
+}
+
+# entry_offset <name>: offset of the entry as shown by print
+entry_offset() {
+	"$CBFSTOOL" test.rom print | awk -v name="$1" '$1 == name { print $2 }'
+}
+
+# A CBFS with three files placed so that they leave two holes of the same
+# size, 0xc00..0x1500 and 0x1fc0..0x28c0, and a large one after them.
+file bootblock 64
+file f1 0xbc0
+file f2 0xa80
+file f3 0x1000
+"$CBFSTOOL" test.rom create -m x86 -s 0x10000 -B bootblock >/dev/null 2>&1 ||
+	exit 1
+"$CBFSTOOL" test.rom add -f f1 -n f1 -t raw -b 0x40 || exit 1
+"$CBFSTOOL" test.rom add -f f2 -n f2 -t raw -b 0x1540 || exit 1
+"$CBFSTOOL" test.rom add -f f3 -n f3 -t raw -b 0x2900 || exit 1
+
+# Aligned to 4K, the file fits both small holes. In the first one it sits in
+# the middle and splits the hole, in the second one it starts right at it.
+file aligned 0x400
+echo "add -f aligned -n aligned -t raw -a 0x1000" > aligned.txt
+"$CBFSTOOL" test.rom batch -p -f aligned.txt > aligned.out || exit 1
+offset=$(entry_offset aligned)
+[ "$offset" = 0x1fc0 ] || fail "aligned file at $offset, expected 0x1fc0"
+"$CBFSTOOL" test.rom extract -n aligned -f aligned.extracted >/dev/null 2>&1
+cmp -s aligned aligned.extracted || fail "aligned file doesn't extract intact"
+grep -q "in 3 holes" aligned.out || fail "unexpected usage: $(cat aligned.out)"
+
+# The usage is printed once, for the layout after the whole manifest.
+file small 300
+cat > remove.txt <<EOF
+add -f small -n small1 -t raw
+remove -n f2
+add -f small -n small2 -t raw
+EOF
+"$CBFSTOOL" test.rom batch -p -f remove.txt > remove.out || exit 1
+[ "$(grep -c "^COREBOOT: " remove.out)" = 1 ] ||
+	fail "usage not printed exactly once: $(cat remove.out)"
+"$CBFSTOOL" test.rom print | tail -n 1 > print.out
+cmp -s remove.out print.out || fail "batch and print disagree on the usage"
+
+if [ $failed -ne 0 ]; then
+	echo "Some checks failed."
+	exit 1
+fi
+echo "All checks passed."
@@ -76,7 +76,9 @@ int parse_elf_to_payload(const struct buffer *input, struct buffer *output,
 	int isize = 0, osize = 0;
 	int doffset = 0;
 	struct cbfs_payload_segment *segs = NULL;
-	int i;
+	struct compression_job *jobs = NULL;
+	int num_jobs = 0;
+	int i, j;
 	int ret = 0;
 
 	comp_func_ptr compress = compression_function(algo);
@@ -181,7 +183,28 @@ int parse_elf_to_payload(const struct buffer *input, struct buffer *output,
 		}
 	}
 
+	/* The segments are compressed independently, so do all at once. */
+	jobs = calloc(headers, sizeof(*jobs));
+	if (jobs == NULL) {
+		ret = -1;
+		goto out;
+	}
 	for (i = 0; i < headers; i++) {
+		if (phdr[i].p_type != PT_LOAD)
+			continue;
+		if (phdr[i].p_memsz == 0 || phdr[i].p_filesz == 0)
+			continue;
+		jobs[num_jobs].in = &header[phdr[i].p_offset];
+		jobs[num_jobs].in_len = phdr[i].p_filesz;
+		jobs[num_jobs].out = malloc(phdr[i].p_filesz);
+		if (jobs[num_jobs++].out == NULL) {
+			ret = -1;
+			goto out;
+		}
+	}
+	compress_parallel(compress, jobs, num_jobs);
+
+	for (i = 0, j = 0; i < headers; i++) {
 		if (phdr[i].p_type != PT_LOAD)
 			continue;
 		if (phdr[i].p_memsz == 0)
@@ -207,10 +230,8 @@ int parse_elf_to_payload(const struct buffer *input, struct buffer *output,
 		/* If the compression failed or made the section is larger,
 		   use the original stuff */
 
-		int len;
-		if (compress((char *)&header[phdr[i].p_offset],
-			     phdr[i].p_filesz, output->data + doffset, &len) ||
-		    (unsigned int)len > phdr[i].p_filesz) {
+		struct compression_job *job = &jobs[j++];
+		if (job->ret || (unsigned int)job->out_len > phdr[i].p_filesz) {
 			WARN("Compression failed or would make the data bigger "
 			     "- disabled.\n");
 			segs[segments].compression = 0;
@@ -219,7 +240,8 @@ int parse_elf_to_payload(const struct buffer *input, struct buffer *output,
 			       &header[phdr[i].p_offset], phdr[i].p_filesz);
 		} else {
 			segs[segments].compression = algo;
-			segs[segments].len = len;
+			segs[segments].len = job->out_len;
+			memcpy(output->data + doffset, job->out, job->out_len);
 		}
 
 		doffset += segs[segments].len;
@@ -235,6 +257,9 @@ int parse_elf_to_payload(const struct buffer *input, struct buffer *output,
 	xdr_segs(output, segs, segments);
 
 out:
+	for (i = 0; i < num_jobs; i++)
+		free(jobs[i].out);
+	free(jobs);
 	if (segs) free(segs);
 	if (shdr) free(shdr);
 	if (phdr) free(phdr);
@@ -1849,12 +1849,50 @@ static size_t absolute_align(const struct cbfs_image *image, size_t val,
 
 }
 
+/* Finds the content offset for a file within the empty space addr..addr_next
+ * following the rules explained in cbfs_locate_entry(). Returns -1 if it
+ * doesn't fit. */
+static int32_t locate_in_empty_entry(const struct cbfs_image *image,
+				     size_t addr, size_t addr_next, size_t size,
+				     size_t page_size, size_t align,
+				     size_t metadata_size)
+{
+	size_t addr2, addr3, offset;
+
+	offset = absolute_align(image, addr + metadata_size, align);
+	if (is_in_same_page(offset, size, page_size) &&
+	    is_in_range(addr, addr_next, metadata_size, offset, size)) {
+		DEBUG("cbfs_locate_entry: FIT (PAGE1).");
+		return offset;
+	}
+
+	addr2 = align_up(addr, page_size);
+	offset = absolute_align(image, addr2, align);
+	if (is_in_range(addr, addr_next, metadata_size, offset, size)) {
+		DEBUG("cbfs_locate_entry: OVERLAP (PAGE2).");
+		return offset;
+	}
+
+	/* Assume page_size >= metadata_size so adding one page will
+	 * definitely provide the space for header. */
+	assert(page_size >= metadata_size);
+	addr3 = addr2 + page_size;
+	offset = absolute_align(image, addr3, align);
+	if (is_in_range(addr, addr_next, metadata_size, offset, size)) {
+		DEBUG("cbfs_locate_entry: OVERLAP+ (PAGE3).");
+		return offset;
+	}
+
+	return -1;
+}
+
 int32_t cbfs_locate_entry(struct cbfs_image *image, size_t size,
 			  size_t page_size, size_t align, size_t metadata_size)
 {
 	struct cbfs_file *entry;
 	size_t need_len;
-	size_t addr, addr_next, addr2, addr3, offset;
+	size_t addr, addr_next;
+	int32_t offset;
 
 	/* Default values: allow fitting anywhere in ROM. */
 	if (!page_size)
@@ -1913,29 +1951,214 @@ int32_t cbfs_locate_entry(struct cbfs_image *image, size_t size,
 		if (addr_next - addr < need_len)
 			continue;
 
-		offset = absolute_align(image, addr + metadata_size, align);
-		if (is_in_same_page(offset, size, page_size) &&
-		    is_in_range(addr, addr_next, metadata_size, offset, size)) {
-			DEBUG("cbfs_locate_entry: FIT (PAGE1).");
+		offset = locate_in_empty_entry(image, addr, addr_next, size,
+					       page_size, align, metadata_size);
+		if (offset != -1)
 			return offset;
+	}
+	return -1;
+}
+
+/* Aligned and page bound files first, the most constrained ones leading, then
+ * the others from large to small. Ties keep the order they were queued in. */
+static int cbfs_compare_pending(const void *a, const void *b)
+{
+	const struct cbfs_pending_entry *pa =
+			*(const struct cbfs_pending_entry * const *)a;
+	const struct cbfs_pending_entry *pb =
+			*(const struct cbfs_pending_entry * const *)b;
+	size_t size_a = ntohl(pa->header->offset) + pa->buffer.size;
+	size_t size_b = ntohl(pb->header->offset) + pb->buffer.size;
+	bool constrained_a = pa->align > 1 || pa->page_size;
+	bool constrained_b = pb->align > 1 || pb->page_size;
+
+	if (constrained_a != constrained_b)
+		return constrained_a ? -1 : 1;
+	if (pa->align != pb->align)
+		return pa->align > pb->align ? -1 : 1;
+	if (pa->page_size != pb->page_size)
+		return pa->page_size && (!pb->page_size ||
+					 pa->page_size < pb->page_size) ? -1 : 1;
+	if (size_a != size_b)
+		return size_a > size_b ? -1 : 1;
+	return pa < pb ? -1 : pa > pb;
+}
+
+/* What placing a file leaves of an empty entry, see cbfs_place_pending(). */
+struct cbfs_fit {
+	size_t lost;	/* Gaps too small for an empty entry of their own. */
+	size_t rest;	/* All of the entry before and after the file. */
+	size_t front;	/* The part before the file. */
+};
+
+static bool is_better_fit(const struct cbfs_fit *a, const struct cbfs_fit *b)
+{
+	if (a->lost != b->lost)
+		return a->lost < b->lost;
+	if (a->rest != b->rest)
+		return a->rest < b->rest;
+	return a->front < b->front;
+}
+
+/* Best fit on the layout cbfs_add_entry_at() will produce for the offset
+ * found in each empty entry. The entry losing the fewest bytes to gaps too
+ * small to be reused wins. Among those, the one leaving the least free space
+ * around the file does, so the large ones stay free for large files. On a
+ * tie, the smaller gap in front wins, as that gap splits the entry in two. */
+static int32_t cbfs_place_pending(struct cbfs_image *image,
+				  const struct cbfs_pending_entry *pending)
+{
+	size_t metadata_size = ntohl(pending->header->offset);
+	size_t size = pending->buffer.size;
+	size_t page_size = pending->page_size;
+	size_t align = pending->align ? pending->align : 1;
+	size_t image_align = image->has_header ? image->header.align :
+							CBFS_ENTRY_ALIGNMENT;
+	size_t min_entry_size = cbfs_calculate_file_header_size("");
+	struct cbfs_fit best_fit = { SIZE_MAX, SIZE_MAX, SIZE_MAX };
+	int32_t best = -1;
+	struct cbfs_file *entry;
+
+	if (!page_size)
+		page_size = image->has_header ? image->header.romsize :
+							image->buffer.size;
+
+	cbfs_walk(image, cbfs_merge_empty_entry, NULL);
+
+	for (entry = cbfs_find_first_entry(image);
+	     entry && cbfs_is_valid_entry(image, entry);
+	     entry = cbfs_find_next_entry(image, entry)) {
+		size_t addr, addr_next, front, tail;
+		struct cbfs_fit fit;
+		int32_t offset;
+
+		if (ntohl(entry->type) != CBFS_COMPONENT_NULL)
+			continue;
+
+		addr = cbfs_get_entry_addr(image, entry);
+		addr_next = cbfs_get_entry_addr(image,
+					cbfs_find_next_entry(image, entry));
+		if (addr_next - addr < metadata_size + size)
+			continue;
+
+		offset = locate_in_empty_entry(image, addr, addr_next, size,
+					       page_size, align, metadata_size);
+		if (offset == -1)
+			continue;
+
+		/* The header goes right before the content, moved down to the
+		 * CBFS alignment, and the next entry starts aligned after it. */
+		front = offset - metadata_size;
+		front -= front % image_align;
+		front -= addr;
+		tail = align_up(offset + size, image_align);
+		tail = tail < addr_next ? addr_next - tail : 0;
+
+		fit.lost = 0;
+		if (front <= min_entry_size)
+			fit.lost += front;
+		if (tail < min_entry_size)
+			fit.lost += tail;
+		fit.rest = front + tail;
+		fit.front = front;
+
+		if (is_better_fit(&fit, &best_fit)) {
+			best = offset;
+			best_fit = fit;
 		}
+	}
 
-		addr2 = align_up(addr, page_size);
-		offset = absolute_align(image, addr2, align);
-		if (is_in_range(addr, addr_next, metadata_size, offset, size)) {
-			DEBUG("cbfs_locate_entry: OVERLAP (PAGE2).");
-			return offset;
+	return best;
+}
+
+int cbfs_place_entries(struct cbfs_image *image,
+		       struct cbfs_pending_entry *entries, size_t count)
+{
+	struct cbfs_pending_entry **order;
+	size_t i;
+	int ret = 0;
+
+	order = malloc(count * sizeof(*order));
+	if (count && !order) {
+		ERROR("Out of memory.\n");
+		return -1;
+	}
+	for (i = 0; i < count; i++)
+		order[i] = entries + i;
+	qsort(order, count, sizeof(*order), cbfs_compare_pending);
+
+	for (i = 0; i < count; i++) {
+		struct cbfs_pending_entry *pending = order[i];
+		int32_t offset = cbfs_place_pending(image, pending);
+
+		if (offset == -1) {
+			ERROR("'%s' can't fit in CBFS for page-size %#zx, align %#zx.\n",
+			      pending->header->filename, pending->page_size,
+			      pending->align);
+			ret = -1;
+			break;
 		}
 
-		/* Assume page_size >= metadata_size so adding one page will
-		 * definitely provide the space for header. */
-		assert(page_size >= metadata_size);
-		addr3 = addr2 + page_size;
-		offset = absolute_align(image, addr3, align);
-		if (is_in_range(addr, addr_next, metadata_size, offset, size)) {
-			DEBUG("cbfs_locate_entry: OVERLAP+ (PAGE3).");
-			return offset;
+		DEBUG("cbfs_place_entries: '%s' at 0x%x\n",
+		      pending->header->filename, offset);
+		if (cbfs_add_entry(image, &pending->buffer, offset,
+				   pending->header)) {
+			ret = -1;
+			break;
 		}
 	}
-	return -1;
+
+	free(order);
+	return ret;
+}
+
+void cbfs_get_usage(struct cbfs_image *image, struct cbfs_usage *usage)
+{
+	struct cbfs_file *entry;
+	size_t hole = 0;
+
+	memset(usage, 0, sizeof(*usage));
+
+	for (entry = cbfs_find_first_entry(image);
+	     entry && cbfs_is_valid_entry(image, entry);
+	     entry = cbfs_find_next_entry(image, entry)) {
+		uint32_t type = ntohl(entry->type);
+		size_t addr = cbfs_get_entry_addr(image, entry);
+		size_t next = cbfs_get_entry_addr(image,
+					cbfs_find_next_entry(image, entry));
+
+		/* Adjacent empty entries count as one hole, as they would be
+		 * merged before the next file gets added. */
+		if (type == CBFS_COMPONENT_NULL ||
+		    type == CBFS_COMPONENT_DELETED) {
+			if (!hole)
+				usage->free_entries++;
+			hole += next - addr;
+			usage->free += next - addr;
+			if (hole > usage->largest_free)
+				usage->largest_free = hole;
+			continue;
+		}
+
+		hole = 0;
+		usage->files++;
+		usage->used += cbfs_file_entry_size(entry);
+		/* Space after a file too small for an empty entry is lost. */
+		usage->padding += next - addr - cbfs_file_entry_size(entry);
+	}
+}
+
+void cbfs_print_usage(struct cbfs_image *image, const char *name)
+{
+	struct cbfs_usage usage;
+	unsigned fragmentation = 0;
+
+	cbfs_get_usage(image, &usage);
+	if (usage.free)
+		fragmentation = 100 - usage.largest_free * 100 / usage.free;
+
+	printf("%s: %zu files in %zu bytes, %zu bytes of padding, %zu bytes "
+	       "free in %zu holes, largest hole %zu bytes (%u%% fragmented)\n",
+	       name, usage.files, usage.used, usage.padding, usage.free,
+	       usage.free_entries, usage.largest_free, fragmentation);
 }
@@ -118,6 +118,38 @@ int cbfs_create_empty_entry(struct cbfs_file *entry, int type,
 int32_t cbfs_locate_entry(struct cbfs_image *image, size_t size,
 			  size_t page_size, size_t align, size_t metadata_size);
 
+/* A file that was converted but not yet added, see cbfs_place_entries(). */
+struct cbfs_pending_entry {
+	struct buffer buffer;
+	struct cbfs_file *header;
+	size_t align;		/* Content alignment, 0 for none */
+	size_t page_size;	/* Page the content must not cross, 0 for none */
+};
+
+/* Adds several files at once, choosing their places together rather than
+ * taking the first space that fits each in turn: files with an alignment or
+ * page constraint go first, the rest follow from large to small, and each
+ * takes the empty entry where it loses the least space. Files with a fixed
+ * position should be added before with cbfs_add_entry().
+ * Returns 0 on success, otherwise non-zero. */
+int cbfs_place_entries(struct cbfs_image *image,
+		       struct cbfs_pending_entry *entries, size_t count);
+
+/* How well the space of a CBFS is used. All sizes include the headers. */
+struct cbfs_usage {
+	size_t files;
+	size_t used;		/* Headers and data of all files */
+	size_t padding;		/* Lost between files */
+	size_t free;		/* Empty entries */
+	size_t free_entries;	/* Holes, adjacent empty entries count once */
+	size_t largest_free;	/* Largest hole */
+};
+
+void cbfs_get_usage(struct cbfs_image *image, struct cbfs_usage *usage);
+
+/* Prints the usage and fragmentation of the image in one line. */
+void cbfs_print_usage(struct cbfs_image *image, const char *name);
+
 /* Callback function used by cbfs_walk.
  * Returns 0 on success, or non-zero to stop further iteration. */
 typedef int (*cbfs_entry_callback)(struct cbfs_image *image,
@@ -13,19 +13,27 @@
  * GNU General Public License for more details.
  */
 
+#include <getopt.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
 #include "common.h"
+#include "lz4/lib/lz4frame.h"
+#include <commonlib/compression.h>
 
 void usage(void);
-int benchmark(void);
+int benchmark(int argc, char **argv);
 int compress(char *infile, char *outfile, char *algoname);
 
-const char *usage_text = "cbfs-compression-tool benchmark\n"
-	"  runs benchmarks for all implemented algorithms\n"
+const char *usage_text = "cbfs-compression-tool benchmark [-f text|csv|json] [-t ms] [file ...]\n"
+	"  runs benchmarks for all implemented algorithms on each file, or\n"
+	"  on a synthetic buffer if none is given. Each file is compressed,\n"
+	"  then decompressed with the host decoder and with the decoder\n"
+	"  coreboot uses. Every step is repeated for at least -t ms\n"
+	"  (default 200).\n"
 	"cbfs-compression-tool compress inFile outFile algo\n"
 	"  compresses inFile with algo and stores in outFile\n"
 	"\n"
@@ -39,48 +47,444 @@ void usage()
 	puts(usage_text);
 }
 
-int benchmark()
+struct bench_input {
+	const char *name;
+	char *data;
+	int size;
+};
+
+struct bench_result {
+	const struct bench_input *input;
+	const char *algo;
+	/* Negative if the algorithm didn't make the input smaller. */
+	int compressed_size;
+	/* Nanoseconds per run. */
+	double compress_ns;
+	double host_ns;
+	double firmware_ns;
+};
+
+/* Return the size of the decompressed data, or < 0 on error. */
+typedef int (*bench_decomp_func)(char *in, int in_len, char *out,
+				 int out_len);
+
+enum bench_format {
+	BENCH_TEXT,
+	BENCH_CSV,
+	BENCH_JSON,
+};
+
+static uint64_t bench_now(void)
 {
-	const int bufsize = 10*1024*1024;
-	char *data = malloc(bufsize);
-	if (!data) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int none_copy(char *in, int in_len, char *out, int out_len)
+{
+	if (in_len > out_len)
+		return -1;
+	memcpy(out, in, in_len);
+	return in_len;
+}
+
+static int host_lzma(char *in, int in_len, char *out, int out_len)
+{
+	size_t size;
+
+	if (do_lzma_uncompress(out, out_len, in, in_len, &size))
+		return -1;
+	return size;
+}
+
+static int host_lz4(char *in, int in_len, char *out, int out_len)
+{
+	LZ4F_decompressionContext_t ctx;
+	size_t in_size = in_len;
+	size_t out_size = out_len;
+	size_t ret;
+
+	if (LZ4F_isError(LZ4F_createDecompressionContext(&ctx, LZ4F_VERSION)))
+		return -1;
+	ret = LZ4F_decompress(ctx, out, &out_size, in, &in_size, NULL);
+	LZ4F_freeDecompressionContext(ctx);
+
+	/* A complete frame was decoded if nothing more is expected. */
+	if (ret != 0)
+		return -1;
+	return out_size;
+}
+
+static int firmware_lzma(char *in, int in_len, char *out, int out_len)
+{
+	size_t size = firmware_ulzman(in, in_len, out, out_len);
+
+	return size ? (int)size : -1;
+}
+
+static int firmware_lz4(char *in, int in_len, char *out, int out_len)
+{
+	size_t size = ulz4fn(in, in_len, out, out_len);
+
+	return size ? (int)size : -1;
+}
+
+static bench_decomp_func host_decoder(uint32_t algo)
+{
+	switch (algo) {
+	case CBFS_COMPRESS_NONE:
+		return none_copy;
+	case CBFS_COMPRESS_LZMA:
+		return host_lzma;
+	case CBFS_COMPRESS_LZ4:
+		return host_lz4;
+	}
+	return NULL;
+}
+
+/* The decoders in src/commonlib/lz4_wrapper.c and src/lib/lzmadecode.c */
+static bench_decomp_func firmware_decoder(uint32_t algo)
+{
+	switch (algo) {
+	case CBFS_COMPRESS_NONE:
+		return none_copy;
+	case CBFS_COMPRESS_LZMA:
+		return firmware_lzma;
+	case CBFS_COMPRESS_LZ4:
+		return firmware_lz4;
+	}
+	return NULL;
+}
+
+/* Decompress until min_ns have passed. Returns ns per run, < 0 on error. */
+static double bench_decompress(bench_decomp_func decomp, char *in, int in_len,
+			       const struct bench_input *input, char *out,
+			       uint64_t min_ns)
+{
+	uint64_t start = bench_now();
+	uint64_t elapsed;
+	int runs = 0;
+
+	do {
+		if (decomp(in, in_len, out, input->size) != input->size)
+			return -1;
+		runs++;
+		elapsed = bench_now() - start;
+	} while (elapsed < min_ns);
+
+	if (memcmp(out, input->data, input->size))
+		return -1;
+
+	return (double)elapsed / runs;
+}
+
+static int bench_one(const struct bench_input *input,
+		     const struct typedesc_t *algo, uint64_t min_ns,
+		     struct bench_result *result)
+{
+	comp_func_ptr comp = compression_function(algo->type);
+	bench_decomp_func host = host_decoder(algo->type);
+	bench_decomp_func firmware = firmware_decoder(algo->type);
+	/* The LZMA encoder writes its header before it notices. */
+	int bufsize = input->size + 64;
+	char *compressed = malloc(bufsize);
+	char *out = malloc(bufsize);
+	uint64_t start, elapsed;
+	int runs = 0;
+	int ret = 1;
+
+	if (!compressed || !out) {
 		fprintf(stderr, "out of memory\n");
+		goto out;
+	}
+	if (comp == NULL || host == NULL || firmware == NULL) {
+		fprintf(stderr, "no handler associated with algorithm\n");
+		goto out;
+	}
+
+	result->input = input;
+	result->algo = algo->name;
+	result->host_ns = -1;
+	result->firmware_ns = -1;
+
+	start = bench_now();
+	do {
+		if (comp(input->data, input->size, compressed,
+			 &result->compressed_size))
+			result->compressed_size = -1;
+		runs++;
+		elapsed = bench_now() - start;
+	} while (elapsed < min_ns && result->compressed_size >= 0);
+	result->compress_ns = (double)elapsed / runs;
+
+	/* cbfstool stores such files uncompressed. */
+	if (result->compressed_size < 0) {
+		ret = 0;
+		goto out;
+	}
+
+	result->host_ns = bench_decompress(host, compressed,
+					   result->compressed_size, input, out,
+					   min_ns);
+	result->firmware_ns = bench_decompress(firmware, compressed,
+					       result->compressed_size, input,
+					       out, min_ns);
+	if (result->host_ns < 0 || result->firmware_ns < 0) {
+		fprintf(stderr, "%s: %s round trip failed\n", input->name,
+			algo->name);
+		goto out;
+	}
+
+	ret = 0;
+out:
+	free(compressed);
+	free(out);
+	return ret;
+}
+
+static double bench_mbps(const struct bench_result *r, double ns)
+{
+	return r->input->size / ns * 1000;
+}
+
+static void print_json_string(const char *s)
+{
+	putchar('"');
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			printf("\\%c", *s);
+		else if ((unsigned char)*s < 0x20)
+			printf("\\u%04x", *s);
+		else
+			putchar(*s);
+	}
+	putchar('"');
+}
+
+static void print_json_ns(const char *key, const struct bench_result *r,
+			  double ns)
+{
+	if (ns < 0)
+		printf(", \"%s_ns\": null, \"%s_mbps\": null", key, key);
+	else
+		printf(", \"%s_ns\": %.0f, \"%s_mbps\": %.2f", key, ns, key,
+		       bench_mbps(r, ns));
+}
+
+static void print_csv_ns(const struct bench_result *r, double ns)
+{
+	if (ns < 0)
+		printf(",,");
+	else
+		printf(",%.0f,%.2f", ns, bench_mbps(r, ns));
+}
+
+static void print_text_ns(const struct bench_result *r, double ns)
+{
+	if (ns < 0)
+		printf(" %10s", "-");
+	else
+		printf(" %10.1f", bench_mbps(r, ns));
+}
+
+static void print_results(const struct bench_result *results, int num,
+			  enum bench_format format)
+{
+	int width = strlen("file");
+	int i;
+
+	for (i = 0; i < num; i++) {
+		if ((int)strlen(results[i].input->name) > width)
+			width = strlen(results[i].input->name);
+	}
+
+	if (format == BENCH_CSV)
+		printf("file,algorithm,size,compressed_size,ratio,"
+		       "compress_ns,compress_mbps,host_decompress_ns,"
+		       "host_decompress_mbps,firmware_decompress_ns,"
+		       "firmware_decompress_mbps\n");
+	else if (format == BENCH_JSON)
+		printf("[\n");
+	else
+		printf("%-*s %-5s %10s %10s %6s %10s %10s %10s\n", width,
+		       "file", "algo", "size", "compressed", "ratio", "comp MB/s",
+		       "host MB/s", "fw MB/s");
+
+	for (i = 0; i < num; i++) {
+		const struct bench_result *r = &results[i];
+		int size = r->compressed_size < 0 ? r->input->size :
+			r->compressed_size;
+		double ratio = (double)size / r->input->size;
+
+		switch (format) {
+		case BENCH_CSV:
+			printf("\"%s\",%s,%d,%d,%.4f", r->input->name, r->algo,
+			       r->input->size, size, ratio);
+			print_csv_ns(r, r->compress_ns);
+			print_csv_ns(r, r->host_ns);
+			print_csv_ns(r, r->firmware_ns);
+			printf("\n");
+			break;
+		case BENCH_JSON:
+			printf("  { \"file\": ");
+			print_json_string(r->input->name);
+			printf(", \"algorithm\": \"%s\", \"size\": %d, "
+			       "\"compressed_size\": %d, \"ratio\": %.4f",
+			       r->algo, r->input->size, size, ratio);
+			print_json_ns("compress", r, r->compress_ns);
+			print_json_ns("host_decompress", r, r->host_ns);
+			print_json_ns("firmware_decompress", r,
+				      r->firmware_ns);
+			printf(" }%s\n", i + 1 < num ? "," : "");
+			break;
+		default:
+			printf("%-*s %-5s %10d %10d %6.3f", width,
+			       r->input->name, r->algo, r->input->size, size, ratio);
+			print_text_ns(r, r->compress_ns);
+			print_text_ns(r, r->host_ns);
+			print_text_ns(r, r->firmware_ns);
+			printf("\n");
+		}
+	}
+
+	if (format == BENCH_JSON)
+		printf("]\n");
+}
+
+static int read_input(const char *name, struct bench_input *input)
+{
+	FILE *f = fopen(name, "rb");
+	long size;
+
+	if (!f) {
+		fprintf(stderr, "could not open '%s'\n", name);
 		return 1;
 	}
-	char *compressed_data = malloc(bufsize);
-	if (!compressed_data) {
-		fprintf(stderr, "out of memory\n");
+
+	if (fseek(f, 0, SEEK_END) || (size = ftell(f)) < 0 ||
+	    fseek(f, 0, SEEK_SET)) {
+		fprintf(stderr, "could not determine size of '%s'\n", name);
+		fclose(f);
+		return 1;
+	}
+
+	input->name = name;
+	input->size = size;
+	input->data = malloc(size ? size : 1);
+	if (!input->data || fread(input->data, 1, size, f) != (size_t)size) {
+		fprintf(stderr, "could not read '%s'\n", name);
+		fclose(f);
 		return 1;
 	}
+
+	fclose(f);
+	return 0;
+}
+
+/* What the benchmark used to run on: the usage text, repeated. */
+static int synthetic_input(struct bench_input *input)
+{
+	const int bufsize = 10*1024*1024;
 	int i, l = strlen(usage_text) + 1;
+	char *data = malloc(bufsize);
+
+	if (!data) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
 	for (i = 0; i + l < bufsize; i += l) {
 		memcpy(data + i, usage_text, l);
 	}
 	memset(data + i, 0, bufsize - i);
+
+	input->name = "synthetic";
+	input->data = data;
+	input->size = bufsize;
+	return 0;
+}
+
+int benchmark(int argc, char **argv)
+{
+	enum bench_format format = BENCH_TEXT;
+	uint64_t min_ns = 200 * 1000000ULL;
+	struct bench_input *inputs;
+	struct bench_result *results;
+	int num_inputs, num_results = 0;
 	const struct typedesc_t *algo;
-	for (algo = &types_cbfs_compression[0]; algo->name != NULL; algo++) {
-		int outsize = bufsize;
-		printf("measuring '%s'\n", algo->name);
-		comp_func_ptr comp = compression_function(algo->type);
-		if (comp == NULL) {
-			printf("no handler associated with algorithm\n");
+	int i, c;
+	int ret = 1;
+
+	while ((c = getopt(argc, argv, "f:t:")) != -1) {
+		switch (c) {
+		case 'f':
+			if (!strcmp(optarg, "text"))
+				format = BENCH_TEXT;
+			else if (!strcmp(optarg, "csv"))
+				format = BENCH_CSV;
+			else if (!strcmp(optarg, "json"))
+				format = BENCH_JSON;
+			else {
+				usage();
+				return 1;
+			}
+			break;
+		case 't':
+			min_ns = strtoull(optarg, NULL, 0) * 1000000ULL;
+			break;
+		default:
+			usage();
 			return 1;
 		}
+	}
+
+	num_inputs = argc > optind ? argc - optind : 1;
+	inputs = calloc(num_inputs, sizeof(*inputs));
+	results = calloc(num_inputs * ARRAY_SIZE(types_cbfs_compression),
+			 sizeof(*results));
+	if (!inputs || !results) {
+		fprintf(stderr, "out of memory\n");
+		goto out;
+	}
 
-		struct timespec t_s, t_e;
-		clock_gettime(CLOCK_MONOTONIC, &t_s);
+	if (argc > optind) {
+		for (i = 0; i < num_inputs; i++) {
+			if (read_input(argv[optind + i], &inputs[i]))
+				goto out;
+		}
+	} else if (synthetic_input(&inputs[0]))
+		goto out;
 
-		if (comp(data, bufsize, compressed_data, &outsize)) {
-			printf("compression failed");
-			return 1;
+	for (i = 0; i < num_inputs; i++) {
+		if (inputs[i].size == 0) {
+			fprintf(stderr, "skipping empty '%s'\n",
+				inputs[i].name);
+			continue;
 		}
+		for (algo = &types_cbfs_compression[0]; algo->name != NULL;
+		     algo++) {
+			if (format == BENCH_TEXT)
+				fprintf(stderr, "measuring '%s' on '%s'\n",
+					algo->name, inputs[i].name);
+			if (bench_one(&inputs[i], algo, min_ns,
+				      &results[num_results]))
+				goto out;
+			num_results++;
+		}
+	}
 
-		clock_gettime(CLOCK_MONOTONIC, &t_e);
-		printf("compressing %d bytes to %d took %ld seconds\n",
-			bufsize, outsize,
-			t_e.tv_sec - t_s.tv_sec);
+	print_results(results, num_results, format);
+	ret = 0;
+out:
+	if (inputs) {
+		for (i = 0; i < num_inputs; i++)
+			free(inputs[i].data);
 	}
-	return 0;
+	free(inputs);
+	free(results);
+	return ret;
 }
 
 int compress(char *infile, char *outfile, char *algoname)
@@ -185,8 +589,8 @@ out:
 
 int main(int argc, char **argv)
 {
-	if ((argc == 2) && (strcmp(argv[1], "benchmark") == 0))
-		return benchmark();
+	if ((argc >= 2) && (strcmp(argv[1], "benchmark") == 0))
+		return benchmark(argc - 1, argv + 1);
 	if ((argc == 5) && (strcmp(argv[1], "compress") == 0))
 		return compress(argv[2], argv[3], argv[4]);
 	usage();
@@ -78,6 +78,7 @@ static struct param {
 	bool stage_xip;
 	bool autogen_attr;
 	bool machine_parseable;
+	bool pack;
 	int fit_empty_entries;
 	enum comp_algo compression;
 	int precompression;
@@ -96,6 +97,22 @@ static struct param {
 	.u64val = -1,
 };
 
+/*
+ * With batch -p, adds that don't need a particular position are held back
+ * here, per region, to be placed together by cbfs_place_entries().
+ */
+struct pending_region {
+	char *name;
+	struct buffer region;
+	uint32_t headeroffset;
+	struct cbfs_pending_entry *entries;
+	size_t num_entries;
+};
+
+static struct pending_region *pending_regions;
+static unsigned num_pending_regions;
+static bool defer_adds;
+
 static bool region_is_flashmap(const char *region)
 {
 	return partitioned_file_region_check_magic(param.image_file, region,
@@ -203,6 +220,152 @@ static int do_cbfs_locate(int32_t *cbfs_addr, size_t metadata_size)
 typedef int (*convert_buffer_t)(struct buffer *buffer, uint32_t *offset,
 	struct cbfs_file *header);
 
+static struct pending_region *find_pending_region(void)
+{
+	for (unsigned i = 0; i < num_pending_regions; ++i) {
+		if (pending_regions[i].region.offset ==
+						param.image_region->offset)
+			return pending_regions + i;
+	}
+	return NULL;
+}
+
+static bool is_pending(const char *name)
+{
+	struct pending_region *pending = find_pending_region();
+
+	if (!pending)
+		return false;
+	for (size_t i = 0; i < pending->num_entries; ++i) {
+		if (strcasecmp(pending->entries[i].header->filename, name) == 0)
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Adds the file right away, or, for batch -p, queues a copy of it if it can
+ * go anywhere. Files with a fixed position are always added right away so
+ * that the others get placed around them.
+ */
+static int add_or_defer_entry(struct cbfs_image *image, struct buffer *buffer,
+			      uint32_t offset, struct cbfs_file *header)
+{
+	struct pending_region *pending = find_pending_region();
+	struct cbfs_pending_entry *entry;
+
+	if (!defer_adds || offset)
+		return cbfs_add_entry(image, buffer, offset, header);
+
+	if (!pending) {
+		pending = realloc(pending_regions, (num_pending_regions + 1) *
+							sizeof(*pending));
+		if (!pending)
+			goto oom;
+		pending_regions = pending;
+		pending += num_pending_regions;
+		memset(pending, 0, sizeof(*pending));
+		pending->name = strdup(param.region_name);
+		if (!pending->name)
+			goto oom;
+		pending->region = *param.image_region;
+		pending->headeroffset = param.headeroffset;
+		num_pending_regions++;
+	}
+
+	entry = realloc(pending->entries, (pending->num_entries + 1) *
+							sizeof(*entry));
+	if (!entry)
+		goto oom;
+	pending->entries = entry;
+	entry += pending->num_entries;
+
+	entry->header = malloc(MAX_CBFS_FILE_HEADER_BUFFER);
+	if (!entry->header)
+		goto oom;
+	memcpy(entry->header, header, MAX_CBFS_FILE_HEADER_BUFFER);
+	if (buffer_create(&entry->buffer, buffer->size, buffer->name)) {
+		free(entry->header);
+		return 1;
+	}
+	memcpy(entry->buffer.data, buffer->data, buffer->size);
+	entry->align = param.alignment;
+	entry->page_size = param.pagesize;
+	pending->num_entries++;
+	return 0;
+
+oom:
+	ERROR("Out of memory.\n");
+	return 1;
+}
+
+static void drop_region_entries(struct pending_region *pending)
+{
+	for (size_t i = 0; i < pending->num_entries; ++i) {
+		buffer_delete(&pending->entries[i].buffer);
+		free(pending->entries[i].header);
+	}
+	free(pending->entries);
+	pending->entries = NULL;
+	pending->num_entries = 0;
+}
+
+static void drop_pending_entries(void)
+{
+	for (unsigned i = 0; i < num_pending_regions; ++i) {
+		drop_region_entries(pending_regions + i);
+		free(pending_regions[i].name);
+	}
+
+	free(pending_regions);
+	pending_regions = NULL;
+	num_pending_regions = 0;
+}
+
+/*
+ * Places the files held back by batch -p. The regions stay known so that
+ * print_pending_usage() can report on them once the manifest is done.
+ */
+static int place_pending_entries(void)
+{
+	int ret = 0;
+
+	for (unsigned i = 0; i < num_pending_regions; ++i) {
+		struct pending_region *pending = pending_regions + i;
+		struct cbfs_image image;
+
+		if (!pending->num_entries)
+			continue;
+
+		if (cbfs_image_from_buffer(&image, &pending->region,
+					   pending->headeroffset) ||
+		    cbfs_place_entries(&image, pending->entries,
+				       pending->num_entries)) {
+			ERROR("Failed to place the files for '%s'.\n",
+							pending->name);
+			ret = 1;
+		}
+		drop_region_entries(pending);
+		if (ret)
+			break;
+	}
+
+	return ret;
+}
+
+/* Reports the final layout of every region batch -p placed files in. */
+static void print_pending_usage(void)
+{
+	for (unsigned i = 0; i < num_pending_regions; ++i) {
+		struct pending_region *pending = pending_regions + i;
+		struct cbfs_image image;
+
+		if (cbfs_image_from_buffer(&image, &pending->region,
+					   pending->headeroffset) == 0)
+			cbfs_print_usage(&image, pending->name);
+	}
+}
+
 static int cbfs_add_integer_component(const char *name,
 			      uint64_t u64val,
 			      uint32_t offset,
@@ -228,7 +391,7 @@ static int cbfs_add_integer_component(const char *name,
 		goto done;
 	}
 
-	if (cbfs_get_entry(&image, name)) {
+	if (cbfs_get_entry(&image, name) || is_pending(name)) {
 		ERROR("'%s' already in ROM image.\n", name);
 		goto done;
 	}
@@ -239,7 +402,7 @@ static int cbfs_add_integer_component(const char *name,
 
 	header = cbfs_create_file_header(CBFS_COMPONENT_RAW,
 		buffer.size, name);
-	if (cbfs_add_entry(&image, &buffer, offset, header) != 0) {
+	if (add_or_defer_entry(&image, &buffer, offset, header) != 0) {
 		ERROR("Failed to add %llu into ROM image as '%s'.\n",
 					(long long unsigned)u64val, name);
 		goto done;
@@ -357,7 +520,7 @@ static int cbfs_add_component(const char *filename,
 	if (cbfs_image_from_buffer(&image, param.image_region, headeroffset))
 		return 1;
 
-	if (cbfs_get_entry(&image, name)) {
+	if (cbfs_get_entry(&image, name) || is_pending(name)) {
 		ERROR("'%s' already in ROM image.\n", name);
 		return 1;
 	}
@@ -425,7 +588,7 @@ static int cbfs_add_component(const char *filename,
 		offset = convert_to_from_top_aligned(param.image_region,
 								-offset);
 
-	if (cbfs_add_entry(&image, &buffer, offset, header) != 0) {
+	if (add_or_defer_entry(&image, &buffer, offset, header) != 0) {
 		ERROR("Failed to add '%s' into ROM image.\n", filename);
 		free(header);
 		buffer_delete(&buffer);
@@ -668,7 +831,9 @@ static int cbfs_add(void)
 		return 1;
 	}
 
-	if (param.alignment) {
+	/* A batch placing its files together takes care of the alignment,
+	 * unless the content depends on the address. */
+	if (param.alignment && !(defer_adds && convert == cbfstool_convert_raw)) {
 		/* CBFS compression file attribute is unconditionally added. */
 		size_t metadata_sz = sizeof(struct cbfs_file_attr_compression);
 		if (do_cbfs_locate(&address, metadata_sz))
@@ -927,8 +1092,10 @@ static int cbfs_print(void)
 		return 1;
 	if (param.machine_parseable)
 		return cbfs_print_parseable_directory(&image);
-	else
-		return cbfs_print_directory(&image);
+	if (cbfs_print_directory(&image))
+		return 1;
+	cbfs_print_usage(&image, param.region_name);
+	return 0;
 }
 
 static int cbfs_extract(void)
@@ -1163,6 +1330,7 @@ static struct option long_options[] = {
 	{"xip",           no_argument,       0, 'y' },
 	{"gen-attribute", no_argument,       0, 'g' },
 	{"mach-parseable",no_argument,       0, 'k' },
+	{"pack",          no_argument,       0, 'p' },
 	{NULL,            0,                 0,  0  }
 };
 
@@ -1279,12 +1447,23 @@ static void usage(char *name)
 	     " update-fit [-r image,regions] -n MICROCODE_BLOB_NAME \\\n"
 	     "        -x EMTPY_FIT_ENTRIES                                 "
 			"Updates the FIT table with microcode entries\n"
+	     " batch -f manifest [-p]                                      "
+			"Run the commands in manifest in one go\n"
 	     "\n"
 	     "OFFSETs:\n"
 	     "  Numbers accompanying -b, -H, and -o switches* may be provided\n"
 	     "  in two possible formats: if their value is greater than\n"
 	     "  0x80000000, they are interpreted as a top-aligned x86 memory\n"
 	     "  address; otherwise, they are treated as an offset into flash.\n"
+	     "MANIFESTs:\n"
+	     "  One command per line, written like on the command line but\n"
+	     "  without the program and FILE names. Quotes group blanks, '#'\n"
+	     "  starts a comment. The image is only written if all succeed.\n"
+	     "  With -p, files that can go anywhere are placed together\n"
+	     "  once the adds are done, largest and most aligned first.\n"
+	     "ENVIRONMENT:\n"
+	     "  CBFSTOOL_THREADS limits the number of threads used for\n"
+	     "  compression. The default is one per CPU.\n"
 	     "ARCHes:\n"
 	     "  arm64, arm, mips, x86\n"
 	     "TYPEs:\n", name, name
@@ -1312,339 +1491,638 @@ static void usage(char *name)
 	     );
 }
 
-int main(int argc, char **argv)
+/* Parses the options of command from argv, starting at optind. */
+static int parse_options(const struct command *command, int argc, char **argv)
 {
-	size_t i;
 	int c;
 
-	if (argc < 3) {
-		usage(argv[0]);
-		return 1;
-	}
+	while (1) {
+		char *suffix = NULL;
+		int option_index = 0;
 
-	char *image_name = argv[1];
-	char *cmd = argv[2];
-	optind += 2;
+		c = getopt_long(argc, argv, command->optstring,
+					long_options, &option_index);
+		if (c == -1) {
+			if (optind < argc) {
+				ERROR("%s: excessive argument -- '%s'"
+					"\n", argv[0], argv[optind]);
+				return 1;
+			}
+			break;
+		}
 
-	for (i = 0; i < ARRAY_SIZE(commands); i++) {
-		if (strcmp(cmd, commands[i].name) != 0)
-			continue;
+		/* filter out illegal long options */
+		if (strchr(command->optstring, c) == NULL) {
+			/* TODO maybe print actual long option instead */
+			ERROR("%s: invalid option -- '%c'\n",
+			      argv[0], c);
+			c = '?';
+		}
 
-		while (1) {
-			char *suffix = NULL;
-			int option_index = 0;
-
-			c = getopt_long(argc, argv, commands[i].optstring,
-						long_options, &option_index);
-			if (c == -1) {
-				if (optind < argc) {
-					ERROR("%s: excessive argument -- '%s'"
-						"\n", argv[0], argv[optind]);
-					return 1;
-				}
+		switch(c) {
+		case 'n':
+			param.name = optarg;
+			break;
+		case 't':
+			if (intfiletype(optarg) != ((uint64_t) - 1))
+				param.type = intfiletype(optarg);
+			else
+				param.type = strtoul(optarg, NULL, 0);
+			if (param.type == 0)
+				WARN("Unknown type '%s' ignored\n",
+						optarg);
+			break;
+		case 'c': {
+			if (strcmp(optarg, "precompression") == 0) {
+				param.precompression = 1;
 				break;
 			}
-
-			/* filter out illegal long options */
-			if (strchr(commands[i].optstring, c) == NULL) {
-				/* TODO maybe print actual long option instead */
-				ERROR("%s: invalid option -- '%c'\n",
-				      argv[0], c);
-				c = '?';
+			int algo = cbfs_parse_comp_algo(optarg);
+			if (algo >= 0)
+				param.compression = algo;
+			else
+				WARN("Unknown compression '%s' ignored.\n",
+								optarg);
+			break;
+		}
+		case 'A': {
+			int algo = cbfs_parse_hash_algo(optarg);
+			if (algo >= 0)
+				param.hash = algo;
+			else {
+				ERROR("Unknown hash algorithm '%s'.\n",
+					optarg);
+				return 1;
 			}
-
-			switch(c) {
-			case 'n':
-				param.name = optarg;
-				break;
-			case 't':
-				if (intfiletype(optarg) != ((uint64_t) - 1))
-					param.type = intfiletype(optarg);
-				else
-					param.type = strtoul(optarg, NULL, 0);
-				if (param.type == 0)
-					WARN("Unknown type '%s' ignored\n",
-							optarg);
-				break;
-			case 'c': {
-				if (strcmp(optarg, "precompression") == 0) {
-					param.precompression = 1;
-					break;
-				}
-				int algo = cbfs_parse_comp_algo(optarg);
-				if (algo >= 0)
-					param.compression = algo;
-				else
-					WARN("Unknown compression '%s' ignored.\n",
-									optarg);
-				break;
+			break;
+		}
+		case 'M':
+			param.fmap = optarg;
+			break;
+		case 'r':
+			param.region_name = optarg;
+			break;
+		case 'R':
+			param.source_region = optarg;
+			break;
+		case 'b':
+			param.baseaddress = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid base address '%s'.\n",
+					optarg);
+				return 1;
 			}
-			case 'A': {
-				int algo = cbfs_parse_hash_algo(optarg);
-				if (algo >= 0)
-					param.hash = algo;
-				else {
-					ERROR("Unknown hash algorithm '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
+			// baseaddress may be zero on non-x86, so we
+			// need an explicit "baseaddress_assigned".
+			param.baseaddress_assigned = 1;
+			break;
+		case 'l':
+			param.loadaddress = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid load address '%s'.\n",
+					optarg);
+				return 1;
 			}
-			case 'M':
-				param.fmap = optarg;
-				break;
-			case 'r':
-				param.region_name = optarg;
-				break;
-			case 'R':
-				param.source_region = optarg;
-				break;
-			case 'b':
-				param.baseaddress = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid base address '%s'.\n",
-						optarg);
-					return 1;
-				}
-				// baseaddress may be zero on non-x86, so we
-				// need an explicit "baseaddress_assigned".
-				param.baseaddress_assigned = 1;
-				break;
-			case 'l':
-				param.loadaddress = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid load address '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'e':
-				param.entrypoint = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid entry point '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 's':
-				param.size = strtoul(optarg, &suffix, 0);
-				if (!*optarg) {
-					ERROR("Empty size specified.\n");
-					return 1;
-				}
-				switch (tolower((int)suffix[0])) {
-				case 'k':
-					param.size *= 1024;
-					break;
-				case 'm':
-					param.size *= 1024 * 1024;
-					break;
-				case '\0':
-					break;
-				default:
-					ERROR("Invalid suffix for size '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'B':
-				param.bootblock = optarg;
-				break;
-			case 'H':
-				param.headeroffset = strtoul(
-						optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid header offset '%s'.\n",
-						optarg);
-					return 1;
-				}
-				param.headeroffset_assigned = 1;
-				break;
-			case 'a':
-				param.alignment = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid alignment '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'P':
-				param.pagesize = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid page size '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'o':
-				param.cbfsoffset = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid cbfs offset '%s'.\n",
-						optarg);
-					return 1;
-				}
-				param.cbfsoffset_assigned = 1;
-				break;
-			case 'f':
-				param.filename = optarg;
-				break;
-			case 'F':
-				param.force = 1;
-				break;
-			case 'i':
-				param.u64val = strtoull(optarg, &suffix, 0);
-				param.u64val_assigned = 1;
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid int parameter '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'u':
-				param.fill_partial_upward = true;
-				break;
-			case 'd':
-				param.fill_partial_downward = true;
-				break;
-			case 'w':
-				param.show_immutable = true;
-				break;
-			case 'x':
-				param.fit_empty_entries = strtol(
-						optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid number of fit entries "
-						"'%s'.\n", optarg);
-					return 1;
-				}
-				break;
-			case 'v':
-				verbose++;
+			break;
+		case 'e':
+			param.entrypoint = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid entry point '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 's':
+			param.size = strtoul(optarg, &suffix, 0);
+			if (!*optarg) {
+				ERROR("Empty size specified.\n");
+				return 1;
+			}
+			switch (tolower((int)suffix[0])) {
+			case 'k':
+				param.size *= 1024;
 				break;
 			case 'm':
-				param.arch = string_to_arch(optarg);
-				break;
-			case 'I':
-				param.initrd = optarg;
+				param.size *= 1024 * 1024;
 				break;
-			case 'C':
-				param.cmdline = optarg;
+			case '\0':
 				break;
-			case 'S':
-				param.ignore_section = optarg;
-				break;
-			case 'y':
-				param.stage_xip = true;
-				break;
-			case 'g':
-				param.autogen_attr = true;
-				break;
-			case 'k':
-				param.machine_parseable = true;
-				break;
-			case 'h':
-			case '?':
-				usage(argv[0]);
-				return 1;
 			default:
-				break;
+				ERROR("Invalid suffix for size '%s'.\n",
+					optarg);
+				return 1;
 			}
-		}
-
-		if (commands[i].function == cbfs_create) {
-			if (param.fmap) {
-				struct buffer flashmap;
-				if (buffer_from_file(&flashmap, param.fmap))
-					return 1;
-				param.image_file = partitioned_file_create(
-							image_name, &flashmap);
-				buffer_delete(&flashmap);
-			} else if (param.size) {
-				param.image_file = partitioned_file_create_flat(
-							image_name, param.size);
-			} else {
-				ERROR("You need to specify a valid -M/--flashmap or -s/--size.\n");
+			break;
+		case 'B':
+			param.bootblock = optarg;
+			break;
+		case 'H':
+			param.headeroffset = strtoul(
+					optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid header offset '%s'.\n",
+					optarg);
 				return 1;
 			}
-		} else {
-			bool write_access = commands[i].modifies_region;
+			param.headeroffset_assigned = 1;
+			break;
+		case 'a':
+			param.alignment = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid alignment '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'P':
+			param.pagesize = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid page size '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'o':
+			param.cbfsoffset = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid cbfs offset '%s'.\n",
+					optarg);
+				return 1;
+			}
+			param.cbfsoffset_assigned = 1;
+			break;
+		case 'f':
+			param.filename = optarg;
+			break;
+		case 'F':
+			param.force = 1;
+			break;
+		case 'i':
+			param.u64val = strtoull(optarg, &suffix, 0);
+			param.u64val_assigned = 1;
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid int parameter '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'u':
+			param.fill_partial_upward = true;
+			break;
+		case 'd':
+			param.fill_partial_downward = true;
+			break;
+		case 'w':
+			param.show_immutable = true;
+			break;
+		case 'x':
+			param.fit_empty_entries = strtol(
+					optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid number of fit entries "
+					"'%s'.\n", optarg);
+				return 1;
+			}
+			break;
+		case 'v':
+			verbose++;
+			break;
+		case 'm':
+			param.arch = string_to_arch(optarg);
+			break;
+		case 'I':
+			param.initrd = optarg;
+			break;
+		case 'C':
+			param.cmdline = optarg;
+			break;
+		case 'S':
+			param.ignore_section = optarg;
+			break;
+		case 'y':
+			param.stage_xip = true;
+			break;
+		case 'g':
+			param.autogen_attr = true;
+			break;
+		case 'k':
+			param.machine_parseable = true;
+			break;
+		case 'p':
+			param.pack = true;
+			break;
+		case 'h':
+		case '?':
+			usage(argv[0]);
+			return 1;
+		default:
+			break;
+		}
+	}
 
-			param.image_file =
-				partitioned_file_reopen(image_name,
-							write_access);
+
+	return 0;
+}
+
+/*
+ * Runs command on every region of the -r list. The buffers of the regions
+ * it modified are appended to *modified; they still point into the image
+ * and the caller is responsible for writing them back.
+ */
+static int run_command(const struct command *command,
+		       struct buffer **modified, unsigned *num_modified)
+{
+	unsigned num_regions = 1;
+	for (const char *list = strchr(param.region_name, ','); list;
+					list = strchr(list + 1, ','))
+		++num_regions;
+
+	// If the action needs to read an image region, as indicated by
+	// having accesses_region set in its command struct, that
+	// region's buffer struct will be stored here and the client
+	// will receive a pointer to it via param.image_region. It
+	// need not write the buffer back to the image file itself,
+	// since this behavior can be requested via its modifies_region
+	// field. Additionally, it should never free the region buffer,
+	// as that is performed automatically once it completes.
+	struct buffer image_regions[num_regions];
+	memset(image_regions, 0, sizeof(image_regions));
+
+	bool seen_primary_cbfs = false;
+	char region_name_scratch[strlen(param.region_name) + 1];
+	strcpy(region_name_scratch, param.region_name);
+	param.region_name = strtok(region_name_scratch, ",");
+	for (unsigned region = 0; region < num_regions; ++region) {
+		if (!param.region_name) {
+			ERROR("Encountered illegal degenerate region name in -r list\n");
+			ERROR("The image will be left unmodified.\n");
+			return 1;
 		}
-		if (!param.image_file)
+
+		if (strcmp(param.region_name, SECTION_NAME_PRIMARY_CBFS) == 0)
+			seen_primary_cbfs = true;
+
+		param.image_region = image_regions + region;
+		if (dispatch_command(*command))
 			return 1;
 
-		unsigned num_regions = 1;
-		for (const char *list = strchr(param.region_name, ','); list;
-						list = strchr(list + 1, ','))
-			++num_regions;
-
-		// If the action needs to read an image region, as indicated by
-		// having accesses_region set in its command struct, that
-		// region's buffer struct will be stored here and the client
-		// will receive a pointer to it via param.image_region. It
-		// need not write the buffer back to the image file itself,
-		// since this behavior can be requested via its modifies_region
-		// field. Additionally, it should never free the region buffer,
-		// as that is performed automatically once it completes.
-		struct buffer image_regions[num_regions];
-		memset(image_regions, 0, sizeof(image_regions));
-
-		bool seen_primary_cbfs = false;
-		char region_name_scratch[strlen(param.region_name) + 1];
-		strcpy(region_name_scratch, param.region_name);
-		param.region_name = strtok(region_name_scratch, ",");
-		for (unsigned region = 0; region < num_regions; ++region) {
-			if (!param.region_name) {
-				ERROR("Encountered illegal degenerate region name in -r list\n");
-				ERROR("The image will be left unmodified.\n");
-				partitioned_file_close(param.image_file);
-				return 1;
-			}
+		param.region_name = strtok(NULL, ",");
+	}
+	param.region_name = NULL;
+	param.image_region = NULL;
 
-			if (strcmp(param.region_name, SECTION_NAME_PRIMARY_CBFS)
-									== 0)
-				seen_primary_cbfs = true;
+	if (command->function == cbfs_create && !seen_primary_cbfs) {
+		ERROR("The creation -r list must include the mandatory '%s' section.\n",
+					SECTION_NAME_PRIMARY_CBFS);
+		ERROR("The image will be left unmodified.\n");
+		return 1;
+	}
 
-			param.image_region = image_regions + region;
-			if (dispatch_command(commands[i])) {
-				partitioned_file_close(param.image_file);
-				return 1;
-			}
+	if (!command->modifies_region)
+		return 0;
+
+	struct buffer *list = realloc(*modified, (*num_modified + num_regions) *
+							sizeof(*list));
+	if (!list) {
+		ERROR("Out of memory.\n");
+		return 1;
+	}
+	memcpy(list + *num_modified, image_regions, sizeof(image_regions));
+	*modified = list;
+	*num_modified += num_regions;
+	return 0;
+}
 
-			param.region_name = strtok(NULL, ",");
+static int write_regions(struct buffer *regions, unsigned num_regions)
+{
+	for (unsigned region = 0; region < num_regions; ++region) {
+		// A region modified by several batch commands only needs
+		// to be written once.
+		unsigned prev;
+		for (prev = 0; prev < region; ++prev) {
+			if (regions[prev].offset == regions[region].offset &&
+			    regions[prev].size == regions[region].size)
+				break;
 		}
+		if (prev < region)
+			continue;
 
-		if (commands[i].function == cbfs_create && !seen_primary_cbfs) {
-			ERROR("The creation -r list must include the mandatory '%s' section.\n",
-						SECTION_NAME_PRIMARY_CBFS);
-			ERROR("The image will be left unmodified.\n");
-			partitioned_file_close(param.image_file);
+		if (!partitioned_file_write_region(param.image_file,
+							regions + region))
 			return 1;
-		}
+	}
+	return 0;
+}
 
-		if (commands[i].modifies_region) {
-			assert(param.image_file);
-			for (unsigned region = 0; region < num_regions;
-								++region) {
-
-				if (!partitioned_file_write_region(
-							param.image_file,
-						image_regions + region)) {
-					partitioned_file_close(
-							param.image_file);
-					return 1;
-				}
+static const struct command *find_command(const char *name)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(commands); i++) {
+		if (strcmp(name, commands[i].name) == 0)
+			return commands + i;
+	}
+	return NULL;
+}
+
+static bool is_add_command(const struct command *command)
+{
+	return command->function == cbfs_add ||
+	       command->function == cbfs_add_stage ||
+	       command->function == cbfs_add_payload ||
+	       command->function == cbfs_add_flat_binary ||
+	       command->function == cbfs_add_integer;
+}
+
+#define BATCH_MAX_ARGS	64
+
+struct batch_line {
+	const struct command *command;
+	char *text;
+	int argc;
+	char *argv[BATCH_MAX_ARGS + 1];
+	unsigned lineno;
+};
+
+/*
+ * Splits line in place into arguments separated by blanks. Single or double
+ * quotes group blanks into an argument, as they do in the shell, but there
+ * are no escapes. Everything from an unquoted '#' on is a comment.
+ */
+static int batch_split_line(char *line, struct batch_line *batch)
+{
+	char *in = line;
+	char *out = line;
+
+	while (1) {
+		char quote = 0;
+
+		while (*in == ' ' || *in == '\t' || *in == '\n' || *in == '\r')
+			in++;
+		if (*in == '\0' || *in == '#')
+			break;
+
+		if (batch->argc == BATCH_MAX_ARGS) {
+			ERROR("Too many arguments.\n");
+			return 1;
+		}
+		batch->argv[batch->argc++] = out;
+
+		for (; *in; in++) {
+			if (quote && *in == quote) {
+				quote = 0;
+			} else if (!quote && (*in == '"' || *in == '\'')) {
+				quote = *in;
+			} else if (!quote && (*in == ' ' || *in == '\t' ||
+					      *in == '\n' || *in == '\r')) {
+				break;
+			} else {
+				*out++ = *in;
 			}
 		}
+		if (quote) {
+			ERROR("Unterminated quote.\n");
+			return 1;
+		}
+		// The output never overtakes the input, so this is safe even
+		// when it overwrites the separator just looked at.
+		if (*in)
+			in++;
+		*out++ = '\0';
+	}
+	batch->argv[batch->argc] = NULL;
+	return 0;
+}
+
+/*
+ * Reads a manifest of cbfstool commands, one per line, into lines. Each line
+ * looks like a command line without the program and image names. Returns the
+ * number of commands or -1 on error.
+ */
+static int batch_read_manifest(const char *manifest, char *program,
+			       struct batch_line **lines)
+{
+	FILE *f;
+	char *text = NULL;
+	size_t text_size = 0;
+	unsigned lineno = 0;
+	int num_lines = 0;
+
+	*lines = NULL;
+
+	f = fopen(manifest, "r");
+	if (!f) {
+		ERROR("Could not open manifest '%s'.\n", manifest);
+		return -1;
+	}
+
+	while (getline(&text, &text_size, f) != -1) {
+		struct batch_line *line;
+		struct batch_line *list;
+
+		lineno++;
+
+		list = realloc(*lines, (num_lines + 1) * sizeof(*list));
+		if (!list)
+			goto oom;
+		*lines = list;
+
+		line = list + num_lines;
+		memset(line, 0, sizeof(*line));
+		line->lineno = lineno;
+		// The arguments end up in param and have to outlive the
+		// line they came from.
+		line->argv[line->argc++] = program;
+		line->text = strdup(text);
+		if (!line->text)
+			goto oom;
+		if (batch_split_line(line->text, line)) {
+			ERROR("%s:%u: Can't parse the line.\n", manifest,
+								lineno);
+			free(line->text);
+			goto fail;
+		}
+		if (line->argc == 1) {
+			free(line->text);
+			continue;
+		}
 
-		partitioned_file_close(param.image_file);
-		return 0;
+		line->command = find_command(line->argv[1]);
+		if (!line->command || line->command->function == cbfs_create) {
+			ERROR("%s:%u: Command '%s' isn't supported in a batch.\n",
+						manifest, lineno, line->argv[1]);
+			free(line->text);
+			goto fail;
+		}
+		num_lines++;
 	}
 
-	ERROR("Unknown command '%s'.\n", cmd);
-	usage(argv[0]);
-	return 1;
+	if (ferror(f)) {
+		ERROR("Could not read manifest '%s'.\n", manifest);
+		goto fail;
+	}
+
+	free(text);
+	fclose(f);
+	return num_lines;
+
+oom:
+	ERROR("Out of memory.\n");
+fail:
+	free(text);
+	fclose(f);
+	for (int i = 0; i < num_lines; ++i)
+		free((*lines)[i].text);
+	free(*lines);
+	*lines = NULL;
+	return -1;
+}
+
+/*
+ * Runs every command of the manifest against the image in memory and writes
+ * the regions they modified back once at the end. The result is the same as
+ * that of running the commands one by one, except that nothing is written
+ * if any of them fails. With -p, adds that can go anywhere are held back
+ * until the next other command or the end and then placed together, so the
+ * layout will differ from that of sequential runs.
+ */
+static int cbfs_batch(const char *image_name, char *program,
+		      const struct param *defaults)
+{
+	struct buffer *modified = NULL;
+	unsigned num_modified = 0;
+	struct batch_line *lines;
+	int saved_verbose = verbose;
+	int num_lines;
+	int ret = 1;
+	int i;
+
+	if (!param.filename) {
+		ERROR("You need to specify a manifest with -f.\n");
+		return 1;
+	}
+
+	num_lines = batch_read_manifest(param.filename, program, &lines);
+	if (num_lines < 0)
+		return 1;
+
+	param.image_file = partitioned_file_reopen(image_name, true);
+	if (!param.image_file)
+		goto out;
+
+	defer_adds = param.pack;
+	for (i = 0; i < num_lines; ++i) {
+		partitioned_file_t *image_file = param.image_file;
+
+		param = *defaults;
+		param.image_file = image_file;
+		verbose = saved_verbose;
+
+		// Skip the command name like main() skips the image name.
+		lines[i].argv[1] = lines[i].argv[0];
+		optind = 0;
+		if (parse_options(lines[i].command, lines[i].argc - 1,
+				  lines[i].argv + 1))
+			goto fail;
+
+		// Anything else may look at or move the files held back.
+		if (!is_add_command(lines[i].command) &&
+		    place_pending_entries())
+			goto unmodified;
+
+		INFO("Running %s (manifest line %u)\n", lines[i].command->name,
+							lines[i].lineno);
+		if (run_command(lines[i].command, &modified, &num_modified))
+			goto fail;
+	}
+
+	if (place_pending_entries())
+		goto unmodified;
+
+	ret = write_regions(modified, num_modified);
+	if (!ret)
+		print_pending_usage();
+	goto close;
+
+fail:
+	ERROR("Failed in manifest line %u, the image will be left unmodified.\n",
+							lines[i].lineno);
+	goto close;
+unmodified:
+	ERROR("The image will be left unmodified.\n");
+close:
+	drop_pending_entries();
+	partitioned_file_close(param.image_file);
+out:
+	for (i = 0; i < num_lines; ++i)
+		free(lines[i].text);
+	free(lines);
+	free(modified);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	const struct param defaults = param;
+	const struct command *command;
+	struct buffer *modified = NULL;
+	unsigned num_modified = 0;
+
+	if (argc < 3) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	char *image_name = argv[1];
+	char *cmd = argv[2];
+	optind += 2;
+
+	if (strcmp(cmd, "batch") == 0) {
+		static const struct command batch = {
+			"batch", "f:pvh?", NULL, false, false
+		};
+
+		if (parse_options(&batch, argc, argv))
+			return 1;
+		return cbfs_batch(image_name, argv[0], &defaults);
+	}
+
+	command = find_command(cmd);
+	if (!command) {
+		ERROR("Unknown command '%s'.\n", cmd);
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (parse_options(command, argc, argv))
+		return 1;
+
+	if (command->function == cbfs_create) {
+		if (param.fmap) {
+			struct buffer flashmap;
+			if (buffer_from_file(&flashmap, param.fmap))
+				return 1;
+			param.image_file = partitioned_file_create(
+						image_name, &flashmap);
+			buffer_delete(&flashmap);
+		} else if (param.size) {
+			param.image_file = partitioned_file_create_flat(
+						image_name, param.size);
+		} else {
+			ERROR("You need to specify a valid -M/--flashmap or -s/--size.\n");
+			return 1;
+		}
+	} else {
+		bool write_access = command->modifies_region;
+
+		param.image_file =
+			partitioned_file_reopen(image_name, write_access);
+	}
+	if (!param.image_file)
+		return 1;
+
+	int ret = run_command(command, &modified, &num_modified) ||
+		  write_regions(modified, num_modified);
+
+	free(modified);
+	partitioned_file_close(param.image_file);
+	return ret;
 }
@@ -19,6 +19,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -91,6 +93,47 @@ int buffer_from_file(struct buffer *buffer, const char *filename)
 	return 0;
 }
 
+int buffer_map_file(struct buffer *buffer, const char *filename)
+{
+	struct stat st;
+	void *data;
+	int fd;
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	/* mmap() can't do empty files, and pipes have no pages to share. */
+	if (fstat(fd, &st) || !S_ISREG(st.st_mode) || st.st_size == 0) {
+		close(fd);
+		return -1;
+	}
+	/* Writable, but the changes are private copies of the touched pages. */
+	data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+									0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return -1;
+
+	buffer->name = strdup(filename);
+	buffer->offset = 0;
+	buffer->size = st.st_size;
+	buffer->data = data;
+	return 0;
+}
+
+void buffer_unmap(struct buffer *buffer)
+{
+	assert(buffer);
+	free(buffer->name);
+	buffer->name = NULL;
+	if (buffer->data)
+		munmap(buffer_get_original_backing(buffer),
+					buffer->offset + buffer->size);
+	buffer->data = NULL;
+	buffer->offset = 0;
+	buffer->size = 0;
+}
+
 int buffer_write_file(struct buffer *buffer, const char *filename)
 {
 	FILE *fp = fopen(filename, "wb");
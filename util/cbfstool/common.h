@@ -135,6 +135,17 @@ int buffer_create(struct buffer *buffer, size_t size, const char *name);
 /* Loads a file into memory buffer. Returns 0 on success, otherwise non-zero. */
 int buffer_from_file(struct buffer *buffer, const char *filename);
 
+/*
+ * Maps a regular file into a buffer instead of reading it. Pages are only
+ * read from the file when they are first used, and changes to the buffer
+ * stay private to the process. Returns 0 on success, otherwise non-zero.
+ * A mapped buffer must be released with buffer_unmap(), not buffer_delete().
+ */
+int buffer_map_file(struct buffer *buffer, const char *filename);
+
+/* Releases a buffer set up by buffer_map_file(). */
+void buffer_unmap(struct buffer *buffer);
+
 /* Writes memory buffer content into file.
  * Returns 0 on success, otherwise non-zero. */
 int buffer_write_file(struct buffer *buffer, const char *filename);
@@ -181,6 +192,22 @@ static const struct typedesc_t types_cbfs_compression[] = {
 comp_func_ptr compression_function(enum comp_algo algo);
 decomp_func_ptr decompression_function(enum comp_algo algo);
 
+struct compression_job {
+	char *in;
+	int in_len;
+	char *out;
+	int out_len;
+	/* What the compression function returned. */
+	int ret;
+};
+
+/*
+ * Run compress on all jobs, in as many threads as there are CPUs or as
+ * CBFSTOOL_THREADS says. The results don't depend on the number of threads.
+ */
+void compress_parallel(comp_func_ptr compress, struct compression_job *jobs,
+		       int num_jobs);
+
 uint64_t intfiletype(const char *name);
 
 /* cbfs-mkpayload.c */
@@ -211,6 +238,9 @@ int do_lzma_compress(char *in, int in_len, char *out, int *out_len);
 int do_lzma_uncompress(char *dst, int dst_len, char *src, int src_len,
 			size_t *actual_size);
 
+/* firmware_lzma.c */
+size_t firmware_ulzman(const void *src, size_t srcn, void *dst, size_t dstn);
+
 /* xdr.c */
 struct xdr {
 	uint8_t (*get8)(struct buffer *input);
@@ -18,31 +18,212 @@
  * GNU General Public License for more details.
  */
 
+#include <pthread.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include "common.h"
 #include "lz4/lib/lz4frame.h"
 #include <commonlib/compression.h>
 
-static int lz4_compress(char *in, int in_len, char *out, int *out_len)
+/* Set in the threads of compress_parallel(), which must not nest. */
+static __thread int in_compression_thread;
+
+static int compression_threads(void)
 {
-	LZ4F_preferences_t prefs = {
-		.compressionLevel = 20,
-		.frameInfo = {
-			.blockSizeID = max4MB,
-			.blockMode = blockIndependent,
-			.contentChecksumFlag = noContentChecksum,
-		},
+	const char *env = getenv("CBFSTOOL_THREADS");
+	long threads;
+
+	if (in_compression_thread)
+		return 1;
+
+	if (env)
+		threads = strtol(env, NULL, 0);
+	else
+		threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return threads < 1 ? 1 : threads;
+}
+
+struct compression_pool {
+	comp_func_ptr compress;
+	struct compression_job *jobs;
+	int num_jobs;
+	int next_job;
+	pthread_mutex_t lock;
+};
+
+static void *compression_worker(void *arg)
+{
+	struct compression_pool *pool = arg;
+	struct compression_job *job;
+	int i;
+
+	in_compression_thread = 1;
+
+	for (;;) {
+		pthread_mutex_lock(&pool->lock);
+		i = pool->next_job++;
+		pthread_mutex_unlock(&pool->lock);
+
+		if (i >= pool->num_jobs)
+			break;
+
+		job = &pool->jobs[i];
+		job->ret = pool->compress(job->in, job->in_len, job->out,
+					  &job->out_len);
+	}
+
+	return NULL;
+}
+
+void compress_parallel(comp_func_ptr compress, struct compression_job *jobs,
+		       int num_jobs)
+{
+	struct compression_pool pool = {
+		.compress = compress,
+		.jobs = jobs,
+		.num_jobs = num_jobs,
 	};
-	size_t worst_size = LZ4F_compressFrameBound(in_len, &prefs);
+	int threads = compression_threads();
+	pthread_t *tids;
+	int i, started = 0;
+
+	if (threads > num_jobs)
+		threads = num_jobs;
+
+	/* The calling thread works, too. */
+	tids = threads > 1 ? calloc(threads - 1, sizeof(*tids)) : NULL;
+	pthread_mutex_init(&pool.lock, NULL);
+
+	for (i = 0; tids && i < threads - 1; i++) {
+		if (pthread_create(&tids[i], NULL, compression_worker, &pool))
+			break;
+		started++;
+	}
+
+	if (started) {
+		compression_worker(&pool);
+		in_compression_thread = 0;
+	} else {
+		/* Not in a thread, nested compress_parallel() may use some. */
+		for (i = 0; i < num_jobs; i++)
+			jobs[i].ret = compress(jobs[i].in, jobs[i].in_len,
+					       jobs[i].out, &jobs[i].out_len);
+	}
+
+	for (i = 0; i < started; i++)
+		pthread_join(tids[i], NULL);
+
+	pthread_mutex_destroy(&pool.lock);
+	free(tids);
+}
+
+static const LZ4F_preferences_t lz4_prefs = {
+	.compressionLevel = 20,
+	.frameInfo = {
+		/* Small blocks let coreboot decompress while it
+		 * is still loading the rest of the image. */
+		.blockSizeID = max64KB,
+		.blockMode = blockIndependent,
+		.contentChecksumFlag = noContentChecksum,
+	},
+};
+
+/*
+ * With independent blocks and no content size or checksum, a frame is a
+ * header, the blocks compressed one by one, and an end mark. Parts of the
+ * input that are a multiple of the block size can be compressed as frames
+ * of their own and their blocks joined.
+ */
+#define LZ4_BLOCK_SIZE		(64 * 1024)
+#define LZ4_FRAME_HEADER_SIZE	7
+#define LZ4_FRAME_END_SIZE	4
+
+/* out must have room for LZ4F_compressFrameBound() bytes. */
+static int lz4_compress_frame(char *in, int in_len, char *out, int *out_len)
+{
+	size_t size = LZ4F_compressFrame(out,
+			LZ4F_compressFrameBound(in_len, &lz4_prefs), in,
+			in_len, &lz4_prefs);
+
+	if (LZ4F_isError(size))
+		return -1;
+	*out_len = size;
+	return 0;
+}
+
+/* Compress one block per job and join them. Returns the size or < 0. */
+static int lz4_compress_blocks(char *in, int in_len, char *out)
+{
+	int num_jobs = (in_len + LZ4_BLOCK_SIZE - 1) / LZ4_BLOCK_SIZE;
+	size_t bound = LZ4F_compressFrameBound(LZ4_BLOCK_SIZE, &lz4_prefs);
+	struct compression_job *jobs = calloc(num_jobs, sizeof(*jobs));
+	char *bounce = malloc(num_jobs * bound);
+	int out_len = -1;
+	int i;
+
+	if (!jobs || !bounce)
+		goto out;
+
+	for (i = 0; i < num_jobs; i++) {
+		jobs[i].in = in + i * LZ4_BLOCK_SIZE;
+		jobs[i].in_len = MIN(LZ4_BLOCK_SIZE, in_len - i * LZ4_BLOCK_SIZE);
+		jobs[i].out = bounce + i * bound;
+	}
+
+	compress_parallel(lz4_compress_frame, jobs, num_jobs);
+
+	if (jobs[0].ret || jobs[0].out_len < LZ4_FRAME_HEADER_SIZE)
+		goto fail;
+	memcpy(out, jobs[0].out, LZ4_FRAME_HEADER_SIZE);
+	out_len = LZ4_FRAME_HEADER_SIZE;
+
+	for (i = 0; i < num_jobs; i++) {
+		int size = jobs[i].out_len - LZ4_FRAME_HEADER_SIZE -
+			LZ4_FRAME_END_SIZE;
+
+		if (jobs[i].ret || size < 0 ||
+		    memcmp(jobs[i].out, out, LZ4_FRAME_HEADER_SIZE))
+			goto fail;
+		memcpy(out + out_len, jobs[i].out + LZ4_FRAME_HEADER_SIZE,
+		       size);
+		out_len += size;
+	}
+
+	memset(out + out_len, 0, LZ4_FRAME_END_SIZE);
+	out_len += LZ4_FRAME_END_SIZE;
+	goto out;
+
+fail:
+	out_len = -1;
+out:
+	free(jobs);
+	free(bounce);
+	return out_len;
+}
+
+static int lz4_compress(char *in, int in_len, char *out, int *out_len)
+{
+	size_t worst_size = LZ4F_compressFrameBound(in_len, &lz4_prefs);
 	void *bounce = malloc(worst_size);
 	if (!bounce)
 		return -1;
-	*out_len = LZ4F_compressFrame(bounce, worst_size, in, in_len, &prefs);
-	if (LZ4F_isError(*out_len) || *out_len >= in_len)
+	if (in_len > LZ4_BLOCK_SIZE && compression_threads() > 1)
+		*out_len = lz4_compress_blocks(in, in_len, bounce);
+	else
+		*out_len = -1;
+	if (*out_len < 0 && lz4_compress_frame(in, in_len, bounce, out_len)) {
+		free(bounce);
 		return -1;
+	}
+	if (*out_len >= in_len) {
+		free(bounce);
+		return -1;
+	}
 	memcpy(out, bounce, *out_len);
+	free(bounce);
 	return 0;
 }
 
@@ -0,0 +1,66 @@
+/*
+ * The LZMA decoder coreboot runs, built for the host
+ *
+ * Copyright (C) 2006 Carl-Daniel Hailfinger
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "common.h"
+
+/* The LZMA SDK used for compression has functions of the same names. */
+#define LzmaDecode firmware_LzmaDecode
+#define LzmaDecodeProperties firmware_LzmaDecodeProperties
+#define LzmaDecodeStream firmware_LzmaDecodeStream
+
+#include "../../src/lib/lzmadecode.c"
+
+/* Same as in src/lib/lzma.c */
+#define LZMA_HEADER_SIZE (LZMA_PROPERTIES_SIZE + 8)
+#define LZMA_SCRATCHPAD_SIZE 15980
+
+/* ulzman() from src/lib/lzma.c without the console output. */
+size_t firmware_ulzman(const void *src, size_t srcn, void *dst, size_t dstn)
+{
+	static unsigned char scratchpad[LZMA_SCRATCHPAD_SIZE];
+	const unsigned char *header = src;
+	CLzmaDecoderState state;
+	SizeT inProcessed;
+	SizeT outProcessed;
+	UInt32 outSize;
+
+	if (srcn < LZMA_HEADER_SIZE)
+		return 0;
+
+	outSize = header[LZMA_PROPERTIES_SIZE + 3] << 24 |
+		  header[LZMA_PROPERTIES_SIZE + 2] << 16 |
+		  header[LZMA_PROPERTIES_SIZE + 1] << 8 |
+		  header[LZMA_PROPERTIES_SIZE];
+	if (outSize > dstn)
+		return 0;
+
+	if (LzmaDecodeProperties(&state.Properties, header,
+				 LZMA_PROPERTIES_SIZE) != LZMA_RESULT_OK)
+		return 0;
+	if (LzmaGetNumProbs(&state.Properties) * sizeof(CProb) >
+	    LZMA_SCRATCHPAD_SIZE)
+		return 0;
+	state.Probs = (CProb *)scratchpad;
+
+	if (LzmaDecode(&state, header + LZMA_HEADER_SIZE,
+		       srcn - LZMA_HEADER_SIZE, &inProcessed, dst, outSize,
+		       &outProcessed) != LZMA_RESULT_OK)
+		return 0;
+
+	return outProcessed;
+}
@@ -51,29 +51,39 @@ struct vector_t {
 	size_t size;
 };
 
-static struct vector_t instream, outstream;
+/* Per call, so that several buffers can be compressed at once. */
+struct lzma_instream {
+	struct ISeqInStream is;
+	struct vector_t v;
+};
+
+struct lzma_outstream {
+	struct ISeqOutStream os;
+	struct vector_t v;
+};
 
-static SRes Read(unused void *u, void *buf, size_t *size)
+static SRes Read(void *p, void *buf, size_t *size)
 {
-	if ((instream.size - instream.pos) < *size)
-		*size = instream.size - instream.pos;
-	memcpy(buf, instream.p + instream.pos, *size);
-	instream.pos += *size;
+	struct vector_t *instream = &((struct lzma_instream *)p)->v;
+
+	if ((instream->size - instream->pos) < *size)
+		*size = instream->size - instream->pos;
+	memcpy(buf, instream->p + instream->pos, *size);
+	instream->pos += *size;
 	return SZ_OK;
 }
 
-static size_t Write(unused void *u, const void *buf, size_t size)
+static size_t Write(void *p, const void *buf, size_t size)
 {
-	if(outstream.size - outstream.pos < size)
-		size = outstream.size - outstream.pos;
-	memcpy(outstream.p + outstream.pos, buf, size);
-	outstream.pos += size;
+	struct vector_t *outstream = &((struct lzma_outstream *)p)->v;
+
+	if(outstream->size - outstream->pos < size)
+		size = outstream->size - outstream->pos;
+	memcpy(outstream->p + outstream->pos, buf, size);
+	outstream->pos += size;
 	return size;
 }
 
-static struct ISeqInStream is = { Read };
-static struct ISeqOutStream os = { Write };
-
 /**
  * Compress a buffer with lzma
  * Don't copy the result back if it is too large.
@@ -130,25 +140,27 @@ int do_lzma_compress(char *in, int in_len, char *out, int *out_len)
 		return -1;
 	}
 
-	instream.p = in;
-	instream.pos = 0;
-	instream.size = in_len;
-
-	outstream.p = out;
-	outstream.pos = 0;
-	outstream.size = in_len;
+	struct lzma_instream instream = {
+		.is = { Read },
+		.v = { .p = in, .pos = 0, .size = in_len },
+	};
+	struct lzma_outstream outstream = {
+		.os = { Write },
+		.v = { .p = out, .pos = 0, .size = in_len },
+	};
 
 	put_64(propsEncoded + LZMA_PROPS_SIZE, in_len);
-	Write(&os, propsEncoded, LZMA_PROPS_SIZE+8);
+	Write(&outstream, propsEncoded, LZMA_PROPS_SIZE+8);
 
-	res = LzmaEnc_Encode(p, &os, &is, 0, &LZMAalloc, &LZMAalloc);
+	res = LzmaEnc_Encode(p, &outstream.os, &instream.is, 0, &LZMAalloc,
+			     &LZMAalloc);
 	LzmaEnc_Destroy(p, &LZMAalloc, &LZMAalloc);
 	if (res != SZ_OK) {
 		ERROR("LZMA: LzmaEnc_Encode failed %d.\n", res);
 		return -1;
 	}
 
-	*out_len = outstream.pos;
+	*out_len = outstream.v.pos;
 	return 0;
 }
 
@@ -20,11 +20,17 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+/* Granularity in which a mapped image is compared to its backing file. */
+#define WRITE_BACK_BLOCK_SIZE	4096
 
 struct partitioned_file {
 	struct fmap *fmap;
 	struct buffer buffer;
 	FILE *stream;
+	// Whether buffer is a private mapping of the file rather than a copy
+	bool mapped;
 };
 
 static bool fill_ones_through(struct partitioned_file *file)
@@ -61,7 +67,12 @@ static partitioned_file_t *reopen_flat_file(const char *filename,
 		return NULL;
 	}
 
-	if (buffer_from_file(&file->buffer, filename)) {
+	// Mapping the image saves reading all of it for commands that only
+	// look at a few entries. Fall back to reading for anything that can't
+	// be mapped.
+	if (!buffer_map_file(&file->buffer, filename)) {
+		file->mapped = true;
+	} else if (buffer_from_file(&file->buffer, filename)) {
 		free(file);
 		return NULL;
 	}
@@ -206,6 +217,39 @@ partitioned_file_t *partitioned_file_reopen(const char *filename,
 	return file;
 }
 
+/*
+ * Pages of a mapped image that were never written to still come straight
+ * from the file, so only write back the blocks that actually differ from it.
+ */
+static bool write_changed_blocks(partitioned_file_t *file,
+						const struct buffer *buffer)
+{
+	char block[WRITE_BACK_BLOCK_SIZE];
+	int fd = fileno(file->stream);
+	size_t done;
+
+	if (fflush(file->stream)) {
+		ERROR("Failed to write to image file\n");
+		return false;
+	}
+
+	for (done = 0; done < buffer->size; done += sizeof(block)) {
+		size_t len = MIN(sizeof(block), buffer->size - done);
+		off_t offset = buffer->offset + done;
+
+		if (pread(fd, block, len, offset) == (ssize_t)len &&
+		    memcmp(block, buffer->data + done, len) == 0)
+			continue;
+
+		if (pwrite(fd, buffer->data + done, len, offset) !=
+								(ssize_t)len) {
+			ERROR("Failed to write to image file\n");
+			return false;
+		}
+	}
+	return true;
+}
+
 bool partitioned_file_write_region(partitioned_file_t *file,
 						const struct buffer *buffer)
 {
@@ -223,6 +267,9 @@ bool partitioned_file_write_region(partitioned_file_t *file,
 		return false;
 	}
 
+	if (file->mapped)
+		return write_changed_blocks(file, buffer);
+
 	if (fseek(file->stream, buffer->offset, SEEK_SET)) {
 		ERROR("Failed to seek within image file\n");
 		return false;
@@ -272,7 +319,10 @@ void partitioned_file_close(partitioned_file_t *file)
 		return;
 
 	file->fmap = NULL;
-	buffer_delete(&file->buffer);
+	if (file->mapped)
+		buffer_unmap(&file->buffer);
+	else
+		buffer_delete(&file->buffer);
 	if (file->stream) {
 		fclose(file->stream);
 		file->stream = NULL;
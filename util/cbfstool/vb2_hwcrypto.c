@@ -0,0 +1,41 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "common.h"
+#include <commonlib/cbfs.h>
+
+/* The host has no hardware digest, commonlib's CBFS hashing falls back to
+ * vboot's own. */
+
+int cbfs_hwcrypto_supported(unused enum vb2_hash_algorithm hash_alg)
+{
+	return 0;
+}
+
+int vb2ex_hwcrypto_digest_init(unused enum vb2_hash_algorithm hash_alg,
+			       unused uint32_t data_size)
+{
+	return VB2_ERROR_EX_HWCRYPTO_UNSUPPORTED;
+}
+
+int vb2ex_hwcrypto_digest_extend(unused const uint8_t *buf,
+				 unused uint32_t size)
+{
+	return VB2_ERROR_UNKNOWN;
+}
+
+int vb2ex_hwcrypto_digest_finalize(unused uint8_t *digest,
+				   unused uint32_t digest_size)
+{
+	return VB2_ERROR_UNKNOWN;
+}
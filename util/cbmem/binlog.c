@@ -0,0 +1,557 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <elf.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <commonlib/console_binlog_serialized.h>
+
+#include "binlog.h"
+#include "stage_elf.h"
+
+/*
+ * Formats the binary printk records of CONFIG_CONSOLE_CBMEM_BINARY. The
+ * format strings come from the stage ELFs the build leaves behind, the
+ * formatting itself is a copy of src/console/vtxprintf.c reading its
+ * arguments from the record instead of a va_list.
+ */
+
+/* Anything longer than this comes from a corrupted record. */
+#define BINLOG_MAX_OUTPUT	(64 * 1024)
+
+struct stage_strings {
+	uint8_t *image;
+	size_t size;
+};
+
+static struct stage_strings stages[CONSOLE_BINLOG_NUM_STAGES];
+static int have_strings;
+
+struct program_bounds {
+	uint64_t start;
+	uint64_t end;
+	int found;
+};
+
+static int find_program_bounds(const struct elf_symbol *sym, void *arg)
+{
+	struct program_bounds *b = arg;
+
+	if (!strcmp(sym->name, "_program")) {
+		b->start = sym->value;
+		b->found |= 1;
+	} else if (!strcmp(sym->name, "_eprogram")) {
+		b->end = sym->value;
+		b->found |= 2;
+	}
+
+	return 0;
+}
+
+static int load_stage(const char *path, struct stage_strings *stage)
+{
+	struct program_bounds bounds = { 0 };
+	struct elf_file elf;
+	uint64_t start, end;
+	unsigned int i;
+
+	if (elf_open(path, &elf))
+		return -1;
+
+	/* Look up _program and _eprogram in the symbol table. */
+	elf_for_each_symbol(&elf, find_program_bounds, &bounds);
+	start = bounds.start;
+	end = bounds.end;
+	if (bounds.found != 3 || start >= end ||
+	    end - start > 256 * 1024 * 1024)
+		goto fail;
+
+	stage->size = end - start;
+	stage->image = calloc(1, stage->size);
+	if (!stage->image)
+		goto fail;
+
+	/* Rebuild the loaded image from everything with contents. */
+	for (i = 0; i < elf_num_sections(&elf); i++) {
+		struct elf_section s;
+		uint64_t lo, hi;
+
+		if (elf_section(&elf, i, &s) || s.type == SHT_NOBITS ||
+		    !(s.flags & SHF_ALLOC))
+			continue;
+
+		lo = s.addr > start ? s.addr : start;
+		hi = s.addr + s.size < end ? s.addr + s.size : end;
+		if (lo >= hi)
+			continue;
+
+		memcpy(stage->image + (lo - start),
+		       elf.data + s.offset + (lo - s.addr), hi - lo);
+	}
+
+	elf_close(&elf);
+	return 0;
+
+fail:
+	fprintf(stderr, "%s: not a usable stage ELF\n", path);
+	elf_close(&elf);
+	return -1;
+}
+
+int binlog_load_strings(const char *dir)
+{
+	static const char *const names[] = { CONSOLE_BINLOG_STAGE_NAMES };
+	int found = 0;
+	int i;
+
+	for (i = CONSOLE_BINLOG_BOOTBLOCK; i < CONSOLE_BINLOG_NUM_STAGES; i++) {
+		char path[4096];
+
+		snprintf(path, sizeof(path), "%s/%s.debug", dir, names[i]);
+		if (!load_stage(path, &stages[i]))
+			found++;
+	}
+
+	have_strings = 1;
+
+	return found;
+}
+
+struct output {
+	char *buf;
+	size_t len;
+	size_t cap;
+	int error;
+};
+
+static void out_char(struct output *out, char c)
+{
+	if (out->error)
+		return;
+
+	if (out->len == out->cap) {
+		size_t cap = out->cap ? out->cap * 2 : 256;
+		char *buf;
+
+		if (cap > BINLOG_MAX_OUTPUT || !(buf = realloc(out->buf, cap))) {
+			out->error = 1;
+			return;
+		}
+		out->buf = buf;
+		out->cap = cap;
+	}
+
+	out->buf[out->len++] = c;
+}
+
+struct arg_reader {
+	const uint8_t *data;
+	size_t size;
+	size_t pos;
+	int error;
+};
+
+static uint64_t arg_get(struct arg_reader *args, size_t size)
+{
+	uint64_t val = 0;
+	size_t i;
+
+	if (size > args->size - args->pos) {
+		args->error = 1;
+		return 0;
+	}
+
+	for (i = 0; i < size; i++)
+		val |= (uint64_t)args->data[args->pos + i] << (8 * i);
+	args->pos += size;
+
+	return val;
+}
+
+static const char *arg_string(struct arg_reader *args, size_t *len)
+{
+	const char *s = (const char *)args->data + args->pos;
+	const char *end = memchr(s, '\0', args->size - args->pos);
+
+	if (!end) {
+		args->error = 1;
+		*len = 0;
+		return "";
+	}
+
+	*len = end - s;
+	args->pos += *len + 1;
+
+	return s;
+}
+
+#define is_digit(c)	((c) >= '0' && (c) <= '9')
+
+#define ZEROPAD	1		/* pad with zero */
+#define SIGN	2		/* unsigned/signed long */
+#define PLUS	4		/* show plus */
+#define SPACE	8		/* space if plus */
+#define LEFT	16		/* left justified */
+#define SPECIAL	32		/* 0x */
+#define LARGE	64		/* use 'ABCDEF' instead of 'abcdef' */
+
+static int skip_atoi(const char **s)
+{
+	int i = 0;
+
+	while (is_digit(**s))
+		i = i * 10 + *((*s)++) - '0';
+	return i;
+}
+
+static void number(struct output *out, unsigned long long num, int base,
+		   int size, int precision, int type)
+{
+	char c, sign, tmp[66];
+	const char *digits = "0123456789abcdefghijklmnopqrstuvwxyz";
+	int i;
+
+	if (type & LARGE)
+		digits = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	if (type & LEFT)
+		type &= ~ZEROPAD;
+	c = (type & ZEROPAD) ? '0' : ' ';
+	sign = 0;
+	if (type & SIGN) {
+		if ((signed long long)num < 0) {
+			sign = '-';
+			num = -num;
+			size--;
+		} else if (type & PLUS) {
+			sign = '+';
+			size--;
+		} else if (type & SPACE) {
+			sign = ' ';
+			size--;
+		}
+	}
+	if (type & SPECIAL) {
+		if (base == 16)
+			size -= 2;
+		else if (base == 8)
+			size--;
+	}
+	i = 0;
+	if (num == 0)
+		tmp[i++] = '0';
+	else while (num != 0) {
+		tmp[i++] = digits[num % base];
+		num /= base;
+	}
+	if (i > precision)
+		precision = i;
+	size -= precision;
+	if (!(type & (ZEROPAD + LEFT)))
+		while (size-- > 0 && !out->error)
+			out_char(out, ' ');
+	if (sign)
+		out_char(out, sign);
+	if (type & SPECIAL) {
+		if (base == 8) {
+			out_char(out, '0');
+		} else if (base == 16) {
+			out_char(out, '0');
+			out_char(out, digits[33]);
+		}
+	}
+	if (!(type & LEFT))
+		while (size-- > 0 && !out->error)
+			out_char(out, c);
+	while (i < precision-- && !out->error)
+		out_char(out, '0');
+	while (i-- > 0)
+		out_char(out, tmp[i]);
+	while (size-- > 0 && !out->error)
+		out_char(out, ' ');
+}
+
+static void format(struct output *out, const char *fmt,
+		   struct arg_reader *args)
+{
+	unsigned long long num;
+	int i, base, len;
+	const char *s;
+	int flags;
+	int field_width;
+	int precision;
+	int qualifier;
+	size_t slen;
+
+	for (; *fmt && !out->error && !args->error; ++fmt) {
+		if (*fmt != '%') {
+			out_char(out, *fmt);
+			continue;
+		}
+
+		/* process flags */
+		flags = 0;
+repeat:
+		++fmt;		/* this also skips first '%' */
+		switch (*fmt) {
+		case '-': flags |= LEFT; goto repeat;
+		case '+': flags |= PLUS; goto repeat;
+		case ' ': flags |= SPACE; goto repeat;
+		case '#': flags |= SPECIAL; goto repeat;
+		case '0': flags |= ZEROPAD; goto repeat;
+		}
+
+		/* get field width */
+		field_width = -1;
+		if (is_digit(*fmt)) {
+			field_width = skip_atoi(&fmt);
+		} else if (*fmt == '*') {
+			++fmt;
+			field_width = (int32_t)arg_get(args, 4);
+			if (field_width < 0) {
+				field_width = -field_width;
+				flags |= LEFT;
+			}
+		}
+
+		/* get the precision */
+		precision = -1;
+		if (*fmt == '.') {
+			++fmt;
+			if (is_digit(*fmt))
+				precision = skip_atoi(&fmt);
+			else if (*fmt == '*') {
+				++fmt;
+				precision = (int32_t)arg_get(args, 4);
+			}
+			if (precision < 0)
+				precision = 0;
+		}
+
+		/* get the conversion qualifier */
+		qualifier = -1;
+		if (*fmt == 'h' || *fmt == 'l' || *fmt == 'L' || *fmt == 'z') {
+			qualifier = *fmt;
+			++fmt;
+			if (*fmt == 'l') {
+				qualifier = 'L';
+				++fmt;
+			}
+			if (*fmt == 'h') {
+				qualifier = 'H';
+				++fmt;
+			}
+		}
+
+		/* default base */
+		base = 10;
+
+		switch (*fmt) {
+		case 'c':
+			if (!(flags & LEFT))
+				while (--field_width > 0 && !out->error)
+					out_char(out, ' ');
+			out_char(out, (char)arg_get(args, 1));
+			while (--field_width > 0 && !out->error)
+				out_char(out, ' ');
+			continue;
+
+		case 's':
+			/* Already cut down to the precision by the firmware. */
+			s = arg_string(args, &slen);
+			len = slen;
+
+			if (!(flags & LEFT))
+				while (len < field_width-- && !out->error)
+					out_char(out, ' ');
+			for (i = 0; i < len; ++i)
+				out_char(out, *s++);
+			while (len < field_width-- && !out->error)
+				out_char(out, ' ');
+			continue;
+
+		case 'p':
+			if (field_width == -1) {
+				field_width = 2 * arg_get(args, 1);
+				flags |= ZEROPAD;
+			} else {
+				arg_get(args, 1);
+			}
+			number(out, arg_get(args, 8), 16, field_width,
+			       precision, flags);
+			continue;
+
+		case 'n':
+			/* Never stored in binary form. */
+			args->error = 1;
+			continue;
+
+		case '%':
+			out_char(out, '%');
+			continue;
+
+		/* integer number formats - set up the flags and "break" */
+		case 'o':
+			base = 8;
+			break;
+
+		case 'X':
+			flags |= LARGE;
+			/* fall through */
+		case 'x':
+			base = 16;
+			break;
+
+		case 'd':
+		case 'i':
+			flags |= SIGN;
+			/* fall through */
+		case 'u':
+			break;
+
+		default:
+			out_char(out, '%');
+			if (*fmt)
+				out_char(out, *fmt);
+			else
+				--fmt;
+			continue;
+		}
+		if (qualifier == 'L' || qualifier == 'l' || qualifier == 'z') {
+			num = arg_get(args, 8);
+		} else if (qualifier == 'h') {
+			num = (unsigned short)arg_get(args, 4);
+			if (flags & SIGN)
+				num = (short)num;
+		} else if (qualifier == 'H') {
+			num = (unsigned char)arg_get(args, 4);
+			if (flags & SIGN)
+				num = (signed char)num;
+		} else if (flags & SIGN) {
+			num = (int32_t)arg_get(args, 4);
+		} else {
+			num = (uint32_t)arg_get(args, 4);
+		}
+		number(out, num, base, field_width, precision, flags);
+	}
+}
+
+/*
+ * Check and format the record at the start of data. Returns its length, or
+ * 0 if there is no valid record.
+ */
+static size_t decode_record(const uint8_t *data, size_t size,
+			    struct output *out)
+{
+	static const char *const names[] = { CONSOLE_BINLOG_STAGE_NAMES };
+	struct console_binlog_record rec;
+	const struct stage_strings *stage;
+	struct arg_reader args;
+	const char *fmt;
+	char buf[96];
+	int stage_id;
+	int i;
+
+	if (size < sizeof(rec))
+		return 0;
+
+	memcpy(&rec, data, sizeof(rec));
+	stage_id = rec.stage_level >> 4;
+
+	if (rec.marker != CONSOLE_BINLOG_MARKER ||
+	    stage_id < CONSOLE_BINLOG_BOOTBLOCK ||
+	    stage_id >= CONSOLE_BINLOG_NUM_STAGES ||
+	    (rec.stage_level & 0xf) > 8 ||
+	    rec.args_size > CONSOLE_BINLOG_MAX_ARGS ||
+	    rec.args_size > size - sizeof(rec))
+		return 0;
+
+	stage = &stages[stage_id];
+
+	if (!stage->image) {
+		/* Can't be checked any further. */
+		snprintf(buf, sizeof(buf), "[%s printk at +0x%x%s]\n",
+			 names[stage_id], rec.fmt_offset, have_strings ? "" :
+			 ", pass --strings to decode");
+		for (i = 0; buf[i]; i++)
+			out_char(out, buf[i]);
+		return sizeof(rec) + rec.args_size;
+	}
+
+	if (rec.fmt_offset >= stage->size)
+		return 0;
+
+	fmt = (const char *)stage->image + rec.fmt_offset;
+	if (!memchr(fmt, '\0', stage->size - rec.fmt_offset))
+		return 0;
+
+	args.data = data + sizeof(rec);
+	args.size = rec.args_size;
+	args.pos = 0;
+	args.error = 0;
+
+	format(out, fmt, &args);
+
+	/* The format has to use up exactly the stored arguments. */
+	if (out->error || args.error || args.pos != args.size)
+		return 0;
+
+	return sizeof(rec) + rec.args_size;
+}
+
+void binlog_print(const char *data, size_t size, int resync)
+{
+	const uint8_t *p = (const uint8_t *)data;
+	struct output out;
+	size_t i = 0;
+
+	memset(&out, 0, sizeof(out));
+
+	while (i < size) {
+		size_t len = 0;
+
+		out.len = 0;
+		out.error = 0;
+
+		if (p[i] == CONSOLE_BINLOG_MARKER)
+			len = decode_record(p + i, size - i, &out);
+
+		/*
+		 * Skip the partially overwritten line or record. Only a
+		 * record whose format matches its arguments ends that.
+		 */
+		if (resync) {
+			if (len && stages[p[i + 1] >> 4].image) {
+				resync = 0;
+			} else {
+				resync = p[i++] != '\n';
+				continue;
+			}
+		}
+
+		if (p[i] != CONSOLE_BINLOG_MARKER) {
+			putchar(p[i++]);
+			continue;
+		}
+
+		/* Not a record, e.g. a truncated one at the end. */
+		if (!len)
+			len = 1;
+		else
+			fwrite(out.buf, 1, out.len, stdout);
+		i += len;
+	}
+
+	free(out.buf);
+}
@@ -0,0 +1,32 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef CBMEM_BINLOG_H
+#define CBMEM_BINLOG_H
+
+#include <stddef.h>
+
+/*
+ * Load the format strings of all stages from <dir>/<stage>.debug. Returns
+ * the number of stages found.
+ */
+int binlog_load_strings(const char *dir);
+
+/*
+ * Print console data that may contain binary printk records. With resync
+ * set the data starts at an arbitrary point, so everything up to the first
+ * line or record boundary is skipped.
+ */
+void binlog_print(const char *data, size_t size, int resync);
+
+#endif /* CBMEM_BINLOG_H */
@@ -30,10 +30,18 @@
 #include <sys/stat.h>
 #include <sys/mman.h>
 #include <libgen.h>
+#include <limits.h>
 #include <assert.h>
+#include <commonlib/cbmem_console_serialized.h>
 #include <commonlib/cbmem_id.h>
+#include <commonlib/console_binlog_serialized.h>
+#include <commonlib/console_profile_serialized.h>
+#include <commonlib/device_timing_serialized.h>
+#include <commonlib/sampling_profile_serialized.h>
 #include <commonlib/timestamp_serialized.h>
 #include <commonlib/coreboot_tables.h>
+#include "binlog.h"
+#include "symbolize.h"
 
 #ifdef __OpenBSD__
 #include <sys/param.h>
@@ -459,10 +467,42 @@ static void print_norm(u64 v)
 	}
 }
 
+static int timestamp_is_span(uint32_t id)
+{
+	return !!(id & (TS_SPAN_BEGIN | TS_SPAN_END));
+}
+
+static uint32_t timestamp_base_id(uint32_t id)
+{
+	if (timestamp_is_span(id))
+		return id & TS_SPAN_ID_MASK;
+	return id;
+}
+
+static unsigned int timestamp_span_cpu(uint32_t id)
+{
+	return (id >> TS_SPAN_CPU_SHIFT) & TS_SPAN_CPU_MASK;
+}
+
+static unsigned int timestamp_span_thread(uint32_t id)
+{
+	return (id >> TS_SPAN_THREAD_SHIFT) & TS_SPAN_THREAD_MASK;
+}
+
 static const char *timestamp_name(uint32_t id)
 {
+	static char buf[64];
 	int i;
 
+	id = timestamp_base_id(id);
+
+	if (id > TS_CLEAR_DRAM_CPU_DONE &&
+	    id < TS_CLEAR_DRAM_CPU_DONE + TS_CLEAR_DRAM_NUM_CPUS) {
+		snprintf(buf, sizeof(buf), "CPU %u done clearing DRAM",
+			 id - TS_CLEAR_DRAM_CPU_DONE);
+		return buf;
+	}
+
 	for (i = 0; i < ARRAY_SIZE(timestamp_ids); i++) {
 		if (timestamp_ids[i].id == id)
 			return timestamp_ids[i].name;
@@ -470,18 +510,41 @@ static const char *timestamp_name(uint32_t id)
 	return "<unknown>";
 }
 
+/* Name of the entry, plus where and which end of a span it is. */
+static const char *timestamp_description(uint32_t id)
+{
+	static char buf[128];
+
+	if (!timestamp_is_span(id))
+		return timestamp_name(id);
+
+	snprintf(buf, sizeof(buf), "%s %s (CPU %u, thread %u)",
+		 timestamp_name(id), id & TS_SPAN_BEGIN ? "begin" : "end",
+		 timestamp_span_cpu(id), timestamp_span_thread(id));
+
+	return buf;
+}
+
+/* Entries of different CPUs may be slightly out of order. */
+static uint64_t timestamp_step(uint64_t stamp, uint64_t prev_stamp)
+{
+	if (stamp < prev_stamp)
+		return 0;
+	return arch_convert_raw_ts_entry(stamp - prev_stamp);
+}
+
 static uint64_t timestamp_print_parseable_entry(uint32_t id, uint64_t stamp,
 						uint64_t prev_stamp)
 {
 	const char *name;
 	uint64_t step_time;
 
-	name = timestamp_name(id);
+	name = timestamp_description(id);
 
-	step_time = arch_convert_raw_ts_entry(stamp - prev_stamp);
+	step_time = timestamp_step(stamp, prev_stamp);
 
 	/* ID<tab>absolute time<tab>relative time<tab>description */
-	printf("%d\t", id);
+	printf("%d\t", timestamp_base_id(id));
 	printf("%llu\t", (long long)arch_convert_raw_ts_entry(stamp));
 	printf("%llu\t", (long long)step_time);
 	printf("%s\n", name);
@@ -494,12 +557,12 @@ uint64_t timestamp_print_entry(uint32_t id, uint64_t stamp, uint64_t prev_stamp)
 	const char *name;
 	uint64_t step_time;
 
-	name = timestamp_name(id);
+	name = timestamp_description(id);
 
-	printf("%4d:", id);
+	printf("%4d:", timestamp_base_id(id));
 	printf("%-50s", name);
 	print_norm(arch_convert_raw_ts_entry(stamp));
-	step_time = arch_convert_raw_ts_entry(stamp - prev_stamp);
+	step_time = timestamp_step(stamp, prev_stamp);
 	if (prev_stamp) {
 		printf(" (");
 		print_norm(step_time);
@@ -571,13 +634,370 @@ static void dump_timestamps(int mach_readable)
 	unmap_memory();
 }
 
+/* Read a copy of the whole timestamp table, NULL if there is none. */
+static struct timestamp_table *read_timestamp_table(void)
+{
+	struct timestamp_table *tst_p;
+	struct timestamp_table *tst;
+	size_t size;
+
+	if (timestamps.tag != LB_TAG_TIMESTAMPS) {
+		fprintf(stderr, "No timestamps found in coreboot table.\n");
+		return NULL;
+	}
+
+	size = sizeof(*tst_p);
+	tst_p = map_memory_size((unsigned long)timestamps.cbmem_addr, size, 1);
+
+	timestamp_set_tick_freq(tst_p->tick_freq_mhz);
+
+	size += tst_p->num_entries * sizeof(tst_p->entries[0]);
+
+	unmap_memory();
+	tst_p = map_memory_size((unsigned long)timestamps.cbmem_addr, size, 1);
+
+	tst = malloc(size);
+	if (!tst) {
+		fprintf(stderr, "Not enough memory for timestamps.\n");
+		exit(1);
+	}
+	memcpy(tst, tst_p, size);
+
+	unmap_memory();
+
+	return tst;
+}
+
+static void print_json_string(const char *s)
+{
+	putchar('"');
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			printf("\\%c", *s);
+		else if ((unsigned char)*s < 0x20)
+			printf("\\u%04x", *s);
+		else
+			putchar(*s);
+	}
+	putchar('"');
+}
+
+#define TS_SPAN_NUM_THREADS	(TS_SPAN_THREAD_MASK + 1)
+#define TS_SPAN_NUM_TIDS	((TS_SPAN_CPU_MASK + 1) * TS_SPAN_NUM_THREADS)
+
+static unsigned int timestamp_span_tid(uint32_t id)
+{
+	return timestamp_span_cpu(id) * TS_SPAN_NUM_THREADS +
+		timestamp_span_thread(id);
+}
+
+/*
+ * Print the timestamps in the Trace Event Format understood by
+ * chrome://tracing and Perfetto. Every CPU and thread gets a track of its
+ * own, plain timestamps show up as instant events.
+ */
+static void dump_trace_json(void)
+{
+	static uint8_t tid_seen[TS_SPAN_NUM_TIDS];
+	struct timestamp_table *tst;
+	const char *sep = "";
+	unsigned int tid;
+	int i;
+
+	tst = read_timestamp_table();
+	if (!tst)
+		return;
+
+	printf("{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+
+	for (i = 0; i < tst->num_entries; i++) {
+		const struct timestamp_entry *tse = &tst->entries[i];
+		double ts = (double)tse->entry_stamp / tick_freq_mhz;
+
+		printf("%s{\"name\": ", sep);
+		print_json_string(timestamp_name(tse->entry_id));
+
+		if (timestamp_is_span(tse->entry_id)) {
+			tid = timestamp_span_tid(tse->entry_id);
+			tid_seen[tid] = 1;
+			printf(", \"ph\": \"%c\", \"pid\": 0, \"tid\": %u",
+			       tse->entry_id & TS_SPAN_BEGIN ? 'B' : 'E', tid);
+		} else {
+			printf(", \"ph\": \"i\", \"s\": \"p\", \"pid\": 0, "
+			       "\"tid\": 0");
+		}
+
+		printf(", \"ts\": %.3f, \"args\": {\"id\": %u}}", ts,
+		       timestamp_base_id(tse->entry_id));
+		sep = ",\n";
+	}
+
+	tid_seen[0] = 1;
+	for (tid = 0; tid < TS_SPAN_NUM_TIDS; tid++) {
+		if (!tid_seen[tid])
+			continue;
+		printf("%s{\"name\": \"thread_name\", \"ph\": \"M\", "
+		       "\"pid\": 0, \"tid\": %u, \"args\": {\"name\": "
+		       "\"CPU %u thread %u\"}}", sep, tid,
+		       tid / TS_SPAN_NUM_THREADS, tid % TS_SPAN_NUM_THREADS);
+		sep = ",\n";
+	}
+
+	printf("\n]}\n");
+
+	free(tst);
+}
+
+struct ts_span {
+	uint32_t id;
+	unsigned int tid;
+	int depth;
+	int open;
+	/* Microseconds since the base time. */
+	uint64_t start;
+	uint64_t end;
+};
+
+/* Pair up the begin and end entries. Spans left open end with the table. */
+static struct ts_span *timestamp_spans(const struct timestamp_table *tst,
+				       int *num_spans)
+{
+	static int depth[TS_SPAN_NUM_TIDS];
+	struct ts_span *spans;
+	uint64_t last = 0;
+	int num = 0;
+	int i, j;
+
+	spans = calloc(tst->num_entries + 1, sizeof(*spans));
+	if (!spans) {
+		fprintf(stderr, "Not enough memory for timestamp spans.\n");
+		exit(1);
+	}
+
+	for (i = 0; i < tst->num_entries; i++) {
+		const struct timestamp_entry *tse = &tst->entries[i];
+		uint32_t id = tse->entry_id;
+		uint64_t us = arch_convert_raw_ts_entry(tse->entry_stamp);
+		unsigned int tid;
+
+		if (us > last)
+			last = us;
+
+		if (!timestamp_is_span(id))
+			continue;
+
+		tid = timestamp_span_tid(id);
+
+		if (id & TS_SPAN_BEGIN) {
+			spans[num].id = timestamp_base_id(id);
+			spans[num].tid = tid;
+			spans[num].depth = depth[tid]++;
+			spans[num].open = 1;
+			spans[num].start = us;
+			num++;
+			continue;
+		}
+
+		/* Close the innermost matching span of this thread. */
+		for (j = num - 1; j >= 0; j--) {
+			if (spans[j].open && spans[j].tid == tid &&
+			    spans[j].id == timestamp_base_id(id)) {
+				spans[j].open = 0;
+				spans[j].end = us;
+				depth[tid] = spans[j].depth;
+				break;
+			}
+		}
+	}
+
+	for (i = 0; i < num; i++) {
+		if (spans[i].open)
+			spans[i].end = last;
+		if (spans[i].end < spans[i].start)
+			spans[i].end = spans[i].start;
+	}
+
+	*num_spans = num;
+	return spans;
+}
+
+static int ts_span_is_boot_state(const struct ts_span *s)
+{
+	return s->id >= TS_SPAN_BOOT_STATE &&
+		s->id < TS_SPAN_BOOT_STATE + 12;
+}
+
+static int ts_span_is_wait(const struct ts_span *s)
+{
+	return s->id == TS_SPAN_BS_BLOCKED || s->id == TS_SPAN_DEV_INIT_WAIT;
+}
+
+static uint64_t ts_span_overlap(const struct ts_span *a,
+				const struct ts_span *b)
+{
+	uint64_t start = a->start > b->start ? a->start : b->start;
+	uint64_t end = a->end < b->end ? a->end : b->end;
+
+	return end > start ? end - start : 0;
+}
+
+static const char *tid_name(unsigned int tid)
+{
+	static char buf[32];
+
+	snprintf(buf, sizeof(buf), "CPU %u thread %u",
+		 tid / TS_SPAN_NUM_THREADS, tid % TS_SPAN_NUM_THREADS);
+
+	return buf;
+}
+
+#define MAX_BLAME 8
+
+/*
+ * For every boot state, print how long it took and how much of that it spent
+ * waiting for other threads or CPUs. A wait is blamed on the span of another
+ * thread that was the last one to finish while it lasted.
+ */
+static void dump_critical_path(void)
+{
+	struct timestamp_table *tst;
+	struct ts_span *spans;
+	uint64_t total = 0, total_waiting = 0;
+	int num_spans;
+	int i, j, k;
+
+	tst = read_timestamp_table();
+	if (!tst)
+		return;
+
+	spans = timestamp_spans(tst, &num_spans);
+	if (!num_spans) {
+		fprintf(stderr, "No timestamp spans found. Build coreboot "
+			"with CONFIG_TIMESTAMP_SPANS.\n");
+		goto out;
+	}
+
+	printf("%-22s %12s %12s   %s\n", "boot state", "time (us)",
+	       "waiting (us)", "waiting on");
+
+	for (i = 0; i < num_spans; i++) {
+		const struct ts_span *bs = &spans[i];
+		struct {
+			const struct ts_span *span;
+			uint64_t time;
+		} blame[MAX_BLAME];
+		int num_blame = 0;
+		uint64_t waiting = 0;
+
+		if (!ts_span_is_boot_state(bs))
+			continue;
+
+		for (j = 0; j < num_spans; j++) {
+			const struct ts_span *w = &spans[j];
+			const struct ts_span *culprit = NULL;
+			uint64_t culprit_end = 0;
+
+			if (w->tid != bs->tid || w->depth <= bs->depth ||
+			    !ts_span_is_wait(w) || w->start < bs->start ||
+			    w->end > bs->end)
+				continue;
+
+			waiting += w->end - w->start;
+
+			for (k = 0; k < num_spans; k++) {
+				const struct ts_span *r = &spans[k];
+				uint64_t end;
+
+				if (r->tid == bs->tid || ts_span_is_wait(r) ||
+				    !ts_span_overlap(r, w))
+					continue;
+
+				end = r->end < w->end ? r->end : w->end;
+				if (!culprit || end > culprit_end ||
+				    (end == culprit_end &&
+				     r->depth < culprit->depth)) {
+					culprit = r;
+					culprit_end = end;
+				}
+			}
+
+			if (!culprit)
+				continue;
+
+			for (k = 0; k < num_blame; k++) {
+				if (blame[k].span->tid == culprit->tid &&
+				    blame[k].span->id == culprit->id)
+					break;
+			}
+			if (k == num_blame) {
+				if (num_blame == MAX_BLAME)
+					continue;
+				blame[num_blame].span = culprit;
+				blame[num_blame].time = 0;
+				num_blame++;
+			}
+			blame[k].time += ts_span_overlap(culprit, w);
+		}
+
+		printf("%-22s %12llu %12llu", timestamp_name(bs->id),
+		       (unsigned long long)(bs->end - bs->start),
+		       (unsigned long long)waiting);
+		for (k = 0; k < num_blame; k++) {
+			printf(k ? "\n%48s" : "   ", "");
+			printf("%s on %s: %llu us",
+			       timestamp_name(blame[k].span->id),
+			       tid_name(blame[k].span->tid),
+			       (unsigned long long)blame[k].time);
+		}
+		printf("%s\n", bs->open ? " (not finished)" : "");
+
+		total += bs->end - bs->start;
+		total_waiting += waiting;
+	}
+
+	printf("%-22s %12llu %12llu\n", "total",
+	       (unsigned long long)total, (unsigned long long)total_waiting);
+
+	/* Show how much ran next to the boot state machine. */
+	printf("\n%-32s %12s\n", "other threads", "busy (us)");
+	for (i = 0; i < num_spans; i++) {
+		uint64_t busy = 0;
+
+		if (spans[i].depth != 0 || ts_span_is_boot_state(&spans[i]))
+			continue;
+
+		/* Only report each thread once. */
+		for (j = 0; j < i; j++) {
+			if (spans[j].depth == 0 && spans[j].tid == spans[i].tid &&
+			    !ts_span_is_boot_state(&spans[j]))
+				break;
+		}
+		if (j < i)
+			continue;
+
+		for (j = i; j < num_spans; j++) {
+			if (spans[j].depth == 0 && spans[j].tid == spans[i].tid)
+				busy += spans[j].end - spans[j].start;
+		}
+
+		printf("  %-30s %12llu\n", tid_name(spans[i].tid),
+		       (unsigned long long)busy);
+	}
+
+out:
+	free(spans);
+	free(tst);
+}
+
 /* dump the cbmem console */
 static void dump_console(void)
 {
 	void *console_p;
 	char *console_c;
+	const char *start;
 	uint32_t size;
 	uint32_t cursor;
+	int wrapped;
 
 	if (console.tag != LB_TAG_CBMEM_CONSOLE) {
 		fprintf(stderr, "No console found in coreboot table.\n");
@@ -594,10 +1014,19 @@ static void dump_console(void)
 	 */
 	size = ((uint32_t *)console_p)[0];
 	cursor = ((uint32_t *)console_p)[1];
+	/* In ring buffer mode the oldest data starts at the cursor once the
+	 * buffer has wrapped around.
+	 */
+	wrapped = !!(cursor & CBMEM_CONSOLE_OVERFLOW);
+	if (wrapped) {
+		cursor &= CBMEM_CONSOLE_CURSOR_MASK;
+		if (cursor > size)
+			cursor = size;
+	}
 	/* Cursor continues to go on even after no more data fits in
 	 * the buffer but the data is dropped in this case.
 	 */
-	if (size > cursor)
+	if (!wrapped && size > cursor)
 		size = cursor;
 	console_c = calloc(1, size + 1);
 	unmap_memory();
@@ -608,10 +1037,32 @@ static void dump_console(void)
 
 	console_p = map_memory_size((unsigned long)console.cbmem_addr,
 	                            size + sizeof(size) + sizeof(cursor), 1);
-	memcpy(console_c, console_p + 8, size);
+	if (wrapped) {
+		memcpy(console_c, console_p + 8 + cursor, size - cursor);
+		memcpy(console_c + size - cursor, console_p + 8, cursor);
+	} else {
+		memcpy(console_c, console_p + 8, size);
+	}
 
-	printf("%s\n", console_c);
-	if (size < cursor)
+	start = console_c;
+
+	/* Binary printk records start with a NUL byte. */
+	if (memchr(console_c, CONSOLE_BINLOG_MARKER, size)) {
+		if (wrapped)
+			printf("*** Log wrapped, oldest output lost. ***\n");
+		binlog_print(console_c, size, wrapped);
+		start = "";
+	} else if (wrapped) {
+		/* The oldest line got partially overwritten, skip it. */
+		char *eol = strchr(console_c, '\n');
+
+		if (eol)
+			start = eol + 1;
+		printf("*** Log wrapped, oldest output lost. ***\n");
+	}
+
+	printf("%s\n", start);
+	if (!wrapped && size < cursor)
 		printf("%d %s lost\n", cursor - size,
 			(cursor - size) == 1 ? "byte":"bytes");
 
@@ -872,6 +1323,331 @@ static void dump_coverage(void)
 	unmap_memory();
 }
 
+static void print_profile_counter(const char *name,
+				  const struct console_profile_counter *c,
+				  uint64_t tick_freq_mhz)
+{
+	uint64_t us = c->ticks / tick_freq_mhz;
+
+	printf("%-16s %10u %12u %14" PRIu64, name, c->calls, c->bytes, us);
+	if (c->bytes)
+		printf(" %12" PRIu64, c->ticks * 1000 / tick_freq_mhz /
+		       c->bytes);
+	else
+		printf(" %12s", "-");
+	/* Bytes per microsecond are MB/s. */
+	if (us)
+		printf(" %10.3f", (double)c->bytes / us);
+	else
+		printf(" %10s", "-");
+	printf("\n");
+}
+
+static void dump_console_profile(void)
+{
+	static const char *const level_names[CONSOLE_PROFILE_NUM_LEVELS] = {
+		"EMERG", "ALERT", "CRIT", "ERR", "WARNING", "NOTICE", "INFO",
+		"DEBUG", "SPEW",
+	};
+	static const char *const driver_names[CONSOLE_PROFILE_NUM_DRIVERS] = {
+		CONSOLE_PROFILE_DRIVER_NAMES
+	};
+	const struct console_profile *profile;
+	uint64_t tick_freq_mhz;
+	uint64_t start;
+	size_t size;
+	int num_levels, num_drivers;
+	int i;
+
+	if (find_cbmem_entry(CBMEM_ID_CONSOLE_PROFILE, &start, &size)) {
+		fprintf(stderr, "No console profile found\n");
+		return;
+	}
+
+	if (size < sizeof(*profile)) {
+		fprintf(stderr, "Console profile is truncated\n");
+		return;
+	}
+
+	profile = map_memory_size(start, size, 1);
+
+	tick_freq_mhz = profile->tick_freq_mhz;
+	if (!tick_freq_mhz) {
+		fprintf(stderr, "Console profile has no tick frequency\n");
+		unmap_memory();
+		return;
+	}
+
+	/* Only show what both this tool and the firmware know about. */
+	num_levels = profile->num_levels;
+	if (num_levels > CONSOLE_PROFILE_NUM_LEVELS)
+		num_levels = CONSOLE_PROFILE_NUM_LEVELS;
+	num_drivers = profile->num_drivers;
+	if (num_drivers > CONSOLE_PROFILE_NUM_DRIVERS)
+		num_drivers = CONSOLE_PROFILE_NUM_DRIVERS;
+
+	printf("%-16s %10s %12s %14s %12s %10s\n", "level", "calls", "bytes",
+	       "time (us)", "ns/byte", "MB/s");
+	for (i = 0; i < num_levels; i++) {
+		if (profile->levels[i].calls)
+			print_profile_counter(level_names[i],
+					      &profile->levels[i],
+					      tick_freq_mhz);
+	}
+
+	printf("\n%-16s %10s %12s %14s %12s %10s\n", "driver", "calls",
+	       "bytes", "time (us)", "ns/byte", "MB/s");
+	for (i = 0; i < num_drivers; i++) {
+		if (profile->drivers[i].calls)
+			print_profile_counter(driver_names[i],
+					      &profile->drivers[i],
+					      tick_freq_mhz);
+	}
+
+	/* The times include reading the timestamps they are made of. */
+	if (profile->timestamp_cost)
+		printf("\nProfiling read %" PRIu64 " timestamps at %.1f ns "
+		       "each, which is about %" PRIu64 " us of the times "
+		       "above.\n", profile->timestamps,
+		       profile->timestamp_cost * 1000.0 / tick_freq_mhz /
+		       CONSOLE_PROFILE_COST_SAMPLES,
+		       profile->timestamps * profile->timestamp_cost /
+		       tick_freq_mhz / CONSOLE_PROFILE_COST_SAMPLES);
+
+	unmap_memory();
+}
+
+static const char *const device_timing_op_names[DEVICE_TIMING_NUM_OPS] = {
+	DEVICE_TIMING_OP_NAMES
+};
+
+/* Column the device timing report is sorted by, -1 for the total. */
+static int device_timing_sort_op = -1;
+
+struct device_timing_row {
+	const struct device_timing_entry *entry;
+	uint64_t total;
+};
+
+static int device_timing_parse_key(const char *key)
+{
+	int i;
+
+	if (!strcmp(key, "total"))
+		return -1;
+
+	for (i = 0; i < DEVICE_TIMING_NUM_OPS; i++) {
+		if (!strcmp(key, device_timing_op_names[i]))
+			return i;
+	}
+
+	return -2;
+}
+
+static uint64_t device_timing_key(const struct device_timing_row *row)
+{
+	if (device_timing_sort_op < 0)
+		return row->total;
+	return row->entry->ticks[device_timing_sort_op];
+}
+
+/* Columns are at least as wide as their name. */
+static int device_timing_width(int op)
+{
+	int len = strlen(device_timing_op_names[op]);
+
+	return len > 10 ? len : 10;
+}
+
+static int compare_device_timing(const void *a, const void *b)
+{
+	uint64_t ka = device_timing_key(a);
+	uint64_t kb = device_timing_key(b);
+
+	/* Slowest first. */
+	if (ka > kb)
+		return -1;
+	if (ka < kb)
+		return 1;
+	return 0;
+}
+
+static void dump_device_timing(int top)
+{
+	const struct device_timing_table *table;
+	struct device_timing_row *rows;
+	uint64_t tick_freq_mhz;
+	uint64_t start;
+	size_t size, max_entries, count;
+	int num_entries, num_ops;
+	int i, j;
+
+	if (find_cbmem_entry(CBMEM_ID_DEVICE_TIMING, &start, &size)) {
+		fprintf(stderr, "No device timing found\n");
+		return;
+	}
+
+	if (size < sizeof(*table)) {
+		fprintf(stderr, "Device timing table is truncated\n");
+		return;
+	}
+
+	table = map_memory_size(start, size, 1);
+
+	tick_freq_mhz = table->tick_freq_mhz;
+	if (!tick_freq_mhz) {
+		fprintf(stderr, "Device timing table has no tick frequency\n");
+		unmap_memory();
+		return;
+	}
+
+	/* Ops this tool doesn't know about would shift the entry layout. */
+	num_ops = table->num_ops;
+	if (num_ops != DEVICE_TIMING_NUM_OPS) {
+		fprintf(stderr, "Device timing table has %d ops, expected %d\n",
+			num_ops, DEVICE_TIMING_NUM_OPS);
+		unmap_memory();
+		return;
+	}
+
+	max_entries = (size - sizeof(*table)) / sizeof(table->entries[0]);
+	count = table->num_entries;
+	if (count > max_entries) {
+		fprintf(stderr, "Device timing table is truncated\n");
+		count = max_entries;
+	}
+
+	if (count == 0) {
+		printf("No device timings\n");
+		unmap_memory();
+		return;
+	}
+
+	if (count > INT_MAX || count > SIZE_MAX / sizeof(*rows)) {
+		fprintf(stderr, "Device timing table is too large\n");
+		unmap_memory();
+		return;
+	}
+	num_entries = count;
+
+	rows = malloc(num_entries * sizeof(*rows));
+	if (!rows) {
+		fprintf(stderr, "Out of memory\n");
+		unmap_memory();
+		return;
+	}
+
+	for (i = 0; i < num_entries; i++) {
+		rows[i].entry = &table->entries[i];
+		rows[i].total = 0;
+		for (j = 0; j < num_ops; j++)
+			rows[i].total += table->entries[i].ticks[j];
+	}
+
+	qsort(rows, num_entries, sizeof(*rows), compare_device_timing);
+
+	if (top <= 0 || top > num_entries)
+		top = num_entries;
+
+	/* All times are in microseconds. */
+	printf("%-*s %10s", DEVICE_TIMING_PATH_SIZE, "device", "total");
+	for (j = 0; j < num_ops; j++)
+		printf(" %*s", device_timing_width(j),
+		       device_timing_op_names[j]);
+	printf("\n");
+
+	for (i = 0; i < top; i++) {
+		const struct device_timing_entry *e = rows[i].entry;
+
+		printf("%-*.*s %10" PRIu64, DEVICE_TIMING_PATH_SIZE,
+		       DEVICE_TIMING_PATH_SIZE, e->path,
+		       rows[i].total / tick_freq_mhz);
+		for (j = 0; j < num_ops; j++)
+			printf(" %*" PRIu64, device_timing_width(j),
+			       e->ticks[j] / tick_freq_mhz);
+		printf("\n");
+	}
+
+	if (top < num_entries)
+		printf("(%d more devices not shown)\n", num_entries - top);
+
+	free(rows);
+	unmap_memory();
+}
+
+static void print_frame(uint32_t pc, int is_return)
+{
+	/* A return address may already be past the end of the caller. */
+	const char *name = symbolize(is_return ? pc - 1 : pc);
+
+	if (name)
+		printf("%s", name);
+	else
+		printf("0x%08x", pc);
+}
+
+/* Print the sampled stacks in the folded format of flamegraph.pl. */
+static void dump_sampling_profile(const char *stage_dir)
+{
+	const struct sampling_profile *profile;
+	uint64_t start;
+	size_t size;
+	uint32_t num_slots, i;
+	int j;
+
+	if (find_cbmem_entry(CBMEM_ID_SAMPLING_PROFILE, &start, &size)) {
+		fprintf(stderr, "No sampling profile found\n");
+		return;
+	}
+
+	if (size < sizeof(*profile)) {
+		fprintf(stderr, "Sampling profile is truncated\n");
+		return;
+	}
+
+	profile = map_memory_size(start, size, 1);
+
+	if (stage_dir) {
+		char path[4096];
+
+		snprintf(path, sizeof(path), "%s/ramstage.debug", stage_dir);
+		if (!symbolize_load(path, profile->load_base))
+			fprintf(stderr, "No symbols found in %s\n", path);
+	}
+
+	num_slots = profile->num_slots;
+	if (num_slots > (size - sizeof(*profile)) /
+			sizeof(profile->stacks[0])) {
+		fprintf(stderr, "Sampling profile is truncated\n");
+		num_slots = (size - sizeof(*profile)) /
+			sizeof(profile->stacks[0]);
+	}
+
+	/* Keep stdout for the stacks so it can go straight to flamegraph.pl */
+	fprintf(stderr, "%u samples at %u Hz, %u lost\n",
+		profile->num_samples, profile->rate_hz,
+		profile->lost_samples);
+
+	for (i = 0; i < num_slots; i++) {
+		const struct sampling_profile_stack *s = &profile->stacks[i];
+		int depth = s->depth;
+
+		if (!s->count || !depth)
+			continue;
+		if (depth > SAMPLING_PROFILE_MAX_DEPTH)
+			depth = SAMPLING_PROFILE_MAX_DEPTH;
+
+		/* Outermost frame first, the interrupted one last. */
+		for (j = depth - 1; j >= 0; j--) {
+			print_frame(s->pc[j], j > 0);
+			printf("%s", j ? ";" : "");
+		}
+		printf(" %u\n", s->count);
+	}
+
+	unmap_memory();
+}
+
 static void print_version(void)
 {
 	printf("cbmem v%s -- ", CBMEM_VERSION);
@@ -888,15 +1664,31 @@ static void print_version(void)
 
 static void print_usage(const char *name, int exit_code)
 {
-	printf("usage: %s [-cCltTxVvh?]\n", name);
+	printf("usage: %s [-cCltTjaPdFxVvh?] [-S dir] [-n count] [-k key]\n",
+	       name);
 	printf("\n"
 	     "   -c | --console:                   print cbmem console\n"
+	     "   -S | --strings DIR:               decode binary console records and\n"
+	     "                                     symbolize samples with the stage\n"
+	     "                                     ELFs in DIR\n"
 	     "   -C | --coverage:                  dump coverage information\n"
 	     "   -l | --list:                      print cbmem table of contents\n"
 	     "   -x | --hexdump:                   print hexdump of cbmem area\n"
 	     "   -r | --rawdump ID:                print rawdump of specific ID (in hex) of cbtable\n"
 	     "   -t | --timestamps:                print timestamp information\n"
 	     "   -T | --parseable-timestamps:      print parseable timestamps\n"
+	     "   -j | --trace-json:                print timestamps as Chrome trace JSON\n"
+	     "   -a | --critical-path:             print what each boot state waited on\n"
+	     "   -P | --printk-profile:            print time spent on console output\n"
+	     "   -d | --device-times:              print the slowest devices\n"
+	     "   -n | --top COUNT:                 number of devices to print (default\n"
+	     "                                     10, 0 for all)\n"
+	     "   -k | --sort-key KEY:              sort devices by 'total' or one of\n"
+	     "                                     scan_bus, read_resources,\n"
+	     "                                     set_resources, enable_resources,\n"
+	     "                                     init, final\n"
+	     "   -F | --flamegraph:                print sampled ramstage stacks for\n"
+	     "                                     flamegraph.pl\n"
 	     "   -V | --verbose:                   verbose (debugging) output\n"
 	     "   -v | --version:                   print the version\n"
 	     "   -h | --help:                      print this help\n"
@@ -1029,15 +1821,30 @@ int main(int argc, char** argv)
 	int print_rawdump = 0;
 	int print_timestamps = 0;
 	int machine_readable_timestamps = 0;
+	int print_trace_json = 0;
+	int print_critical_path = 0;
+	int print_console_profile = 0;
+	int print_device_timing = 0;
+	int device_timing_top = 10;
+	int print_sampling_profile = 0;
+	const char *stage_dir = NULL;
 	unsigned int rawdump_id = 0;
 
 	int opt, option_index = 0;
 	static struct option long_options[] = {
 		{"console", 0, 0, 'c'},
+		{"strings", required_argument, 0, 'S'},
 		{"coverage", 0, 0, 'C'},
 		{"list", 0, 0, 'l'},
 		{"timestamps", 0, 0, 't'},
 		{"parseable-timestamps", 0, 0, 'T'},
+		{"trace-json", 0, 0, 'j'},
+		{"critical-path", 0, 0, 'a'},
+		{"printk-profile", 0, 0, 'P'},
+		{"device-times", 0, 0, 'd'},
+		{"top", required_argument, 0, 'n'},
+		{"sort-key", required_argument, 0, 'k'},
+		{"flamegraph", 0, 0, 'F'},
 		{"hexdump", 0, 0, 'x'},
 		{"rawdump", required_argument, 0, 'r'},
 		{"verbose", 0, 0, 'V'},
@@ -1045,13 +1852,19 @@ int main(int argc, char** argv)
 		{"help", 0, 0, 'h'},
 		{0, 0, 0, 0}
 	};
-	while ((opt = getopt_long(argc, argv, "cCltTxVvh?r:",
+	while ((opt = getopt_long(argc, argv, "cCltTjaPdFxVvh?r:S:n:k:",
 				  long_options, &option_index)) != EOF) {
 		switch (opt) {
 		case 'c':
 			print_console = 1;
 			print_defaults = 0;
 			break;
+		case 'S':
+			stage_dir = optarg;
+			if (!binlog_load_strings(optarg))
+				fprintf(stderr, "No stage ELFs found in %s\n",
+					optarg);
+			break;
 		case 'C':
 			print_coverage = 1;
 			print_defaults = 0;
@@ -1078,6 +1891,36 @@ int main(int argc, char** argv)
 			machine_readable_timestamps = 1;
 			print_defaults = 0;
 			break;
+		case 'j':
+			print_trace_json = 1;
+			print_defaults = 0;
+			break;
+		case 'a':
+			print_critical_path = 1;
+			print_defaults = 0;
+			break;
+		case 'P':
+			print_console_profile = 1;
+			print_defaults = 0;
+			break;
+		case 'd':
+			print_device_timing = 1;
+			print_defaults = 0;
+			break;
+		case 'F':
+			print_sampling_profile = 1;
+			print_defaults = 0;
+			break;
+		case 'n':
+			device_timing_top = atoi(optarg);
+			break;
+		case 'k':
+			device_timing_sort_op = device_timing_parse_key(optarg);
+			if (device_timing_sort_op < -1) {
+				fprintf(stderr, "Unknown sort key %s\n", optarg);
+				print_usage(argv[0], 1);
+			}
+			break;
 		case 'V':
 			verbose = 1;
 			break;
@@ -1183,6 +2026,21 @@ int main(int argc, char** argv)
 	if (print_defaults || print_timestamps)
 		dump_timestamps(machine_readable_timestamps);
 
+	if (print_trace_json)
+		dump_trace_json();
+
+	if (print_critical_path)
+		dump_critical_path();
+
+	if (print_console_profile)
+		dump_console_profile();
+
+	if (print_device_timing)
+		dump_device_timing(device_timing_top);
+
+	if (print_sampling_profile)
+		dump_sampling_profile(stage_dir);
+
 	close(mem_fd);
 	return 0;
 }
@@ -0,0 +1,191 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <elf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stage_elf.h"
+
+int elf_open(const char *path, struct elf_file *elf)
+{
+	uint8_t *data;
+	long size;
+	FILE *f;
+
+	f = fopen(path, "rb");
+	if (!f)
+		return -1;
+
+	if (fseek(f, 0, SEEK_END) || (size = ftell(f)) < 0 ||
+	    fseek(f, 0, SEEK_SET)) {
+		fclose(f);
+		return -1;
+	}
+
+	data = malloc(size);
+	if (!data || fread(data, 1, size, f) != (size_t)size) {
+		free(data);
+		fclose(f);
+		return -1;
+	}
+	fclose(f);
+
+	elf->data = data;
+	elf->size = size;
+	elf->is64 = 0;
+
+	if (elf->size < EI_NIDENT || memcmp(data, ELFMAG, SELFMAG) ||
+	    data[EI_DATA] != ELFDATA2LSB)
+		goto fail;
+
+	if (data[EI_CLASS] == ELFCLASS64 && elf->size >= sizeof(Elf64_Ehdr))
+		elf->is64 = 1;
+	else if (data[EI_CLASS] != ELFCLASS32 ||
+		 elf->size < sizeof(Elf32_Ehdr))
+		goto fail;
+
+	return 0;
+
+fail:
+	fprintf(stderr, "%s: not a usable stage ELF\n", path);
+	elf_close(elf);
+	return -1;
+}
+
+void elf_close(struct elf_file *elf)
+{
+	free(elf->data);
+	elf->data = NULL;
+	elf->size = 0;
+}
+
+int elf_section(const struct elf_file *elf, unsigned int idx,
+		struct elf_section *s)
+{
+	uint64_t shoff;
+	size_t shentsize;
+	unsigned int shnum;
+
+	if (elf->is64) {
+		const Elf64_Ehdr *ehdr = (const void *)elf->data;
+
+		shoff = ehdr->e_shoff;
+		shentsize = ehdr->e_shentsize;
+		shnum = ehdr->e_shnum;
+	} else {
+		const Elf32_Ehdr *ehdr = (const void *)elf->data;
+
+		shoff = ehdr->e_shoff;
+		shentsize = ehdr->e_shentsize;
+		shnum = ehdr->e_shnum;
+	}
+
+	if (idx >= shnum || shoff > elf->size ||
+	    (uint64_t)(idx + 1) * shentsize > elf->size - shoff)
+		return -1;
+
+	if (elf->is64) {
+		const Elf64_Shdr *shdr;
+
+		if (shentsize < sizeof(*shdr))
+			return -1;
+		shdr = (const void *)(elf->data + shoff + idx * shentsize);
+		s->type = shdr->sh_type;
+		s->flags = shdr->sh_flags;
+		s->addr = shdr->sh_addr;
+		s->offset = shdr->sh_offset;
+		s->size = shdr->sh_size;
+		s->link = shdr->sh_link;
+		s->entsize = shdr->sh_entsize;
+	} else {
+		const Elf32_Shdr *shdr;
+
+		if (shentsize < sizeof(*shdr))
+			return -1;
+		shdr = (const void *)(elf->data + shoff + idx * shentsize);
+		s->type = shdr->sh_type;
+		s->flags = shdr->sh_flags;
+		s->addr = shdr->sh_addr;
+		s->offset = shdr->sh_offset;
+		s->size = shdr->sh_size;
+		s->link = shdr->sh_link;
+		s->entsize = shdr->sh_entsize;
+	}
+
+	if (s->type != SHT_NOBITS &&
+	    (s->offset > elf->size || s->size > elf->size - s->offset))
+		return -1;
+
+	return 0;
+}
+
+unsigned int elf_num_sections(const struct elf_file *elf)
+{
+	if (elf->is64)
+		return ((const Elf64_Ehdr *)elf->data)->e_shnum;
+	return ((const Elf32_Ehdr *)elf->data)->e_shnum;
+}
+
+int elf_for_each_symbol(const struct elf_file *elf,
+			int (*fn)(const struct elf_symbol *sym, void *arg),
+			void *arg)
+{
+	struct elf_section symtab, strtab;
+	size_t symsize = elf->is64 ? sizeof(Elf64_Sym) : sizeof(Elf32_Sym);
+	unsigned int i;
+	uint64_t off;
+	int ret = 0;
+
+	for (i = 0; i < elf_num_sections(elf); i++) {
+		if (!elf_section(elf, i, &symtab) && symtab.type == SHT_SYMTAB)
+			break;
+	}
+
+	if (i == elf_num_sections(elf) ||
+	    elf_section(elf, symtab.link, &strtab))
+		return -1;
+
+	for (off = 0; off + symsize <= symtab.size && !ret; off += symsize) {
+		const void *p = elf->data + symtab.offset + off;
+		struct elf_symbol sym;
+		uint64_t name;
+
+		if (elf->is64) {
+			const Elf64_Sym *s = p;
+
+			name = s->st_name;
+			sym.value = s->st_value;
+			sym.size = s->st_size;
+			sym.type = ELF64_ST_TYPE(s->st_info);
+		} else {
+			const Elf32_Sym *s = p;
+
+			name = s->st_name;
+			sym.value = s->st_value;
+			sym.size = s->st_size;
+			sym.type = ELF32_ST_TYPE(s->st_info);
+		}
+
+		if (!name || name >= strtab.size)
+			continue;
+		sym.name = (const char *)elf->data + strtab.offset + name;
+		if (!memchr(sym.name, '\0', strtab.size - name))
+			continue;
+
+		ret = fn(&sym, arg);
+	}
+
+	return ret;
+}
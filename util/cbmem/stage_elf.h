@@ -0,0 +1,62 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef CBMEM_STAGE_ELF_H
+#define CBMEM_STAGE_ELF_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Minimal reader for the <stage>.debug ELFs a coreboot build leaves. */
+
+struct elf_file {
+	uint8_t *data;
+	size_t size;
+	int is64;
+};
+
+struct elf_section {
+	uint32_t type;
+	uint64_t flags;
+	uint64_t addr;
+	uint64_t offset;
+	uint64_t size;
+	uint32_t link;
+	uint64_t entsize;
+};
+
+struct elf_symbol {
+	const char *name;
+	uint64_t value;
+	uint64_t size;
+	unsigned int type;
+};
+
+/* Read a little endian ELF32 or ELF64 file. Returns 0 on success. */
+int elf_open(const char *path, struct elf_file *elf);
+void elf_close(struct elf_file *elf);
+
+unsigned int elf_num_sections(const struct elf_file *elf);
+int elf_section(const struct elf_file *elf, unsigned int idx,
+		struct elf_section *s);
+
+/*
+ * Call fn for every named entry of the symbol table until it returns
+ * non-zero. Returns -1 without a symbol table, otherwise the last value
+ * returned by fn.
+ */
+int elf_for_each_symbol(const struct elf_file *elf,
+			int (*fn)(const struct elf_symbol *sym, void *arg),
+			void *arg);
+
+#endif /* CBMEM_STAGE_ELF_H */
@@ -0,0 +1,117 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <elf.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stage_elf.h"
+#include "symbolize.h"
+
+struct function {
+	uint64_t start;
+	uint64_t end;
+	char *name;
+};
+
+static struct function *functions;
+static size_t num_functions;
+static size_t max_functions;
+
+static int find_program(const struct elf_symbol *sym, void *arg)
+{
+	if (strcmp(sym->name, "_program"))
+		return 0;
+
+	*(uint64_t *)arg = sym->value;
+	return 1;
+}
+
+static int add_function(const struct elf_symbol *sym, void *arg)
+{
+	uint64_t bias = *(const uint64_t *)arg;
+	struct function *f;
+
+	if (sym->type != STT_FUNC || !sym->size)
+		return 0;
+
+	if (num_functions == max_functions) {
+		size_t n = max_functions ? max_functions * 2 : 1024;
+
+		f = realloc(functions, n * sizeof(*f));
+		if (!f)
+			return -1;
+		functions = f;
+		max_functions = n;
+	}
+
+	f = &functions[num_functions];
+	f->name = strdup(sym->name);
+	if (!f->name)
+		return -1;
+	f->start = sym->value + bias;
+	f->end = sym->value + sym->size + bias;
+	num_functions++;
+
+	return 0;
+}
+
+static int compare_functions(const void *a, const void *b)
+{
+	const struct function *fa = a, *fb = b;
+
+	if (fa->start < fb->start)
+		return -1;
+	return fa->start > fb->start;
+}
+
+int symbolize_load(const char *path, uint64_t load_base)
+{
+	struct elf_file elf;
+	uint64_t program;
+	uint64_t bias = 0;
+
+	if (elf_open(path, &elf))
+		return 0;
+
+	/* A relocated stage ran somewhere else than it was linked. */
+	if (load_base && elf_for_each_symbol(&elf, find_program, &program) > 0)
+		bias = load_base - program;
+
+	elf_for_each_symbol(&elf, add_function, &bias);
+	elf_close(&elf);
+
+	qsort(functions, num_functions, sizeof(*functions), compare_functions);
+
+	return num_functions;
+}
+
+const char *symbolize(uint64_t addr)
+{
+	size_t lo = 0, hi = num_functions;
+
+	/* Find the last function starting at or below addr. */
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (functions[mid].start <= addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo == 0 || addr >= functions[lo - 1].end)
+		return NULL;
+
+	return functions[lo - 1].name;
+}
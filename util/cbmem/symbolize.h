@@ -0,0 +1,29 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef CBMEM_SYMBOLIZE_H
+#define CBMEM_SYMBOLIZE_H
+
+#include <stdint.h>
+
+/*
+ * Load the function symbols of a stage ELF. If load_base isn't 0, the
+ * symbols are moved to where the stage ran with its _program symbol at
+ * load_base. Returns the number found.
+ */
+int symbolize_load(const char *path, uint64_t load_base);
+
+/* Name of the function containing addr, NULL if there is none. */
+const char *symbolize(uint64_t addr);
+
+#endif /* CBMEM_SYMBOLIZE_H */
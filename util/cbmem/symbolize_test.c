@@ -0,0 +1,62 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "symbolize.h"
+
+/*
+ * Symbolizes PCs of this program as if it was a stage relocated to
+ * LOAD_BASE, the way ramstage gets relocated into CBMEM. The distances
+ * between symbols are the same at runtime as in the ELF.
+ */
+#define LOAD_BASE	0x7ab40000
+
+char _program[16];
+
+__attribute__((noinline)) int profiled_function(int x)
+{
+	return x * 3 + 1;
+}
+
+int main(int argc, char **argv)
+{
+	uint64_t offset = (uintptr_t)profiled_function - (uintptr_t)_program;
+	uint64_t pc = LOAD_BASE + offset + 1;
+	const char *name;
+
+	if (!symbolize_load(argv[0], LOAD_BASE)) {
+		fprintf(stderr, "No symbols found in %s\n", argv[0]);
+		return 1;
+	}
+
+	name = symbolize(pc);
+	if (!name || strcmp(name, "profiled_function")) {
+		fprintf(stderr, "0x%llx: expected profiled_function, got %s\n",
+			(unsigned long long)pc, name ? name : "nothing");
+		return 1;
+	}
+
+	/* The unrelocated address is no longer in there. */
+	name = symbolize((uintptr_t)profiled_function + 1);
+	if ((uintptr_t)profiled_function != pc - 1 && name &&
+	    !strcmp(name, "profiled_function")) {
+		fprintf(stderr, "Unrelocated address still symbolized\n");
+		return 1;
+	}
+
+	printf("All checks passed.\n");
+	return profiled_function(0) != 1;
+}
@@ -0,0 +1,264 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <imd.h>
+
+/* Same root size as CBMEM, entry alignment of its small region. */
+#define ROOT_SIZE	4096
+#define ENTRY_ALIGN	32
+#define REGION_SIZE	(1024 * 1024)
+#define MAX_IDS		256
+
+int imd_bench_hash_index;
+
+static uint8_t *region;
+
+struct expected {
+	uint32_t id;
+	const struct imd_entry *e;
+};
+
+static struct expected expected[MAX_IDS];
+static int num_expected;
+
+static void *upper_limit(void)
+{
+	return region + REGION_SIZE;
+}
+
+static int create(struct imd *imd, int hash_index)
+{
+	imd_bench_hash_index = hash_index;
+	memset(region, 0, REGION_SIZE);
+	imd_handle_init(imd, upper_limit());
+	num_expected = 0;
+
+	return imd_create_empty(imd, ROOT_SIZE, ENTRY_ALIGN);
+}
+
+/* Few distinct low bits, like the ASCII tags most CBMEM ids are. */
+static uint32_t random_id(void)
+{
+	return 0x41414141 + (rand() % 26) * 0x01000000 +
+		(rand() % 26) * 0x00010000 + (rand() % 26) * 0x100;
+}
+
+static int find_expected(uint32_t id)
+{
+	int i;
+
+	for (i = 0; i < num_expected; i++) {
+		if (expected[i].id == id)
+			return i;
+	}
+
+	return -1;
+}
+
+static int check_all(const struct imd *imd, const char *what)
+{
+	int errors = 0;
+	int i;
+
+	for (i = 0; i < num_expected; i++) {
+		/* Lookups of a duplicate id find the first entry. */
+		int first = find_expected(expected[i].id);
+
+		if (imd_entry_find(imd, expected[i].id) != expected[first].e) {
+			fprintf(stderr, "%s: wrong entry for %08x\n", what,
+				expected[i].id);
+			errors++;
+		}
+	}
+
+	for (i = 0; i < 64; i++) {
+		uint32_t id = random_id() ^ 0x80808080;
+
+		if (imd_entry_find(imd, id) != NULL) {
+			fprintf(stderr, "%s: found missing %08x\n", what, id);
+			errors++;
+		}
+	}
+
+	return errors;
+}
+
+/*
+ * With mixed, the root is created with the index and every operation is
+ * done as by a stage built with or without it at random.
+ */
+static int check(int hash_index, int mixed)
+{
+	const char *what = mixed ? "mixed" : hash_index ? "index" : "linear";
+	struct imd imd;
+	int errors = 0;
+	int round;
+
+	if (create(&imd, hash_index)) {
+		fprintf(stderr, "%s: can't create imd\n", what);
+		return 1;
+	}
+
+	srand(1);
+	for (round = 0; round < 20000; round++) {
+		int op = rand() % 64;
+
+		if (mixed)
+			imd_bench_hash_index = rand() % 2;
+
+		/* Recover only now and then, it rebuilds the index. */
+		if (op < 36) {
+			uint32_t id = random_id();
+			const struct imd_entry *e;
+
+			/* Allow some duplicates, the imd doesn't check. */
+			if (rand() % 4 && num_expected)
+				id = expected[rand() % num_expected].id;
+
+			e = imd_entry_add(&imd, id, 1 + rand() % 64);
+			if (e == NULL) {
+				/* Full, remove everything again. */
+				while (num_expected) {
+					num_expected--;
+					imd_entry_remove(&imd,
+						expected[num_expected].e);
+				}
+				continue;
+			}
+			expected[num_expected].id = id;
+			expected[num_expected].e = e;
+			num_expected++;
+		} else if (op < 63 && num_expected) {
+			if (imd_entry_remove(&imd,
+					expected[num_expected - 1].e)) {
+				fprintf(stderr, "%s: remove failed\n", what);
+				errors++;
+			}
+			num_expected--;
+		} else {
+			struct imd recovered;
+
+			imd_handle_init(&recovered, upper_limit());
+			if (imd_recover(&recovered)) {
+				fprintf(stderr, "%s: recovery failed\n", what);
+				return errors + 1;
+			}
+			imd = recovered;
+		}
+
+		errors += check_all(&imd, what);
+		if (errors > 10)
+			break;
+	}
+
+	return errors;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Returns ns per lookup of ids with the imd as set up. */
+static double bench_find(const struct imd *imd, const uint32_t *ids,
+			 int num_ids)
+{
+	size_t lookups = 0;
+	double start = now();
+	double elapsed;
+	int found = 0;
+
+	do {
+		int i;
+
+		for (i = 0; i < num_ids; i++)
+			found += imd_entry_find(imd, ids[i]) != NULL;
+		lookups += num_ids;
+		elapsed = now() - start;
+	} while (elapsed < 0.2);
+
+	/* Keep the lookups from being optimized away. */
+	if (found < 0)
+		printf("%d\n", found);
+
+	return elapsed * 1e9 / lookups;
+}
+
+static void bench(void)
+{
+	static const int counts[] = { 8, 16, 32, 64, 128, 200 };
+	uint32_t present[MAX_IDS], missing[MAX_IDS];
+	size_t i;
+	int j;
+
+	printf("\n%8s %14s %14s %14s %14s\n", "entries", "linear hit",
+	       "index hit", "linear miss", "index miss");
+
+	for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+		double ns[2][2];
+		int hash_index;
+
+		for (hash_index = 0; hash_index < 2; hash_index++) {
+			struct imd imd;
+
+			create(&imd, hash_index);
+			srand(2);
+			for (j = 0; j < counts[i]; j++) {
+				do {
+					present[j] = random_id();
+				} while (imd_entry_find(&imd, present[j]));
+				imd_entry_add(&imd, present[j], 16);
+				missing[j] = present[j] ^ 0x80808080;
+			}
+
+			ns[hash_index][0] = bench_find(&imd, present,
+						       counts[i]);
+			ns[hash_index][1] = bench_find(&imd, missing,
+						       counts[i]);
+		}
+
+		printf("%8d %11.1f ns %11.1f ns %11.1f ns %11.1f ns\n",
+		       counts[i], ns[0][0], ns[1][0], ns[0][1], ns[1][1]);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int errors;
+
+	region = aligned_alloc(4096, REGION_SIZE);
+	if (!region)
+		return 1;
+
+	errors = check(0, 0) + check(1, 0) + check(1, 1);
+	if (errors) {
+		fprintf(stderr, "%d errors\n", errors);
+		return 1;
+	}
+	printf("All checks passed.\n");
+
+	if (argc > 1 && !strcmp(argv[1], "-c"))
+		return 0;
+
+	bench();
+
+	return 0;
+}
@@ -0,0 +1,11 @@
+/* Just enough of <cbmem.h> to build src/lib/imd.c on the host. */
+#ifndef CBMEM_H
+#define CBMEM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <commonlib/cbmem_id.h>
+#include <commonlib/helpers.h>
+
+#endif
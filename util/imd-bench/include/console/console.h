@@ -0,0 +1,8 @@
+/* The benchmark doesn't want the imd debug output. */
+#ifndef CONSOLE_CONSOLE_H
+#define CONSOLE_CONSOLE_H
+
+#define BIOS_DEBUG 7
+#define printk(level, ...) do { } while (0)
+
+#endif
@@ -0,0 +1 @@
+#include "../../../src/include/imd.h"
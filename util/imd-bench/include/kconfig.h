@@ -0,0 +1,12 @@
+/*
+ * The index is a run time choice here so one binary can compare both
+ * ways of looking up entries.
+ */
+#ifndef KCONFIG_H
+#define KCONFIG_H
+
+#define IS_ENABLED(option) (option)
+#define CONFIG_IMD_HASH_INDEX imd_bench_hash_index
+extern int imd_bench_hash_index;
+
+#endif
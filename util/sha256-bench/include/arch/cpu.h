@@ -0,0 +1,43 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* Host stand-in for the x86 CPUID helpers. */
+
+#ifndef ARCH_CPU_H
+#define ARCH_CPU_H
+
+#include <cpuid.h>
+
+struct cpuid_result {
+	unsigned int eax, ebx, ecx, edx;
+};
+
+static inline struct cpuid_result cpuid_ext(int op, unsigned int ecx)
+{
+	struct cpuid_result r;
+
+	__cpuid_count(op, ecx, r.eax, r.ebx, r.ecx, r.edx);
+	return r;
+}
+
+static inline unsigned int cpuid_eax(unsigned int op)
+{
+	return cpuid_ext(op, 0).eax;
+}
+
+static inline unsigned int cpuid_ecx(unsigned int op)
+{
+	return cpuid_ext(op, 0).ecx;
+}
+
+#endif
@@ -0,0 +1,26 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* Host stand-in: user space can't read CR4, but the OS has enabled SSE. */
+
+#ifndef CPU_X86_CR_H
+#define CPU_X86_CR_H
+
+#define CR4_OSFXSR	(1 << 9)
+
+static inline unsigned long read_cr4(void)
+{
+	return CR4_OSFXSR;
+}
+
+#endif
@@ -0,0 +1,31 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* Host stand-in for src/include/rules.h, only the architecture helpers. */
+
+#ifndef RULES_H
+#define RULES_H
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ENV_X86 1
+#else
+#define ENV_X86 0
+#endif
+
+#if defined(__aarch64__)
+#define ENV_ARM64 1
+#else
+#define ENV_ARM64 0
+#endif
+
+#endif
@@ -0,0 +1,277 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sha256_backend.h>
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+static const uint32_t k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+/* Plain C compression function, the reference for the backends. */
+static void c_transform(uint32_t state[8], const uint8_t *data,
+			size_t num_blocks)
+{
+	for (; num_blocks; num_blocks--, data += SHA256_BLOCK_SIZE) {
+		uint32_t w[64], s[8];
+		int i;
+
+		for (i = 0; i < 16; i++)
+			w[i] = (uint32_t)data[4 * i] << 24 |
+				data[4 * i + 1] << 16 |
+				data[4 * i + 2] << 8 | data[4 * i + 3];
+		for (; i < 64; i++) {
+			uint32_t s0 = ROR(w[i - 15], 7) ^ ROR(w[i - 15], 18) ^
+				(w[i - 15] >> 3);
+			uint32_t s1 = ROR(w[i - 2], 17) ^ ROR(w[i - 2], 19) ^
+				(w[i - 2] >> 10);
+			w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+		}
+
+		memcpy(s, state, sizeof(s));
+		for (i = 0; i < 64; i++) {
+			uint32_t s1 = ROR(s[4], 6) ^ ROR(s[4], 11) ^
+				ROR(s[4], 25);
+			uint32_t ch = (s[4] & s[5]) ^ (~s[4] & s[6]);
+			uint32_t t1 = s[7] + s1 + ch + k[i] + w[i];
+			uint32_t s0 = ROR(s[0], 2) ^ ROR(s[0], 13) ^
+				ROR(s[0], 22);
+			uint32_t maj = (s[0] & s[1]) ^ (s[0] & s[2]) ^
+				(s[1] & s[2]);
+
+			memmove(&s[1], &s[0], 7 * sizeof(s[0]));
+			s[4] += t1;
+			s[0] = t1 + s0 + maj;
+		}
+
+		for (i = 0; i < 8; i++)
+			state[i] += s[i];
+	}
+}
+
+static const struct sha256_backend c_backend = {
+	.name = "C reference",
+	.transform = c_transform,
+};
+
+/* Lets the generic code in src/lib run with any backend. */
+static const struct sha256_backend *forced_backend;
+
+const struct sha256_backend *soc_sha256_backend(void)
+{
+	return forced_backend;
+}
+
+/* FIPS 180-2 examples plus the padding corner cases. */
+static const struct {
+	const char *msg;
+	size_t repeat;
+	const char *digest;
+} kat[] = {
+	{ "", 1,
+	  "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+	{ "abc", 1,
+	  "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+	{ "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+	  "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+	{ "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+	  "hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu", 1,
+	  "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1" },
+	{ "a", 1000000,
+	  "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" },
+	/* 55 bytes fit the length into the same block, 56 don't. */
+	{ "a", 55,
+	  "9f4390f8d30c2dd92ec9f095b65e2b9ae9b0a925a5258e241c9f1e910f734318" },
+	{ "a", 56,
+	  "b35439a4ac6f0948b6d6f9e3c6af0f5f590ce20f1bde7090ef7970686ec6738a" },
+	{ "a", 64,
+	  "ffe054fe7ae0cb6dc65c3af9b61d5209f439851db43d0ba5997337df154668eb" },
+};
+
+static void to_hex(const uint8_t *digest, char *hex)
+{
+	int i;
+
+	for (i = 0; i < SHA256_DIGEST_SIZE; i++)
+		sprintf(hex + 2 * i, "%02x", digest[i]);
+}
+
+static int run_kat(void)
+{
+	uint8_t digest[SHA256_DIGEST_SIZE];
+	char hex[2 * SHA256_DIGEST_SIZE + 1];
+	struct sha256_ctx ctx;
+	size_t i, j;
+	int failed = 0;
+
+	for (i = 0; i < ARRAY_SIZE(kat); i++) {
+		sha256_init(&ctx);
+		for (j = 0; j < kat[i].repeat; j++)
+			sha256_update(&ctx, kat[i].msg, strlen(kat[i].msg));
+		sha256_final(&ctx, digest);
+
+		to_hex(digest, hex);
+		if (strcmp(hex, kat[i].digest)) {
+			printf("  KAT %zu: got %s\n", i, hex);
+			failed = 1;
+		}
+	}
+
+	return failed;
+}
+
+/* Random lengths fed in random pieces, compared against the C reference. */
+static int run_random(void)
+{
+	static uint8_t buf[4096];
+	uint8_t ref[SHA256_DIGEST_SIZE], digest[SHA256_DIGEST_SIZE];
+	const struct sha256_backend *backend = forced_backend;
+	struct sha256_ctx ctx;
+	int i;
+
+	for (i = 0; i < 2000; i++) {
+		size_t len = rand() % sizeof(buf);
+		size_t off, n;
+
+		for (off = 0; off < len; off++)
+			buf[off] = rand();
+
+		forced_backend = &c_backend;
+		sha256_init(&ctx);
+		sha256_update(&ctx, buf, len);
+		sha256_final(&ctx, ref);
+
+		forced_backend = backend;
+		sha256_init(&ctx);
+		for (off = 0; off < len; off += n) {
+			n = rand() % 200;
+			if (n > len - off)
+				n = len - off;
+			sha256_update(&ctx, buf + off, n);
+		}
+		sha256_final(&ctx, digest);
+
+		if (memcmp(ref, digest, sizeof(ref))) {
+			printf("  mismatch for %zu bytes\n", len);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench(void)
+{
+	const size_t size = 1024 * 1024;
+	uint8_t digest[SHA256_DIGEST_SIZE];
+	struct sha256_ctx ctx;
+	uint8_t *buf = calloc(1, size);
+	double start, elapsed;
+	int rounds = 0;
+
+	start = now();
+	do {
+		sha256_init(&ctx);
+		sha256_update(&ctx, buf, size);
+		sha256_final(&ctx, digest);
+		rounds++;
+		elapsed = now() - start;
+	} while (elapsed < 0.5);
+
+	printf("  %.1f MiB/s\n", rounds / elapsed);
+	free(buf);
+}
+
+int main(int argc, char **argv)
+{
+	const struct sha256_backend *backends[] = {
+		&c_backend,
+#if defined(__x86_64__) || defined(__i386__)
+		&sha256_x86_shani_backend,
+#endif
+#if defined(__aarch64__)
+		&sha256_armv8_ce_backend,
+#endif
+	};
+	int check_only = 0;
+	int failed = 0;
+	size_t i;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "c")) != -1) {
+		switch (opt) {
+		case 'c':
+			check_only = 1;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-c]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	for (i = 0; i < ARRAY_SIZE(backends); i++) {
+		const struct sha256_backend *backend = backends[i];
+
+		printf("%s:\n", backend->name);
+		if (backend->probe && !backend->probe()) {
+			printf("  not supported by this CPU\n");
+			continue;
+		}
+
+		forced_backend = backend;
+
+		if (run_kat() || run_random()) {
+			printf("  FAILED\n");
+			failed = 1;
+			continue;
+		}
+		printf("  known answers and random inputs OK\n");
+
+		if (!check_only)
+			bench();
+	}
+
+	return failed;
+}
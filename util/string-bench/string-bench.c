@@ -0,0 +1,239 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+/* The functions under test, built from src/lib with renamed symbols. */
+void *lib_memcpy(void *dest, const void *src, size_t n);
+void *lib_memset(void *s, int c, size_t n);
+void *lib_memmove(void *dest, const void *src, size_t n);
+
+/* The byte loops src/lib used to have, for reference. */
+static void *byte_memcpy(void *vdest, const void *vsrc, size_t bytes)
+{
+	const char *src = vsrc;
+	char *dest = vdest;
+	size_t i;
+
+	for (i = 0; i < bytes; i++)
+		dest[i] = src[i];
+
+	return vdest;
+}
+
+static void *byte_memset(void *s, int c, size_t n)
+{
+	char *ss = s;
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		ss[i] = c;
+
+	return s;
+}
+
+static void *byte_memmove(void *vdest, const void *vsrc, size_t count)
+{
+	const char *src = vsrc;
+	char *dest = vdest;
+
+	if (dest <= src) {
+		while (count--)
+			*dest++ = *src++;
+	} else {
+		src += count - 1;
+		dest += count - 1;
+		while (count--)
+			*dest-- = *src--;
+	}
+	return vdest;
+}
+
+#define MAX_ALIGN	16
+#define MAX_SIZE	300
+#define GUARD		32
+#define BUF_SIZE	(MAX_SIZE + 2 * MAX_ALIGN + 2 * GUARD)
+
+static unsigned char buf_a[BUF_SIZE] __attribute__((aligned(64)));
+static unsigned char buf_b[BUF_SIZE] __attribute__((aligned(64)));
+static unsigned char ref_a[BUF_SIZE] __attribute__((aligned(64)));
+static unsigned char ref_b[BUF_SIZE] __attribute__((aligned(64)));
+
+static void fill(void)
+{
+	size_t i;
+
+	for (i = 0; i < BUF_SIZE; i++) {
+		buf_a[i] = ref_a[i] = i * 7 + 1;
+		buf_b[i] = ref_b[i] = i * 13 + 5;
+	}
+}
+
+static int compare(const char *what, size_t d, size_t s, size_t n)
+{
+	if (!memcmp(buf_a, ref_a, BUF_SIZE) && !memcmp(buf_b, ref_b, BUF_SIZE))
+		return 0;
+
+	fprintf(stderr, "%s mismatch: dest offset %zu, src offset %zu, "
+		"size %zu\n", what, d, s, n);
+	return 1;
+}
+
+static int check(void)
+{
+	int errors = 0;
+	size_t d, s, n;
+
+	for (d = 0; d < MAX_ALIGN; d++) {
+		for (n = 0; n <= MAX_SIZE; n++) {
+			void *ret;
+
+			fill();
+			ret = lib_memset(buf_a + GUARD + d, 0xa5 + n, n);
+			byte_memset(ref_a + GUARD + d, 0xa5 + n, n);
+			errors += compare("memset", d, 0, n);
+			errors += ret != buf_a + GUARD + d;
+
+			for (s = 0; s < MAX_ALIGN; s++) {
+				fill();
+				ret = lib_memcpy(buf_a + GUARD + d,
+						 buf_b + GUARD + s, n);
+				byte_memcpy(ref_a + GUARD + d,
+					    ref_b + GUARD + s, n);
+				errors += compare("memcpy", d, s, n);
+				errors += ret != buf_a + GUARD + d;
+
+				/* Overlapping moves within one buffer, in
+				 * both directions. */
+				fill();
+				ret = lib_memmove(buf_a + GUARD + d,
+						  buf_a + GUARD + s, n);
+				byte_memmove(ref_a + GUARD + d,
+					     ref_a + GUARD + s, n);
+				errors += compare("memmove", d, s, n);
+				errors += ret != buf_a + GUARD + d;
+			}
+		}
+	}
+
+	return errors;
+}
+
+typedef void *(*copy_fn)(void *, const void *, size_t);
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Returns MiB/s for moving size bytes from src to dest with fn. */
+static double bench_copy(copy_fn fn, unsigned char *dest,
+			 const unsigned char *src, size_t size)
+{
+	size_t total = 0;
+	double start = now();
+	double elapsed;
+
+	do {
+		size_t i;
+
+		for (i = 0; i < 16; i++)
+			fn(dest, src, size);
+		total += 16 * size;
+		elapsed = now() - start;
+	} while (elapsed < 0.2);
+
+	return total / elapsed / (1024 * 1024);
+}
+
+static void *memset_as_copy_lib(void *dest, const void *src, size_t n)
+{
+	return lib_memset(dest, 0x5a, n);
+}
+
+static void *memset_as_copy_byte(void *dest, const void *src, size_t n)
+{
+	return byte_memset(dest, 0x5a, n);
+}
+
+static void bench(void)
+{
+	static const size_t sizes[] = { 16, 256, 4096, 65536, 1024 * 1024 };
+	static const struct {
+		const char *name;
+		copy_fn lib;
+		copy_fn byte;
+		size_t dest_off;
+		size_t src_off;
+	} tests[] = {
+		{ "memcpy", lib_memcpy, byte_memcpy, 0, 0 },
+		{ "memcpy (misaligned)", lib_memcpy, byte_memcpy, 1, 3 },
+		{ "memmove (forward)", lib_memmove, byte_memmove, 0, 64 },
+		{ "memmove (backward)", lib_memmove, byte_memmove, 64, 0 },
+		{ "memset", memset_as_copy_lib, memset_as_copy_byte, 0, 0 },
+	};
+	size_t max = sizes[ARRAY_SIZE(sizes) - 1];
+	unsigned char *mem = malloc(2 * max + 256);
+	size_t i, j;
+
+	if (!mem) {
+		fprintf(stderr, "Out of memory\n");
+		return;
+	}
+	memset(mem, 0x11, 2 * max + 256);
+
+	printf("%-20s %8s %12s %12s\n", "test", "size", "lib MiB/s",
+	       "byte MiB/s");
+	for (i = 0; i < ARRAY_SIZE(tests); i++) {
+		for (j = 0; j < ARRAY_SIZE(sizes); j++) {
+			unsigned char *dest = mem + tests[i].dest_off;
+			unsigned char *src = mem + tests[i].src_off;
+
+			/* Copies that don't overlap use separate halves. */
+			if (tests[i].lib == lib_memcpy)
+				src += max + 128;
+
+			printf("%-20s %8zu %12.0f %12.0f\n", tests[i].name,
+			       sizes[j],
+			       bench_copy(tests[i].lib, dest, src, sizes[j]),
+			       bench_copy(tests[i].byte, dest, src, sizes[j]));
+		}
+	}
+
+	free(mem);
+}
+
+int main(int argc, char **argv)
+{
+	int errors = check();
+
+	if (errors) {
+		fprintf(stderr, "%d errors\n", errors);
+		return 1;
+	}
+	printf("All checks passed.\n");
+
+	if (argc > 1 && !strcmp(argv[1], "-c"))
+		return 0;
+
+	bench();
+	return 0;
+}